@@ -0,0 +1,309 @@
+/*************************************************************************
+                        2D-Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+Description: Ensemble runner. The variants of a case (e.g. a sweep over
+             the viscosity or the bulk modulus) are advanced in one
+             process: the input files are read once, and each variant is
+             a Simulation of its own, run on one thread of a pool (the
+             variants are dealt to the threads as they become free).
+             The ensemble file lists the variants as material.dat lists
+             the materials:
+               numOfVariants
+               name numOfParameters
+                   parameter value
+                   ...
+             A parameter replaces the parameter of input.dat (e.g. dt,
+             numOfSteps) or of material.dat (e.g. viscosity, applied to
+             every material) of the same name. The results of a variant
+             are written to Results/<name>/ every numOfSubStep steps, as
+             incompressibleMPM does, and a summary of the variants is
+             printed at the end.
+
+             Usage: ./ensembleRunner caseDirectory ensembleFile
+                        [--threads=N] [--steps=N] [--lanes]
+             --threads sets the number of variants run at the same time
+             (default: OMP_NUM_THREADS); each variant runs on one thread.
+             --steps overrides numOfSteps of all variants.
+             --lanes advances the variants in groups of
+             LaneEnsemble::width, one pass over the particles and nodes
+             for all variants of a group (see LaneEnsemble.hpp); the
+             groups are dealt to the threads. The variants need the same
+             dt and number of steps, and a case which the lanes support.
+             With steadyStateTolerance a variant stops early.
+             With quasiStaticFlag the variants run in load steps, and the
+             results are written after each load step.
+**************************************************************************/
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// header files
+#include "FileHandle.hpp"
+#include "PropertyParse.hpp"
+#include "Verify.hpp"
+#include "Simulation.hpp"
+#include "LaneEnsemble.hpp"
+
+namespace {
+
+// a variant of the case: its settings and the parameters which replace
+// those of material.dat
+struct Variant {
+    std::string name;
+    mpm::misc::Settings settings;
+    mpm::misc::PropertyList overrides;
+    // results
+    unsigned steps;
+    unsigned particles;
+    double wallTime;
+};
+
+
+// READ THE VARIANTS
+//! each parameter line is parsed as a line of input.dat and as a line of
+//! material.dat (the names of the two files do not overlap)
+std::vector<Variant> read_variants(std::ifstream& ensembleFile, const mpm::misc::Settings& settings) {
+    std::vector<Variant> variants;
+    std::string line;
+    unsigned numOfVariants, numOfParameters;
+    if (!std::getline(ensembleFile, line)) {
+        std::cerr << "ERROR: in reading the ensemble file" << "\n";
+        abort();
+    }
+    std::istringstream in(line);
+    in >> numOfVariants;
+
+    for (unsigned i = 0; i < numOfVariants; i++) {
+        Variant variant;
+        variant.settings = settings;
+        if (!std::getline(ensembleFile, line)) {
+            std::cerr << "ERROR: the ensemble file has less than " << numOfVariants << " variants" << "\n";
+            abort();
+        }
+        std::istringstream inVariant(line);
+        inVariant >> variant.name >> numOfParameters;
+        for (unsigned j = 0; j < numOfParameters; j++) {
+            std::getline(ensembleFile, line);
+            mpm::misc::PARSE_PROPERTIES(line, variant.settings);
+            mpm::misc::READ_PROPERTIES(line, variant.overrides);
+        }
+        variants.push_back(variant);
+    }
+    return variants;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: RUN_VARIANT
+          Runs on one thread of the pool: the simulation is built, run and
+          destroyed there, so its memory is first touched by that thread.
+          The loops of the solver see a team of one thread.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void run_variant(const mpm::CaseInput& input, Variant& variant, const std::string& directory) {
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const mpm::misc::Settings& settings = variant.settings;
+    mpm::Simulation simulation(input, settings, variant.overrides);
+
+    // quasi-static: the output of each load step
+    if (settings.quasiStatic) {
+        mpm::FileHandle::WriteData(directory, 0, simulation.particles());
+        for (unsigned l = 1; l <= settings.numOfLoadSteps; l++) {
+            simulation.solve_load_step();
+            mpm::FileHandle::WriteData(directory, l, simulation.particles());
+        }
+    }
+
+    const unsigned totalSteps = settings.quasiStatic ? 0 : settings.numOfTotalSteps;
+    const unsigned subSteps = settings.numOfSubSteps;
+    unsigned writeSteps = 0;
+    for (unsigned i = 0; i < totalSteps; i++) {
+        if (i == writeSteps * subSteps) {
+            mpm::FileHandle::WriteData(directory, i, simulation.particles());
+            writeSteps++;
+        }
+        simulation.solve_one_step();
+        // a steady variant stops with the output of its last step
+        if (simulation.steady()) {
+            mpm::FileHandle::WriteData(directory, simulation.step(), simulation.particles());
+            break;
+        }
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    variant.steps = simulation.step();
+    variant.particles = simulation.particles()->number_of_particles();
+    variant.wallTime = std::chrono::duration<double>(end - begin).count();
+}
+
+
+
+//! FUNCTION: RUN_LANES
+//!           Runs a group of variants in the lanes on one thread of the
+//!           pool, with the output of run_variant. The wall time of each
+//!           variant is that of the group.
+//!
+void run_lanes(const mpm::CaseInput& input, std::vector<Variant*> group, const std::vector<std::string>& directories) {
+#ifdef _OPENMP
+    omp_set_num_threads(1);
+#endif
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::vector<mpm::misc::Settings> settings;
+    std::vector<mpm::misc::PropertyList> overrides;
+    for (auto variant : group) {
+        settings.push_back(variant->settings);
+        overrides.push_back(variant->overrides);
+    }
+    mpm::LaneEnsemble lanes(input, settings, overrides);
+
+    const unsigned totalSteps = settings[0].numOfTotalSteps;
+    const unsigned subSteps = settings[0].numOfSubSteps;
+    unsigned writeSteps = 0;
+    for (unsigned i = 0; i < totalSteps; i++) {
+        if (i == writeSteps * subSteps) {
+            lanes.write_variants();
+            for (unsigned v = 0; v < group.size(); v++)
+                mpm::FileHandle::WriteData(directories[v], i, lanes.simulation(v).particles());
+            writeSteps++;
+        }
+        lanes.solve_one_step();
+    }
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    for (auto variant : group) {
+        variant->steps = lanes.step();
+        variant->particles = lanes.number_of_particles();
+        variant->wallTime = std::chrono::duration<double>(end - begin).count();
+    }
+}
+
+
+//! FUNCTION: CHECK_LANES
+//!           Aborts unless all variants can run in the lanes together.
+//!
+void check_lanes(const std::vector<Variant>& variants) {
+    for (const auto& variant : variants) {
+        const std::string reason = mpm::LaneEnsemble::unsupported(variant.settings);
+        if (!reason.empty()) {
+            std::cerr << "ERROR: variant " << variant.name << " uses " << reason << ", which --lanes does not support" << "\n";
+            abort();
+        }
+        const mpm::misc::Settings& first = variants.front().settings;
+        if (variant.settings.dt != first.dt || variant.settings.numOfTotalSteps != first.numOfTotalSteps || variant.settings.numOfSubSteps != first.numOfSubSteps) {
+            std::cerr << "ERROR: with --lanes the variants need the same dt, numOfSteps and numOfSubSteps (variant " << variant.name << ")" << "\n";
+            abort();
+        }
+    }
+}
+
+}
+
+
+int main (int argc, char* argv[]) {
+
+    if (argc < 3) {
+        std::cerr << "ERROR: usage: ./ensembleRunner caseDirectory ensembleFile [--threads=N] [--steps=N] [--lanes]" << "\n";
+        return 1;
+    }
+    unsigned numOfThreads = 0;
+    int steps = -1;
+    bool inLanes = false;
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        std::string value = arg.substr(arg.find('=') + 1);
+        if (arg.find("--threads=") == 0)
+            numOfThreads = std::stoul(value);
+        else if (arg.find("--steps=") == 0)
+            steps = std::stoi(value);
+        else if (arg == "--lanes")
+            inLanes = true;
+        else {
+            std::cerr << "ERROR: unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+
+    boost::filesystem::path p(argv[1]);
+    std::string ensembleName(argv[2]);
+    std::ifstream ensembleFile(ensembleName.c_str());
+    mpm::misc::VERIFY_OPEN(ensembleFile, ensembleName);
+
+    // the input files are read once and shared by all variants
+    mpm::FileHandle fileHandle_(p);
+    const mpm::CaseInput input_(fileHandle_);
+
+    std::vector<Variant> variants = read_variants(ensembleFile, input_.settings);
+    std::vector<std::string> directories;
+    for (auto& variant : variants) {
+        if (steps >= 0)
+            variant.settings.numOfTotalSteps = steps;
+        directories.push_back(fileHandle_.ResultsDir + "/" + variant.name);
+        boost::filesystem::create_directories(directories.back());
+    }
+
+#ifdef _OPENMP
+    if (!numOfThreads)
+        numOfThreads = omp_get_max_threads();
+#endif
+    if (!numOfThreads)
+        numOfThreads = 1;
+    std::cout << " " << variants.size() << " variants on " << numOfThreads << " threads";
+    if (inLanes)
+        std::cout << " in groups of " << mpm::LaneEnsemble::width << " lanes";
+    std::cout << " \n \n";
+
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    if (inLanes) {
+        check_lanes(variants);
+        const unsigned width = mpm::LaneEnsemble::width;
+        const unsigned numOfGroups = (variants.size() + width - 1) / width;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numOfThreads)
+#endif
+        for (unsigned g = 0; g < numOfGroups; g++) {
+            std::vector<Variant*> group;
+            std::vector<std::string> groupDirectories;
+            for (unsigned i = g * width; i < std::min<unsigned>(variants.size(), (g + 1) * width); i++) {
+                group.push_back(&variants[i]);
+                groupDirectories.push_back(directories[i]);
+            }
+            run_lanes(input_, group, groupDirectories);
+        }
+    }
+    else {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numOfThreads)
+#endif
+        for (unsigned i = 0; i < variants.size(); i++)
+            run_variant(input_, variants[i], directories[i]);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double wallTime = std::chrono::duration<double>(end - begin).count();
+
+    std::cout << std::left << std::setw(20) << "variant" << std::setw(10) << "steps" << std::setw(11) << "particles";
+    std::cout << std::setw(12) << "wall(s)" << "updates/s" << std::right << "\n";
+    double updates = 0.;
+    for (const auto& variant : variants) {
+        double variantUpdates = double(variant.particles) * variant.steps;
+        updates += variantUpdates;
+        std::cout << std::left << std::setw(20) << variant.name << std::setw(10) << variant.steps << std::setw(11) << variant.particles;
+        std::cout << std::setw(12) << variant.wallTime << (variant.wallTime > 0. ? variantUpdates / variant.wallTime : 0.) << std::right << "\n";
+    }
+    std::cout << "\n ensemble: " << wallTime << " s, " << (wallTime > 0. ? updates / wallTime : 0.) << " particle updates/s \n";
+    return 0;
+}
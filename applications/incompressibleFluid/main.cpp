@@ -19,15 +19,23 @@ Description: This file contains the incompressible fluid flow solver based on
 #include <fstream>
 #include <sstream>
 #include <functional>
+#include <chrono>
 
 // header files
 #include "FileHandle.hpp"
 #include "PropertyParse.hpp"
+#include "Timer.hpp"
 #include "Mesh.hpp"
 #include "MpmParticle.hpp"
 #include "Element.hpp"
 #include "Node.hpp"
 #include "Particle.hpp"
+#include "MpmSolver.hpp"
+#include "Simulation.hpp"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 int main (int argc, char* argv[]) {
@@ -51,61 +59,122 @@ int main (int argc, char* argv[]) {
 
 
     mpm::FileHandle fileHandle_(p);
-    mpm::Mesh* mesh_ = fileHandle_.read_mesh();
-    mesh_->iterate_over_elements(std::bind(&mpm::Element::compute_centre_coordinates, std::placeholders::_1));
+    mpm::CaseInput input_(fileHandle_);
+    const mpm::misc::Settings& settings_ = input_.settings;
+
+    unsigned TotalSteps = settings_.numOfTotalSteps;
+    unsigned subSteps = settings_.numOfSubSteps;
+
+#ifdef _OPENMP
+    if (settings_.numOfThreads)
+        omp_set_num_threads(settings_.numOfThreads);
+#endif
+
+    // the mesh, particles, materials, phase timer and solver of the case
+    mpm::Simulation simulation_(input_);
+    mpm::MpmParticle* particles_ = simulation_.particles();
+    mpm::ParticleSource* sources_ = simulation_.sources();
+    mpm::misc::PhaseTimer& timer_ = simulation_.timer();
+    std::cout << " Read All InputFiles" << "\n \n";
 
-    mpm::MpmParticle* particles_ = fileHandle_.read_particles();
+#ifdef _OPENMP
+    std::cout << " Number of threads: " << omp_get_max_threads() << "\n \n";
+#endif
+
+    std::chrono::steady_clock::time_point lastWrite = std::chrono::steady_clock::now();
+    unsigned lastWriteStep = 0;
+    const mpm::ArtificialCompressibility& compressibility_ = simulation_.artificial_compressibility();
+
+    if (settings_.quasiStatic) {
+        // quasi-static: load steps instead of time steps, with the output
+        // of each load step
+        const mpm::QuasiStatic& quasiStatic_ = simulation_.quasi_static();
+        const unsigned loadSteps = settings_.numOfLoadSteps;
+        { mpm::misc::ScopedTimer t(timer_, "WriteData");
+          fileHandle_.WriteData(0, particles_); }
+        for (unsigned k = 1; k <= loadSteps; k++) {
+            const bool converged = simulation_.solve_load_step();
+            std::cout << "\nLoad step: " << k << "/" << loadSteps << "\t iterations: " << quasiStatic_.number_of_iterations();
+            std::cout << "\t residual: " << quasiStatic_.residual() << "\t kinetic/strain energy: " << quasiStatic_.energy_ratio();
+            if (!converged)
+                std::cout << "\t not converged";
+            std::cout << "\n";
+            mpm::misc::ScopedTimer t(timer_, "WriteData");
+            fileHandle_.WriteData(k, particles_);
+        }
+        std::cout << "\n Quasi-static: " << simulation_.step() << " iterations";
+        if (settings_.massScaling > 1.)
+            std::cout << ", largest mass scale " << quasiStatic_.mass_scale();
+        std::cout << "\n";
+    }
+    else {
+        unsigned writeSteps = 0;
+        for (unsigned i = 0; i < TotalSteps; i++) {
+            if ( i == writeSteps * subSteps) {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                double seconds = std::chrono::duration<double>(now - lastWrite).count();
+                std::cout << "\nStep: " << i << "/" << TotalSteps;
+                if (i > lastWriteStep && seconds > 0.)
+                    std::cout << "\t particle updates/s: " << (double(particles_->number_of_particles()) * (i - lastWriteStep) / seconds);
+                if (compressibility_.enabled())
+                    std::cout << "\t time: " << simulation_.time() << "\t dt: " << simulation_.settings().dt << "\t Mach: " << compressibility_.mach_number();
+                std::cout << "\n";
+                lastWrite = now;
+                lastWriteStep = i;
+
+                mpm::misc::ScopedTimer t(timer_, "WriteData");
+                fileHandle_.WriteData(i, particles_);
+                writeSteps++;
+            } 
+
+            simulation_.solve_one_step();
+
+            // a steady run stops with the output of its last step
+            if (simulation_.steady()) {
+                std::cout << "\nSteady state at step " << simulation_.step() << "/" << TotalSteps << "\n";
+                mpm::misc::ScopedTimer t(timer_, "WriteData");
+                fileHandle_.WriteData(simulation_.step(), particles_);
+                break;
+            }
+        }
+    }
 
-    double dt_ = mpm::misc::dt;
-    unsigned TotalSteps = mpm::misc::numOfTotalSteps;
-    unsigned subSteps = mpm::misc::numOfSubSteps;
-    std::cout << " Read All InputFiles" << "\n \n";
+    if (compressibility_.enabled()) {
+        std::cout << "\n Artificial compressibility: flow speed " << compressibility_.flow_speed() << ", speed of sound " << compressibility_.sound_speed();
+        std::cout << " (raised " << compressibility_.number_of_changes() << " times), dt " << simulation_.settings().dt << ", time " << simulation_.time() << "\n";
+        std::cout << " Density variation: largest " << compressibility_.max_density_variation() << ", last step " << compressibility_.density_variation();
+        std::cout << " (expected machNumber^2 = " << compressibility_.expected_density_variation() << ")\n";
+    }
 
-    unsigned writeSteps = 0;
-    for (unsigned i = 0; i < TotalSteps; i++) {
-        mesh_->initialise_mesh();
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::initialise_particle, std::placeholders::_1));
-
-        if ( i == writeSteps * subSteps) {
-            std::cout << "\nStep: " << i << "/" << TotalSteps << "\n";
-            fileHandle_.WriteData(i, particles_);
-            writeSteps++;
-        } 
-
-        mesh_->locate_particles_in_mesh(particles_);
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_local_coordinates, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_shape_functions, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions_at_centre, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_matrix, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix_at_centre, std::placeholders::_1));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_mass_to_nodes, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_momentum_to_nodes, std::placeholders::_1));
-        mesh_->iterate_over_nodes_of_p(std::bind(&mpm::Node::compute_nodal_velocity_from_momentum, std::placeholders::_1));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::assign_body_force_to_nodes, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::assign_internal_force_to_nodes, std::placeholders::_1));
-        mesh_->iterate_over_nodes_of_p(std::bind(&mpm::Node::solve_acceleration_and_velocity, std::placeholders::_1, dt_));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_strain_rate, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_strain_rate, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_strain_rate, std::placeholders::_1));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_volume_to_nodes, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_volumetric_strain_rate_to_nodes, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_vol_strain_rate_from_nodes, std::placeholders::_1));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_strain, std::placeholders::_1));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_stress, std::placeholders::_1));
-
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::update_velocity, std::placeholders::_1, dt_));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::update_position, std::placeholders::_1, dt_));
-        particles_->iterate_over_particles(std::bind(&mpm::Particle::update_density, std::placeholders::_1));
+    const mpm::MultiRate& multiRate_ = simulation_.multi_rate();
+    if (multiRate_.enabled()) {
+        std::cout << "\n Multi-rate: up to " << multiRate_.max_levels_used() << " levels in a step; particles per level in the last step:";
+        for (unsigned l = 0; l < multiRate_.number_of_levels(); l++)
+            std::cout << " " << multiRate_.number_of_particles(l);
+        std::cout << "\n Particle updates " << multiRate_.particle_updates() << " (single-rate " << multiRate_.single_rate_updates();
+        std::cout << "), particles located " << multiRate_.particle_locations() << " and nodes solved " << multiRate_.node_solves();
+        std::cout << " (as many single-rate), work saved " << 100. * multiRate_.work_saved() << "%\n";
     }
-    delete mesh_;
-    delete particles_;
+
+    const mpm::SteadyState& steady_ = simulation_.steady_state();
+    if (steady_.enabled()) {
+        if (!steady_.converged())
+            std::cout << "\n Steady state not reached in " << simulation_.step() << " steps";
+        std::cout << "\n Change across the last window of " << settings_.steadyStateWindow << " steps: nodal velocity " << steady_.velocity_change();
+        std::cout << ", kinetic energy " << steady_.energy_change() << " (tolerance " << settings_.steadyStateTolerance << ")\n";
+    }
+
+    if (!sources_->empty()) {
+        std::cout << "\n Particles inserted: " << sources_->number_of_inserted_particles();
+        std::cout << ", removed at sinks: " << sources_->number_of_removed_particles() << "\n";
+    }
+    if (timer_.is_enabled())
+        timer_.write_summary(std::cout);
+    if (timer_.is_tracing())
+        fileHandle_.WriteTrace(timer_);
+    if (settings_.taskGraph)
+        fileHandle_.WriteTaskGraph(simulation_.solver().task_graph());
+
     return 0;
 }
 
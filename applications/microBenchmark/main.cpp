@@ -0,0 +1,473 @@
+/*************************************************************************
+                        2D-Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+Description: Microbenchmarks of the particle, node, mesh and material
+             kernels on synthetic particle clouds. A cloud of N particles
+             with "ppc" particles per cell is placed on a square block of
+             elements, surrounded by one ring of empty elements.
+
+             Usage: ./microBenchmark [--particles=N1,N2,..] [--ppc=P1,P2,..]
+                                     [google benchmark options]
+             ppc should be a square number (1, 4, 9, 16, ...).
+**************************************************************************/
+
+// c++ header files
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+// google benchmark header files
+#include <benchmark/benchmark.h>
+
+// header files
+#include "PropertyParse.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "Element.hpp"
+#include "Node.hpp"
+#include "Particle.hpp"
+#include "ReadMaterial.hpp"
+
+namespace {
+
+const unsigned dim = mpm::constants::DIM;
+// largest difference allowed between the batch and scalar stress kernels
+// (contraction to FMA instructions may change the last bits)
+const unsigned long maxStressUlp = 4;
+typedef Eigen::Matrix<double, 1, dim> VectorDDIM;
+typedef Eigen::Matrix<unsigned, 1, dim> VectorUDIM;
+
+
+// SYNTHETIC PARTICLE CLOUD
+struct Cloud {
+    mpm::Mesh* mesh;
+    mpm::MpmParticle* particles;
+    std::vector<mpm::material::MaterialBase*> materials;
+
+    ~Cloud() {
+        delete mesh;
+        delete particles;
+        for (auto material : materials)
+            delete material;
+    }
+};
+
+
+// time step and material parameters of the clouds (same as the shipped
+// test cases)
+const double cloudDt = 1.E-6;
+
+mpm::misc::PropertyList material_properties() {
+    mpm::misc::PropertyList properties;
+    properties["density"] = 1000.;
+    properties["viscosity"] = 1.E-3;
+    properties["bulkModulus"] = 2.E6;
+    properties["youngModulus"] = 1.E7;
+    properties["poissonRatio"] = 0.2;
+    properties["yieldStress"] = 244.;
+    properties["frictionAngle"] = 0.5;
+    properties["dilationAngle"] = 0.1;
+    properties["cohesion"] = 1.E3;
+    properties["regularisation"] = 1.E-3;
+    return properties;
+}
+
+
+// build a cloud and run one time step on it, so all particle and node
+// quantities are valid for the kernels
+Cloud* build_cloud(const unsigned& numParticles, const unsigned& ppc) {
+    Cloud* cloud = new Cloud();
+
+    unsigned ppcDir = std::round(std::sqrt(double(ppc)));
+    unsigned numCells = (numParticles + ppc - 1) / ppc;
+    unsigned cellsX = std::ceil(std::sqrt(double(numCells)));
+    unsigned cellsY = (numCells + cellsX - 1) / cellsX;
+
+    double h = 0.1;
+    VectorDDIM spacing = VectorDDIM::Constant(h);
+    VectorUDIM numElements;
+    numElements << cellsX + 2, cellsY + 2;
+    cloud->mesh = new mpm::Mesh(spacing, numElements, VectorDDIM::Zero());
+
+    // particles fill the cells row by row, starting from the second ring
+    VectorDDIM pSpacing = VectorDDIM::Constant(h / ppcDir);
+    cloud->particles = new mpm::MpmParticle(true);
+    VectorDDIM coord;
+    for (unsigned p = 0; p < numParticles; p++) {
+        unsigned cell = p / ppc;
+        unsigned sub = p % ppc;
+        coord(0) = h * (1 + (cell % cellsX)) + pSpacing(0) * (0.5 + (sub % ppcDir));
+        coord(1) = h * (1 + (cell / cellsX)) + pSpacing(1) * (0.5 + (sub / ppcDir));
+        cloud->particles->add_particle(coord, 0, pSpacing);
+    }
+
+    const mpm::misc::PropertyList properties = material_properties();
+    cloud->materials.push_back(mpm::material::Newtonian::create(properties));
+    cloud->materials.push_back(mpm::material::ILE::create(properties));
+    cloud->materials.push_back(mpm::material::MohrCoulomb::create(properties));
+    cloud->materials.push_back(mpm::material::ModifiedBingham::create(properties));
+    cloud->particles->assign_material_to_particles(cloud->materials);
+
+    double dt = cloudDt;
+    mpm::Mesh* mesh = cloud->mesh;
+    mpm::MpmParticle* particles = cloud->particles;
+    mesh->initialise_mesh(false);
+    particles->iterate_over_particles(std::bind(&mpm::Particle::initialise_particle, std::placeholders::_1));
+    mesh->locate_particles_in_mesh(particles);
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_local_coordinates, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_shape_functions, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions_at_centre, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_matrix, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix_at_centre, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::map_mass_to_nodes, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::map_momentum_to_nodes, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::assign_body_force_to_nodes, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::assign_internal_force_to_nodes, std::placeholders::_1));
+    mesh->solve_nodal_velocity_and_acceleration(dt);
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_strain_rate, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_strain_rate, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_strain_rate, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::map_volume_to_nodes, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::map_volumetric_strain_rate_to_nodes, std::placeholders::_1));
+    particles->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_vol_strain_rate_from_nodes, std::placeholders::_1));
+    return cloud;
+}
+
+
+// clouds are built once for each (size, ppc) and shared by all benchmarks
+Cloud* cloud(const unsigned& numParticles, const unsigned& ppc) {
+    static std::map<std::pair<unsigned, unsigned>, Cloud*> clouds;
+    std::pair<unsigned, unsigned> key(numParticles, ppc);
+    if (clouds.find(key) == clouds.end())
+        clouds[key] = build_cloud(numParticles, ppc);
+    return clouds[key];
+}
+
+
+// benchmark of one pass of a particle kernel over the cloud
+void particle_kernel(benchmark::State& state, void (mpm::Particle::*kernel)()) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    for (auto _ : state)
+        c->particles->iterate_over_particles(std::bind(kernel, std::placeholders::_1));
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+}
+
+
+// benchmark of one pass of a particle kernel which takes dt
+void particle_kernel_dt(benchmark::State& state, void (mpm::Particle::*kernel)(const double&)) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    double dt = cloudDt;
+    for (auto _ : state)
+        c->particles->iterate_over_particles(std::bind(kernel, std::placeholders::_1, dt));
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+}
+
+
+// benchmark of the stress update of all particles with one material
+void compute_stress(benchmark::State& state, const unsigned matId) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    std::vector<mpm::material::MaterialBase*> material(1, c->materials.at(matId));
+    c->particles->assign_material_to_particles(material);
+    for (auto _ : state)
+        c->particles->iterate_over_particles(std::bind(&mpm::Particle::compute_stress, std::placeholders::_1, cloudDt));
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+    material.at(0) = c->materials.at(0);
+    c->particles->assign_material_to_particles(material);
+}
+
+
+// benchmark of the batched stress update (one call per material)
+void compute_stress_batch(benchmark::State& state, const unsigned matId) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    std::vector<mpm::material::MaterialBase*> material(1, c->materials.at(matId));
+    c->particles->assign_material_to_particles(material);
+    for (auto _ : state)
+        c->particles->compute_stress(cloudDt);
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+    material.at(0) = c->materials.at(0);
+    c->particles->assign_material_to_particles(material);
+}
+
+
+// random stress states of "size" particles, stored as a StressBatch
+struct StressData {
+    std::vector<double> dStrain, dVolStrain, stress, pressure;
+    mpm::material::StressBatch batch;
+
+    StressData(const unsigned& size) {
+        const unsigned dof = 3 * (dim - 1);
+        std::srand(size);
+        random(dStrain, dof * size, 1.E-4);
+        random(dVolStrain, size, 1.E-4);
+        random(stress, 6 * size, 1.E4);
+        random(pressure, size, 1.E4);
+        batch.size = size;
+        batch.stride = size;
+        batch.dt = cloudDt;
+        batch.dStrain = dStrain.data();
+        batch.dVolStrain = dVolStrain.data();
+        batch.stress = stress.data();
+        batch.pressure = pressure.data();
+    }
+
+    static void random(std::vector<double>& values, const unsigned& size, const double& scale) {
+        values.resize(size);
+        for (auto& value : values)
+            value = scale * (2. * std::rand() / RAND_MAX - 1.);
+    }
+};
+
+
+// distance in units in the last place between two doubles
+unsigned long ulp_distance(const double& a, const double& b) {
+    long long ia, ib;
+    std::memcpy(&ia, &a, sizeof(double));
+    std::memcpy(&ib, &b, sizeof(double));
+    if (ia < 0)
+        ia = std::numeric_limits<long long>::min() - ia;
+    if (ib < 0)
+        ib = std::numeric_limits<long long>::min() - ib;
+    return ia > ib ? ia - ib : ib - ia;
+}
+
+
+// compare the batch kernel of a material with its scalar computeStress
+// (the default MaterialBase batch loop) and give the largest difference
+unsigned long verify_stress_kernel(mpm::material::MaterialBase* material) {
+    // an odd size, so the kernels also go through their remainder loops
+    StressData scalar(1001), batch(1001);
+    material->mpm::material::MaterialBase::computeStress(scalar.batch);
+    material->computeStress(batch.batch);
+    unsigned long maxUlp = 0;
+    for (unsigned i = 0; i < scalar.stress.size(); i++)
+        maxUlp = std::max(maxUlp, ulp_distance(scalar.stress.at(i), batch.stress.at(i)));
+    for (unsigned i = 0; i < scalar.pressure.size(); i++)
+        maxUlp = std::max(maxUlp, ulp_distance(scalar.pressure.at(i), batch.pressure.at(i)));
+    return maxUlp;
+}
+
+
+// benchmark of a material stress kernel alone, on SoA data: the scalar
+// computeStress called particle by particle, or the batch kernel
+void material_kernel(benchmark::State& state, const unsigned matId, const bool batched) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    mpm::material::MaterialBase* material = c->materials.at(matId);
+    StressData data(state.range(0));
+    for (auto _ : state) {
+        if (batched)
+            material->computeStress(data.batch);
+        else
+            material->mpm::material::MaterialBase::computeStress(data.batch);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// benchmark of the batched local coordinates, shape functions and
+// derivatives (replaces three particle kernels)
+void compute_shape_functions_batch(benchmark::State& state) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    for (auto _ : state)
+        c->particles->compute_shape_functions();
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+}
+
+
+// compare the batched shape functions with the particle kernels and give
+// the number of values which differ
+unsigned verify_shape_functions(mpm::MpmParticle* particles) {
+    std::vector<std::vector<double> > scalar, batch;
+    for (unsigned pass = 0; pass < 2; pass++) {
+        if (pass == 0) {
+            particles->iterate_over_particles(std::bind(&mpm::Particle::compute_local_coordinates, std::placeholders::_1));
+            particles->iterate_over_particles(std::bind(&mpm::Particle::compute_shape_functions, std::placeholders::_1));
+            particles->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions, std::placeholders::_1));
+        }
+        else
+            particles->compute_shape_functions();
+        std::vector<std::vector<double> >& values = pass == 0 ? scalar : batch;
+        for (unsigned i = 0; i < particles->number_of_particles(); i++) {
+            const mpm::Particle* particle = particles->pointer_to_particle(i);
+            std::vector<double> v;
+            for (unsigned k = 0; k < dim; k++)
+                v.push_back(particle->give_local_coordinates()(k));
+            for (unsigned n = 0; n < mpm::constants::NUMNODES; n++) {
+                v.push_back(particle->give_shape_functions()(n));
+                for (unsigned k = 0; k < dim; k++)
+                    v.push_back(particle->give_global_derivatives_shape_functions()(k, n));
+            }
+            values.push_back(v);
+        }
+    }
+    unsigned numDiffer = 0;
+    for (unsigned i = 0; i < scalar.size(); i++)
+        for (unsigned j = 0; j < scalar.at(i).size(); j++)
+            if (scalar.at(i).at(j) != batch.at(i).at(j))
+                numDiffer++;
+    return numDiffer;
+}
+
+
+// benchmark of the nodal solve over the nodes of particles
+void solve_nodal_velocity_and_acceleration(benchmark::State& state) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    double dt = cloudDt;
+    for (auto _ : state)
+        c->mesh->solve_nodal_velocity_and_acceleration(dt);
+    state.SetItemsProcessed(state.iterations() * c->mesh->p_nodes_.size());
+}
+
+
+// benchmark of locating particles (includes building the lists of
+// elements and nodes of particles)
+void locate_particles_in_mesh(benchmark::State& state) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    for (auto _ : state) {
+        c->mesh->initialise_mesh(false);
+        c->mesh->locate_particles_in_mesh(c->particles);
+    }
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+}
+
+
+// benchmark of one VTK writer
+void write_vtk(benchmark::State& state, void (mpm::MpmParticle::*writer)(std::ostream&)) {
+    Cloud* c = cloud(state.range(0), state.range(1));
+    std::ofstream out("/dev/null");
+    for (auto _ : state)
+        (c->particles->*writer)(out);
+    state.SetItemsProcessed(state.iterations() * c->particles->number_of_particles());
+}
+
+
+// parse a comma separated list of sizes
+std::vector<int> parse_list(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream in(list);
+    std::string value;
+    while (std::getline(in, value, ','))
+        values.push_back(std::stoi(value));
+    return values;
+}
+
+}
+
+
+int main (int argc, char* argv[]) {
+
+    std::vector<int> sizes = {10000, 100000};
+    std::vector<int> ppcs = {4, 16};
+
+    // take the cloud options out before google benchmark reads the rest
+    std::vector<char*> args;
+    for (int i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg.find("--particles=") == 0)
+            sizes = parse_list(arg.substr(12));
+        else if (arg.find("--ppc=") == 0)
+            ppcs = parse_list(arg.substr(6));
+        else
+            args.push_back(argv[i]);
+    }
+    int numArgs = args.size();
+
+    typedef void (mpm::Particle::*Kernel)();
+    typedef void (mpm::Particle::*KernelDt)(const double&);
+    typedef void (mpm::MpmParticle::*Writer)(std::ostream&);
+
+    std::vector<std::pair<std::string, Kernel> > kernels = {
+        {"compute_local_coordinates", &mpm::Particle::compute_local_coordinates},
+        {"compute_shape_functions", &mpm::Particle::compute_shape_functions},
+        {"compute_global_derivatives_shape_functions", &mpm::Particle::compute_global_derivatives_shape_functions},
+        {"compute_global_derivatives_shape_functions_at_centre", &mpm::Particle::compute_global_derivatives_shape_functions_at_centre},
+        {"compute_B_matrix", &mpm::Particle::compute_B_matrix},
+        {"compute_BBar_matrix", &mpm::Particle::compute_BBar_matrix},
+        {"compute_B_matrix_at_centre", &mpm::Particle::compute_B_matrix_at_centre},
+        {"map_mass_to_nodes", &mpm::Particle::map_mass_to_nodes},
+        {"map_momentum_to_nodes", &mpm::Particle::map_momentum_to_nodes},
+        {"assign_body_force_to_nodes", &mpm::Particle::assign_body_force_to_nodes},
+        {"assign_internal_force_to_nodes", &mpm::Particle::assign_internal_force_to_nodes},
+        {"map_volume_to_nodes", &mpm::Particle::map_volume_to_nodes},
+        {"map_volumetric_strain_rate_to_nodes", &mpm::Particle::map_volumetric_strain_rate_to_nodes},
+        {"compute_strain_rate", &mpm::Particle::compute_strain_rate},
+        {"compute_centre_strain_rate", &mpm::Particle::compute_centre_strain_rate},
+        {"compute_BBar_strain_rate", &mpm::Particle::compute_BBar_strain_rate},
+        {"compute_centre_vol_strain_rate_from_nodes", &mpm::Particle::compute_centre_vol_strain_rate_from_nodes}
+    };
+    std::vector<std::pair<std::string, KernelDt> > kernelsDt = {
+        {"compute_strain", &mpm::Particle::compute_strain},
+        {"update_velocity", &mpm::Particle::update_velocity},
+        {"update_position", &mpm::Particle::update_position}
+    };
+    std::vector<std::string> materials = {"Newtonian", "ILE", "MohrCoulomb", "ModifiedBingham"};
+    std::vector<std::pair<std::string, Writer> > writers = {
+        {"velocity", &mpm::MpmParticle::write_particle_velocity_data_to_file},
+        {"pressure", &mpm::MpmParticle::write_particle_pressure_data_to_file},
+        {"stress", &mpm::MpmParticle::write_particle_stress_data_to_file},
+        {"strain", &mpm::MpmParticle::write_particle_strain_data_to_file}
+    };
+
+    std::vector<benchmark::internal::Benchmark*> benchmarks;
+    for (const auto& kernel : kernels)
+        benchmarks.push_back(benchmark::RegisterBenchmark(("Particle::" + kernel.first).c_str(), particle_kernel, kernel.second));
+    for (const auto& kernel : kernelsDt)
+        benchmarks.push_back(benchmark::RegisterBenchmark(("Particle::" + kernel.first).c_str(), particle_kernel_dt, kernel.second));
+    for (unsigned i = 0; i < materials.size(); i++)
+        benchmarks.push_back(benchmark::RegisterBenchmark(("Particle::compute_stress/" + materials.at(i)).c_str(), compute_stress, i));
+    for (unsigned i = 0; i < materials.size(); i++)
+        benchmarks.push_back(benchmark::RegisterBenchmark(("MpmParticle::compute_stress/" + materials.at(i)).c_str(), compute_stress_batch, i));
+    for (unsigned i = 0; i < materials.size(); i++) {
+        benchmarks.push_back(benchmark::RegisterBenchmark(("computeStress/scalar/" + materials.at(i)).c_str(), material_kernel, i, false));
+        benchmarks.push_back(benchmark::RegisterBenchmark(("computeStress/batch/" + materials.at(i)).c_str(), material_kernel, i, true));
+    }
+    benchmarks.push_back(benchmark::RegisterBenchmark("MpmParticle::compute_shape_functions", compute_shape_functions_batch));
+    benchmarks.push_back(benchmark::RegisterBenchmark("Mesh::solve_nodal_velocity_and_acceleration", solve_nodal_velocity_and_acceleration));
+    benchmarks.push_back(benchmark::RegisterBenchmark("Mesh::locate_particles_in_mesh", locate_particles_in_mesh));
+    for (const auto& writer : writers)
+        benchmarks.push_back(benchmark::RegisterBenchmark(("MpmParticle::write_vtk/" + writer.first).c_str(), write_vtk, writer.second));
+
+    for (auto bm : benchmarks) {
+        bm->ArgNames({"particles", "ppc"});
+        for (auto size : sizes)
+            for (auto ppc : ppcs)
+                bm->Args({size, ppc});
+    }
+
+    // the batch stress kernels should give the results of the scalar ones
+    Cloud* c = cloud(sizes.at(0), ppcs.at(0));
+    for (unsigned i = 0; i < materials.size(); i++) {
+        unsigned long maxUlp = verify_stress_kernel(c->materials.at(i));
+        std::cout << "computeStress/batch/" << materials.at(i) << ": largest difference to the scalar kernel " << maxUlp << " ulp \n";
+        if (maxUlp > maxStressUlp) {
+            std::cerr << "ERROR: batch stress kernel of " << materials.at(i) << " differs from the scalar kernel \n";
+            return 1;
+        }
+    }
+
+    // the batched shape functions should give the same bits as the
+    // particle kernels
+    unsigned numDiffer = verify_shape_functions(c->particles);
+    std::cout << "MpmParticle::compute_shape_functions: " << numDiffer << " values differ from the particle kernels \n";
+    if (numDiffer) {
+        std::cerr << "ERROR: batched shape functions differ from the particle kernels \n";
+        return 1;
+    }
+
+    benchmark::Initialize(&numArgs, args.data());
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
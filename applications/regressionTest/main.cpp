@@ -0,0 +1,572 @@
+/*************************************************************************
+                        2D-Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+Description: Regression runner over the test cases of incompressibleFluid.
+             Each case is run in its own process for a bounded number of
+             steps. At the end,
+               1. the particle fields (coordinates, velocity, pressure,
+                  stress and strain) are compared with the golden snapshot
+                  in tests/<case>/regression/golden.dat. A field fails when
+                  max|new - golden| > tolerance * max|golden|.
+               2. the wall time, peak resident memory and throughput
+                  (particles / median time of a step) are compared with
+                  tests/<case>/regression/baseline.dat. The case fails
+                  when the throughput drops by more than "threshold".
+             The program returns 1 if any case fails.
+             A case "case/variant" runs tests/case with the parameters of
+             tests/case/regression/variant/input.dat on top of those of
+             the case; its golden and baseline files are in that
+             directory too.
+             A case with steadyStateTolerance stops when it is steady: the
+             step it stops at is compared with the one of the golden
+             snapshot ("solved"), and --steps only bounds it. The steps
+             of a quasi-static case (quasiStaticFlag) are load steps, each
+             one relaxed to equilibrium. A case of 0 steps checks the
+             initial state (e.g. the generated initial stress) and has
+             no throughput to compare.
+             When the variant directory has a reference.dat, the case is
+             also run with the parameters of reference.dat (instead of
+             those of input.dat) to the same time, and it fails unless
+             both runs give the same bits, e.g. a multi-rate run of one
+             level against the single-rate run. With a "tolerance" in
+             reference.dat the fields of the two runs are compared as the
+             golden snapshot, e.g. a multi-rate run against the
+             single-rate run at the time step of its finest level. Both
+             runs use one thread, as the transfers sum at the nodes in
+             the same order only then. --tile, --deterministic and
+             --task-graph are not applied to a multi-rate case, which
+             can not use them.
+             When the variant directory has an expected.dat, the means
+             of the fields over the particles are also compared with its
+             values (e.g. an analytical solution), each line being
+             "field component value tolerance".
+
+             Usage: ./regressionTest [--tests=../incompressibleFluid/tests]
+                        [--cases=c1,c2,..] [--steps=200] [--tolerance=1e-6]
+                        [--threshold=0.15] [--update-golden]
+                        [--update-baseline] [--tile=N] [--report]
+                        [--deterministic] [--task-graph]
+             --report prints the relative error of every field (also of
+             the cases which pass), e.g. to compare a mixed precision
+             build (-DMPM_MIXED_PRECISION) with the double golden data.
+             --tile overrides the tile size of the input files (0: no
+             tiles); the nodes on the tile borders differ by round-off,
+             so compare with a tolerance of about 1e-9.
+             --deterministic sums the contributions at the nodes in the
+             order of the particles: the snapshots are the same bits for
+             any OMP_NUM_THREADS.
+             --task-graph runs the stages of a step as a task graph (with
+             one thread, or with --deterministic, the same bits as the
+             stages one after the other).
+             The step count of a case is the one of its golden snapshot;
+             --steps is used when the golden snapshot is (re)written.
+             The baseline is machine dependent: write it again with
+             --update-baseline on the machine used for the comparison.
+**************************************************************************/
+
+// c++ header files
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+
+// system header files
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// header files
+#include "FileHandle.hpp"
+#include "PropertyParse.hpp"
+#include "Timer.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "Element.hpp"
+#include "Particle.hpp"
+#include "MpmSolver.hpp"
+#include "Simulation.hpp"
+
+namespace {
+
+// a snapshot: the values of each field, particle by particle
+typedef std::map<std::string, std::vector<double> > Snapshot;
+
+struct Measurement {
+    unsigned steps;
+    unsigned solved;
+    unsigned particles;
+    double wallTime;
+    double secondsPerStep;
+    double updatesPerSecond;
+    double peakMemory;
+};
+
+
+// WRITE SNAPSHOT
+//! The fields are written one after the other with the particle writers,
+//! each preceded by "FIELD name". "solved" is the number of steps
+//! solved, below "steps" when the case stops early. With 17 digits the
+//! snapshot holds the bits of the fields. Removed particles which are not
+//! yet compacted are dropped first.
+void write_snapshot(std::ostream& outFile, mpm::MpmParticle* particles, const unsigned& steps, const unsigned& solved, const int& precision = 10) {
+    particles->compact();
+    unsigned numOfParticles = particles->number_of_particles();
+    outFile << "steps " << steps << "\n";
+    outFile << "solved " << solved << "\n";
+    outFile << "particles " << numOfParticles << "\n";
+    outFile.precision(precision);
+
+    outFile << "FIELD coordinates" << "\n";
+    for (unsigned i = 0; i < numOfParticles; i++) {
+        Eigen::Matrix<double, 1, mpm::constants::DIM> coord = particles->particle_coordinates(i);
+        for (unsigned j = 0; j < coord.size(); j++)
+            outFile << coord(j) << (j + 1 < coord.size() ? " " : "\n");
+    }
+    outFile << "FIELD velocity" << "\n";
+    for (unsigned i = 0; i < numOfParticles; i++)
+        particles->pointer_to_particle(i)->write_velocity(outFile);
+    outFile << "FIELD pressure" << "\n";
+    for (unsigned i = 0; i < numOfParticles; i++)
+        particles->pointer_to_particle(i)->write_pressure(outFile);
+    outFile << "FIELD stress" << "\n";
+    for (unsigned i = 0; i < numOfParticles; i++)
+        particles->pointer_to_particle(i)->write_stress(outFile);
+    outFile << "FIELD strain" << "\n";
+    for (unsigned i = 0; i < numOfParticles; i++)
+        particles->pointer_to_particle(i)->write_strain(outFile);
+}
+
+
+// READ SNAPSHOT
+//! "solved" is "steps" in the snapshots written without it
+bool read_snapshot(const std::string& fileName, Snapshot& snapshot, unsigned& steps, unsigned& solved) {
+    std::ifstream inFile(fileName.c_str());
+    if (!inFile.is_open())
+        return false;
+    std::string word, field;
+    unsigned numOfParticles;
+    inFile >> word >> steps;
+    solved = steps;
+    while (inFile >> word) {
+        if (word == "solved") {
+            inFile >> solved;
+            continue;
+        }
+        if (word == "particles") {
+            inFile >> numOfParticles;
+            continue;
+        }
+        if (word == "FIELD") {
+            inFile >> field;
+            continue;
+        }
+        snapshot[field].push_back(std::strtod(word.c_str(), NULL));
+    }
+    return true;
+}
+
+
+// READ/WRITE BASELINE (key value per line, as input.dat)
+bool read_baseline(const std::string& fileName, Measurement& baseline) {
+    std::ifstream inFile(fileName.c_str());
+    if (!inFile.is_open())
+        return false;
+    std::string key;
+    double value;
+    while (inFile >> key >> value) {
+        if (key == "steps")
+            baseline.steps = value;
+        if (key == "particles")
+            baseline.particles = value;
+        if (key == "wallTime")
+            baseline.wallTime = value;
+        if (key == "secondsPerStep")
+            baseline.secondsPerStep = value;
+        if (key == "updatesPerSecond")
+            baseline.updatesPerSecond = value;
+        if (key == "peakMemory")
+            baseline.peakMemory = value;
+    }
+    return true;
+}
+
+void write_baseline(const std::string& fileName, const Measurement& run) {
+    std::ofstream outFile(fileName.c_str());
+    outFile.precision(8);
+    outFile << "steps               " << run.steps << "\n";
+    outFile << "particles           " << run.particles << "\n";
+    outFile << "wallTime            " << run.wallTime << "\n";
+    outFile << "secondsPerStep      " << run.secondsPerStep << "\n";
+    outFile << "updatesPerSecond    " << run.updatesPerSecond << "\n";
+    outFile << "peakMemory          " << run.peakMemory << "\n";
+}
+
+
+// READ SETTINGS
+//! the case settings with the parameters of "fileName" (if any) on top
+mpm::misc::Settings read_settings(const mpm::CaseInput& input, const std::string& fileName) {
+    mpm::misc::Settings settings = input.settings;
+    std::ifstream inFile(fileName.c_str());
+    std::string line;
+    while (std::getline(inFile, line))
+        mpm::misc::PARSE_PROPERTIES(line, settings);
+    return settings;
+}
+
+// READ TOLERANCE
+//! the "tolerance" of a reference.dat (0: the same bits)
+double read_tolerance(const std::string& fileName) {
+    std::ifstream inFile(fileName.c_str());
+    std::string key;
+    double tolerance = 0.;
+    while (inFile >> key)
+        if (key == "tolerance")
+            inFile >> tolerance;
+    return tolerance;
+}
+
+// OVERRIDE SETTINGS
+//! the overrides of the command line
+void override_settings(mpm::misc::Settings& settings, const int& tileSize, const bool& deterministic, const bool& taskGraph) {
+    if (tileSize >= 0)
+        settings.tileSize = tileSize;
+    if (deterministic)
+        settings.deterministic = true;
+    if (taskGraph)
+        settings.taskGraph = true;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: RUN_CASE
+          Runs in the child process. The case is read as in
+          incompressibleMPM, with the parameters of "variantFile" (if
+          any) on top of those of input.dat, but only "steps" steps are
+          solved and no vtk files are written. A steady case stops
+          earlier; a quasi-static case solves "steps" load steps. The
+          final snapshot and the median time of a step (or load step)
+          are written to Results/. With a "referenceFile", the case is
+          run again with its parameters to the same time (or for as
+          many load steps), and the snapshots of both runs are written
+          with 17 digits to Results/bits.dat and Results/reference.dat.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void run_case(const std::string& caseDir, const std::string& variantFile, const std::string& referenceFile, const unsigned& steps, const int& tileSize, const bool& deterministic, const bool& taskGraph) {
+    boost::filesystem::path p(caseDir);
+    mpm::FileHandle fileHandle_(p);
+    mpm::CaseInput input_(fileHandle_);
+    mpm::misc::Settings settings_ = read_settings(input_, variantFile);
+    // a multi-rate case can not use tiles or ordered sums, so it is run
+    // (with its reference) without the overrides
+    const bool overrides = settings_.multiRateLevels < 2;
+    if (overrides)
+        override_settings(settings_, tileSize, deterministic, taskGraph);
+
+#ifdef _OPENMP
+    if (settings_.numOfThreads)
+        omp_set_num_threads(settings_.numOfThreads);
+    // the nodal sums of different transfers are in the same order only
+    // with one thread
+    if (boost::filesystem::exists(referenceFile))
+        omp_set_num_threads(1);
+#endif
+
+    mpm::Simulation simulation_(input_, settings_, mpm::misc::PropertyList());
+    mpm::MpmParticle* particles_ = simulation_.particles();
+
+    std::vector<double> stepTimes;
+    unsigned solved = 0;
+    while (solved < steps && !simulation_.steady()) {
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        if (settings_.quasiStatic)
+            simulation_.solve_load_step();
+        else
+            simulation_.solve_one_step();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        stepTimes.push_back(std::chrono::duration<double>(end - begin).count());
+        solved++;
+    }
+    std::sort(stepTimes.begin(), stepTimes.end());
+    double median = stepTimes.empty() ? 0. : stepTimes.at(stepTimes.size() / 2);
+
+    std::ofstream snapshotOut((caseDir + "/Results/snapshot.dat").c_str());
+    write_snapshot(snapshotOut, particles_, steps, solved);
+    std::ofstream timingOut((caseDir + "/Results/timing.dat").c_str());
+    timingOut.precision(10);
+    timingOut << median << "\n";
+
+    if (!boost::filesystem::exists(referenceFile))
+        return;
+    mpm::misc::Settings referenceSettings = read_settings(input_, referenceFile);
+    if (overrides)
+        override_settings(referenceSettings, tileSize, deterministic, taskGraph);
+    mpm::Simulation reference_(input_, referenceSettings, mpm::misc::PropertyList());
+    // the reference is solved to the same time (or for as many load
+    // steps), e.g. in smaller steps
+    if (referenceSettings.quasiStatic) {
+        for (unsigned i = 0; i < solved; i++)
+            reference_.solve_load_step();
+    }
+    else {
+        while (reference_.time() < simulation_.time() - 0.5 * reference_.settings().dt)
+            reference_.solve_one_step();
+    }
+    std::ofstream bitsOut((caseDir + "/Results/bits.dat").c_str());
+    write_snapshot(bitsOut, particles_, steps, solved, 17);
+    std::ofstream referenceOut((caseDir + "/Results/reference.dat").c_str());
+    write_snapshot(referenceOut, reference_.particles(), steps, solved, 17);
+}
+
+
+// COMPARE SNAPSHOTS
+//! returns false if any field is off by more than the tolerance; with
+//! "report" the error of every field is printed
+bool compare_snapshots(const Snapshot& golden, const Snapshot& result, const double& tolerance, const bool& report) {
+    bool pass = true;
+    for (const auto& field : golden) {
+        Snapshot::const_iterator it = result.find(field.first);
+        if (it == result.end() || it->second.size() != field.second.size()) {
+            std::cout << "\t   field " << field.first << ": size differs from the golden snapshot \n";
+            pass = false;
+            continue;
+        }
+        double maxValue = 0., maxError = 0.;
+        for (unsigned i = 0; i < field.second.size(); i++) {
+            maxValue = std::max(maxValue, std::fabs(field.second.at(i)));
+            maxError = std::max(maxError, std::fabs(it->second.at(i) - field.second.at(i)));
+        }
+        // fields which are zero are compared in absolute terms
+        double error = maxError / (maxValue > 0. ? maxValue : 1.);
+        if (error > tolerance) {
+            std::cout << "\t   field " << field.first << ": relative error " << error << " > " << tolerance << "\n";
+            pass = false;
+        }
+        else if (report)
+            std::cout << "\t   field " << field.first << ": relative error " << error << "\n";
+    }
+    return pass;
+}
+
+
+// CHECK EXPECTED MEANS
+//! Each line of "fileName" is "field component value tolerance": the
+//! mean of the component over the particles must be within the
+//! (absolute) tolerance of the value, e.g. an analytical solution.
+//! Returns true without the file.
+bool check_expected(const std::string& fileName, const Snapshot& result, const unsigned& numOfParticles, const bool& report) {
+    std::ifstream inFile(fileName.c_str());
+    std::string field;
+    unsigned component;
+    double value, tolerance;
+    bool pass = true;
+    while (inFile >> field >> component >> value >> tolerance) {
+        Snapshot::const_iterator it = result.find(field);
+        if (it == result.end() || numOfParticles == 0) {
+            std::cout << "\t   field " << field << ": missing for the expected mean \n";
+            pass = false;
+            continue;
+        }
+        const unsigned stride = it->second.size() / numOfParticles;
+        double mean = 0.;
+        for (unsigned i = 0; i < numOfParticles; i++)
+            mean += it->second.at(i * stride + component);
+        mean /= numOfParticles;
+        if (std::fabs(mean - value) > tolerance) {
+            std::cout << "\t   field " << field << "(" << component << "): mean " << mean << ", expected " << value << " +- " << tolerance << "\n";
+            pass = false;
+        }
+        else if (report)
+            std::cout << "\t   field " << field << "(" << component << "): mean " << mean << ", expected " << value << "\n";
+    }
+    return pass;
+}
+
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream in(list);
+    std::string value;
+    while (std::getline(in, value, ','))
+        values.push_back(value);
+    return values;
+}
+
+}
+
+
+int main (int argc, char* argv[]) {
+
+    std::string testsDir = "../incompressibleFluid/tests";
+    std::vector<std::string> cases = {"compressionTest", "damBreak", "lidDrivenCavity", "standingWave", "tensionTest", "granularCollapse", "mudflow", "coarseCavity/steadyState", "compressionTest/quasiStatic", "standingWave/hydrostatic", "damBreak/multiRate", "mudflow/machNumber", "elasticBlock", "slidingBlock", "slidingBlock/stick", "inflowOutflow"};
+    unsigned defaultSteps = 200;
+    double tolerance = 1.E-6;
+    double threshold = 0.15;
+    bool updateGolden = false;
+    bool updateBaseline = false;
+    int tileSize = -1;
+    bool report = false;
+    bool deterministic = false;
+    bool taskGraph = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        std::string value = arg.substr(arg.find('=') + 1);
+        if (arg.find("--tests=") == 0)
+            testsDir = value;
+        else if (arg.find("--cases=") == 0)
+            cases = split(value);
+        else if (arg.find("--steps=") == 0)
+            defaultSteps = std::stoul(value);
+        else if (arg.find("--tolerance=") == 0)
+            tolerance = std::stod(value);
+        else if (arg.find("--threshold=") == 0)
+            threshold = std::stod(value);
+        else if (arg == "--update-golden")
+            updateGolden = true;
+        else if (arg == "--update-baseline")
+            updateBaseline = true;
+        else if (arg.find("--tile=") == 0)
+            tileSize = std::stoi(value);
+        else if (arg == "--report")
+            report = true;
+        else if (arg == "--deterministic")
+            deterministic = true;
+        else if (arg == "--task-graph")
+            taskGraph = true;
+        else {
+            std::cerr << "ERROR: unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "\n \t Regression of the test cases in " << testsDir << "\n";
+    std::cout << std::left << std::setw(30) << "case" << std::setw(8) << "steps" << std::setw(11) << "particles";
+    std::cout << std::setw(12) << "wall(s)" << std::setw(14) << "updates/s" << std::setw(12) << "baseline";
+    std::cout << std::setw(12) << "peak(MB)" << std::setw(10) << "fields" << "result" << std::right << "\n";
+
+    unsigned numOfFailures = 0;
+    for (const auto& name : cases) {
+        std::string caseName = name.substr(0, name.find('/'));
+        std::string caseDir = testsDir + "/" + caseName;
+        std::string regressionDir = caseDir + "/regression";
+        if (caseName != name)
+            regressionDir += name.substr(name.find('/'));
+        boost::filesystem::create_directories(regressionDir);
+
+        Snapshot golden;
+        unsigned steps = defaultSteps, goldenSolved = 0;
+        bool hasGolden = !updateGolden && read_snapshot(regressionDir + "/golden.dat", golden, steps, goldenSolved);
+
+        // the case runs in a child process: the peak memory is the one of
+        // the case
+        std::cout.flush();
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        pid_t pid = fork();
+        if (pid == 0) {
+            std::cout.rdbuf(NULL);
+            run_case(caseDir, regressionDir + "/input.dat", regressionDir + "/reference.dat", steps, tileSize, deterministic, taskGraph);
+            _exit(0);
+        }
+        int status = 0;
+        struct rusage usage;
+        wait4(pid, &status, 0, &usage);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::cout << std::left << std::setw(30) << name << "FAIL (the case did not run to the end)" << std::right << "\n";
+            numOfFailures++;
+            continue;
+        }
+
+        Measurement run;
+        Snapshot result;
+        read_snapshot(caseDir + "/Results/snapshot.dat", result, run.steps, run.solved);
+        std::ifstream timingIn((caseDir + "/Results/timing.dat").c_str());
+        timingIn >> run.secondsPerStep;
+        run.particles = result["pressure"].size();
+        run.wallTime = std::chrono::duration<double>(end - begin).count();
+        run.updatesPerSecond = run.secondsPerStep > 0. ? run.particles / run.secondsPerStep : 0.;
+        run.peakMemory = usage.ru_maxrss / 1024.;
+
+        bool pass = true;
+        std::string fields = "-";
+        if (hasGolden) {
+            fields = "ok";
+            if (run.solved != goldenSolved) {
+                std::cout << "\t   stopped after " << run.solved << " steps, the golden snapshot after " << goldenSolved << "\n";
+                fields = "differ";
+                pass = false;
+            }
+            else if (!compare_snapshots(golden, result, tolerance, report)) {
+                fields = "differ";
+                pass = false;
+            }
+        }
+        else if (updateGolden) {
+            boost::filesystem::copy_file(caseDir + "/Results/snapshot.dat", regressionDir + "/golden.dat", boost::filesystem::copy_option::overwrite_if_exists);
+            fields = "written";
+        }
+
+        // the means against the expected values, if any
+        if (!check_expected(regressionDir + "/expected.dat", result, run.particles, report)) {
+            fields = "differ";
+            pass = false;
+        }
+
+        // the run against the reference run, if any
+        Snapshot bits, referenceBits;
+        unsigned referenceSteps, referenceSolved;
+        if (read_snapshot(caseDir + "/Results/reference.dat", referenceBits, referenceSteps, referenceSolved)) {
+            read_snapshot(caseDir + "/Results/bits.dat", bits, referenceSteps, referenceSolved);
+            double referenceTolerance = read_tolerance(regressionDir + "/reference.dat");
+            if (!compare_snapshots(referenceBits, bits, referenceTolerance, report)) {
+                if (referenceTolerance > 0.)
+                    std::cout << "\t   off by more than " << referenceTolerance << " from the run with the parameters of reference.dat \n";
+                else
+                    std::cout << "\t   not the same bits as the run with the parameters of reference.dat \n";
+                fields = "differ";
+                pass = false;
+            }
+        }
+
+        Measurement baseline;
+        std::string reference = "-";
+        // a case of 0 steps has no throughput
+        if (run.updatesPerSecond > 0.) {
+            if (!updateBaseline && read_baseline(regressionDir + "/baseline.dat", baseline)) {
+                double ratio = run.updatesPerSecond / baseline.updatesPerSecond;
+                std::stringstream ratioString;
+                ratioString << std::setprecision(3) << 100. * ratio << "%";
+                reference = ratioString.str();
+                if (ratio < 1. - threshold)
+                    pass = false;
+            }
+            else if (updateBaseline) {
+                write_baseline(regressionDir + "/baseline.dat", run);
+                reference = "written";
+            }
+        }
+
+        std::cout << std::left << std::setw(30) << name << std::setw(8) << run.solved << std::setw(11) << run.particles;
+        std::cout << std::setw(12) << run.wallTime << std::setw(14) << run.updatesPerSecond << std::setw(12) << reference;
+        std::cout << std::setw(12) << run.peakMemory << std::setw(10) << fields << (pass ? "PASS" : "FAIL") << std::right << "\n";
+        if (!pass)
+            numOfFailures++;
+    }
+
+    std::cout << "\n \t " << numOfFailures << " of " << cases.size() << " cases failed \n";
+    return numOfFailures ? 1 : 0;
+}
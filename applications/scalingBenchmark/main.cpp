@@ -0,0 +1,280 @@
+/*************************************************************************
+                        2D-Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+Description: End-to-end scaling benchmark. A scene (damBreak,
+             lidDrivenCavity or standingWave) is built in memory by the
+             SceneBuilder and advanced for a fixed number of steps, for
+             each number of threads.
+               strong: the size is fixed and the threads increase
+               weak  : the number of particles grows with the threads
+             For each run the time per step, particle updates per second,
+             parallel efficiency and memory are reported.
+
+             Usage: ./scalingBenchmark [--scene=damBreak] [--resolution=64]
+                        [--ppc=4] [--steps=50] [--threads=1,2,4,8]
+                        [--sweep=strong|weak|both] [--csv=file]
+                        [--tile=0] [--deterministic] [--task-graph]
+                        [--compare-deterministic]
+             --tile sets the tile size of the transfer between particles
+             and nodes (0: no tiles).
+             --deterministic sums the contributions at the nodes in a
+             fixed order (compare with a run without it for the cost).
+             --task-graph runs the stages of a step as a task graph.
+             --compare-deterministic runs the strong sweep once with the
+             atomic adds at the nodes and once with the deterministic
+             sums, and reports the overhead of the latter per number of
+             threads (the two runs of a number of threads follow each
+             other, so a drift of the machine hits both).
+**************************************************************************/
+
+// c++ header files
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+
+// system header files
+#include <unistd.h>
+#include <sys/resource.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// header files
+#include "PropertyParse.hpp"
+#include "Timer.hpp"
+#include "SceneBuilder.hpp"
+#include "MpmSolver.hpp"
+
+namespace {
+
+// resident memory of the process (MB)
+double resident_memory() {
+    long pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return double(resident) * sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+}
+
+// peak resident memory of the process (MB)
+double peak_memory() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.;
+}
+
+// parse a comma separated list of thread counts
+std::vector<unsigned> parse_list(const std::string& list) {
+    std::vector<unsigned> values;
+    std::stringstream in(list);
+    std::string value;
+    while (std::getline(in, value, ','))
+        values.push_back(std::stoul(value));
+    return values;
+}
+
+struct Run {
+    std::string sweep;
+    unsigned threads;
+    unsigned resolution;
+    unsigned particles;
+    unsigned nodes;
+    double secondsPerStep;
+    double sceneMemory;
+    double peakMemory;
+};
+
+// build a scene and time "steps" steps on "threads" threads
+Run run_scene(const std::string& sceneName, const unsigned& resolution, const unsigned& ppc, const unsigned& steps, const unsigned& threads, const mpm::misc::Settings& options) {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    Run run;
+    run.threads = threads;
+    run.resolution = resolution;
+
+    double memoryBefore = resident_memory();
+    mpm::scene::SceneBuilder builder(resolution, ppc);
+    mpm::scene::Scene* scene = builder.build(sceneName);
+    run.sceneMemory = resident_memory() - memoryBefore;
+    run.particles = scene->particles->number_of_particles();
+    run.nodes = scene->mesh->nodes_.size();
+
+    // the solver options of the command line with the settings of the scene
+    mpm::misc::Settings settings = scene->settings;
+    settings.tileSize = options.tileSize;
+    settings.deterministic = options.deterministic;
+    settings.taskGraph = options.taskGraph;
+    mpm::misc::PhaseTimer timer;
+    mpm::MpmSolver solver(scene->mesh, scene->particles, settings, timer);
+
+    // one step to touch all memory before timing
+    solver.solve_one_step(settings.dt);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < steps; i++)
+        solver.solve_one_step(settings.dt);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    run.secondsPerStep = std::chrono::duration<double>(end - begin).count() / steps;
+    run.peakMemory = peak_memory();
+
+    delete scene;
+    return run;
+}
+
+void write_header(std::ostream& out) {
+    out << std::left << std::setw(8) << "sweep" << std::setw(9) << "threads" << std::setw(12) << "resolution";
+    out << std::setw(12) << "particles" << std::setw(10) << "nodes" << std::setw(14) << "ms/step";
+    out << std::setw(16) << "updates/s" << std::setw(12) << "efficiency" << std::setw(14) << "scene(MB)";
+    out << "peak(MB)" << std::right << "\n";
+}
+
+void write_comparison_header(std::ostream& out) {
+    out << std::left << std::setw(9) << "threads" << std::setw(12) << "particles" << std::setw(16) << "atomic ms/step";
+    out << std::setw(22) << "deterministic ms/step" << "overhead" << std::right << "\n";
+}
+
+void write_comparison(std::ostream& out, const Run& atomic, const Run& deterministic) {
+    std::stringstream overhead;
+    overhead << std::setprecision(3) << 100. * (deterministic.secondsPerStep / atomic.secondsPerStep - 1.) << "%";
+    out << std::left << std::setw(9) << atomic.threads << std::setw(12) << atomic.particles;
+    out << std::setw(16) << 1.E3 * atomic.secondsPerStep << std::setw(22) << 1.E3 * deterministic.secondsPerStep;
+    out << overhead.str() << std::right << "\n";
+}
+
+void write_run(std::ostream& out, const Run& run, const double& efficiency) {
+    out << std::left << std::setw(8) << run.sweep << std::setw(9) << run.threads << std::setw(12) << run.resolution;
+    out << std::setw(12) << run.particles << std::setw(10) << run.nodes << std::setw(14) << 1.E3 * run.secondsPerStep;
+    out << std::setw(16) << run.particles / run.secondsPerStep << std::setw(12) << efficiency;
+    out << std::setw(14) << run.sceneMemory << run.peakMemory << std::right << "\n";
+}
+
+}
+
+
+int main (int argc, char* argv[]) {
+
+    std::string sceneName = "damBreak";
+    unsigned resolution = 64;
+    unsigned ppc = 4;
+    unsigned steps = 50;
+    std::vector<unsigned> threads = {1, 2, 4, 8};
+    std::string sweep = "both";
+    std::string csvFile;
+    unsigned tileSize = 0;
+    bool deterministic = false;
+    bool taskGraph = false;
+    bool compareDeterministic = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        std::string value = arg.substr(arg.find('=') + 1);
+        if (arg.find("--scene=") == 0)
+            sceneName = value;
+        else if (arg.find("--resolution=") == 0)
+            resolution = std::stoul(value);
+        else if (arg.find("--ppc=") == 0)
+            ppc = std::stoul(value);
+        else if (arg.find("--steps=") == 0)
+            steps = std::stoul(value);
+        else if (arg.find("--threads=") == 0)
+            threads = parse_list(value);
+        else if (arg.find("--sweep=") == 0)
+            sweep = value;
+        else if (arg.find("--csv=") == 0)
+            csvFile = value;
+        else if (arg.find("--tile=") == 0)
+            tileSize = std::stoul(value);
+        else if (arg == "--deterministic")
+            deterministic = true;
+        else if (arg == "--task-graph")
+            taskGraph = true;
+        else if (arg == "--compare-deterministic")
+            compareDeterministic = true;
+        else {
+            std::cerr << "ERROR: unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+    mpm::misc::Settings options;
+    options.tileSize = tileSize;
+    options.deterministic = deterministic;
+    options.taskGraph = taskGraph;
+#ifndef _OPENMP
+    std::cerr << "WARNING: built without OpenMP, all runs use one thread" << "\n";
+#endif
+
+    std::cout << "\n \t Scaling benchmark: " << sceneName << ", resolution " << resolution;
+    std::cout << ", " << ppc << " particles per cell, " << steps << " steps";
+    if (tileSize)
+        std::cout << ", tiles of " << tileSize << "x" << tileSize << " elements";
+    if (deterministic)
+        std::cout << ", deterministic sums";
+    if (taskGraph)
+        std::cout << ", task graph";
+    std::cout << " \n \n";
+
+    if (compareDeterministic) {
+        write_comparison_header(std::cout);
+        for (const auto& t : threads) {
+            options.deterministic = false;
+            Run atomic = run_scene(sceneName, resolution, ppc, steps, t, options);
+            options.deterministic = true;
+            Run fixedOrder = run_scene(sceneName, resolution, ppc, steps, t, options);
+            write_comparison(std::cout, atomic, fixedOrder);
+        }
+        return 0;
+    }
+    write_header(std::cout);
+
+    std::vector<Run> runs;
+    std::vector<double> efficiencies;
+    std::vector<std::string> sweeps;
+    if (sweep == "strong" || sweep == "both")
+        sweeps.push_back("strong");
+    if (sweep == "weak" || sweep == "both")
+        sweeps.push_back("weak");
+
+    for (const auto& name : sweeps) {
+        double reference = 0.;
+        for (unsigned i = 0; i < threads.size(); i++) {
+            unsigned t = threads.at(i);
+            // weak scaling: the number of particles (~ resolution^2) grows
+            // in proportion to the threads
+            unsigned res = resolution;
+            if (name == "weak")
+                res = std::round(resolution * std::sqrt(double(t) / threads.at(0)));
+
+            Run run = run_scene(sceneName, res, ppc, steps, t, options);
+            run.sweep = name;
+            // time per particle update, relative to the first run
+            double perUpdate = run.secondsPerStep * t / run.particles;
+            if (i == 0)
+                reference = perUpdate * threads.at(0);
+            double efficiency = reference / perUpdate;
+
+            write_run(std::cout, run, efficiency);
+            runs.push_back(run);
+            efficiencies.push_back(efficiency);
+        }
+    }
+
+    if (!csvFile.empty()) {
+        std::ofstream csv(csvFile.c_str());
+        csv << "sweep,threads,resolution,particles,nodes,seconds_per_step,updates_per_second,efficiency,scene_mb,peak_mb\n";
+        for (unsigned i = 0; i < runs.size(); i++) {
+            const Run& run = runs.at(i);
+            csv << run.sweep << "," << run.threads << "," << run.resolution << "," << run.particles << ",";
+            csv << run.nodes << "," << run.secondsPerStep << "," << run.particles / run.secondsPerStep << ",";
+            csv << efficiencies.at(i) << "," << run.sceneMemory << "," << run.peakMemory << "\n";
+        }
+    }
+    return 0;
+}
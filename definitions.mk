@@ -5,14 +5,29 @@ WORK_DIR = /home/cbgeo/research/MPMcode
 # compiler/linker
 C_PP = g++
 
+# vector instructions, e.g. -mavx2 -mfma or -march=native (the material
+# batch kernels then process 4 or 8 particles per instruction). Particles,
+# nodes and elements come from cache line aligned pools, so no alignment
+# flag is needed. Check the effect on the whole time step with
+# applications/regressionTest.
+SIMD_FLAGS =
+
+# precision of the particle storage. -DMPM_MIXED_PRECISION stores the
+# coordinates (relative to the centre of the element), velocity and stress
+# of the particles in float; the nodal sums and the time integration stay
+# in double. See "Mixed Precision Particle Storage" in doc/Documentation
+# and compare a case with applications/regressionTest --report.
+PRECISION_FLAGS =
+
 # compilation/linking flags
-C_FLAGS = -g -O2
-L_FLAGS = -g
+C_FLAGS = -g -O2 -fopenmp $(SIMD_FLAGS) $(PRECISION_FLAGS)
+L_FLAGS = -g -fopenmp
 
 # library paths and names
 LIB_DIR = $(WORK_DIR)/libs
 BOOST = $(LIB_DIR)/boost_1_61_0
 EIGEN = $(LIB_DIR)/eigen-eigen-dc6cfdf9bcec
+GBENCHMARK = $(LIB_DIR)/benchmark
 
 # include directory for mpm header files
 INCLUDE_DIR = $(WORK_DIR)/includes 
@@ -21,4 +36,6 @@ SRC = $(WORK_DIR)/includes/src
 MISC = $(SRC)/misc
 MESH = $(SRC)/mesh
 PARTICLE = $(SRC)/particle
-MATRIX = $(SRC)/matrix 
\ No newline at end of file
+MATRIX = $(SRC)/matrix
+SOLVER = $(SRC)/solver
+SCENE = $(SRC)/scene 
\ No newline at end of file
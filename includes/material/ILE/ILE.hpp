@@ -44,23 +44,39 @@ protected:
 
 public:
     // CONSTRUCTOR
-    ILE();
+    ILE(const mpm::misc::PropertyList& properties);
 
     // CREATE THE MATERIAL
-    static MaterialBase* create() {
-        return new ILE();
+    static MaterialBase* create(const mpm::misc::PropertyList& properties) {
+        return new ILE(properties);
     }
 
     void computeElasticStiffnessMatrix();
 
     // COMPUTE STRESS
-    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain);
+    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES
+    void computeStress(const mpm::material::StressBatch& batch);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES IN LANES
+    void computeStress(const mpm::material::StressBatch& batch, const std::vector<MaterialBase*>& lanes);
 
     // GIVE DENSITY
     double giveDensity() {
         return density_;
     }
 
+    // GIVE CONSTRAINED MODULUS
+    double giveWaveModulus() {
+        return E_ * (1. - mu_) / ((1. + mu_) * (1. - 2. * mu_));
+    }
+
+    // GIVE K0 (NO LATERAL STRAIN)
+    double giveK0() {
+        return mu_ / (1. - mu_);
+    }
+
 
 protected:
     double density_;
@@ -1,4 +1,5 @@
-mpm::material::ILE::ILE() {
+mpm::material::ILE::ILE(const mpm::misc::PropertyList& properties)
+    : MaterialBase(properties) {
     setProperty("density", density_);
     setProperty("youngModulus", E_);
     setProperty("poissonRatio", mu_);
@@ -58,7 +59,7 @@ void mpm::material::ILE::computeElasticStiffnessMatrix() {
 }
 
 
-void mpm::material::ILE::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain) {
+void mpm::material::ILE::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double&) {
 
     VectorD6x1 dStrain = VectorD6x1::Zero();
     VectorD6x1 dStress = VectorD6x1::Zero();
@@ -73,3 +74,65 @@ void mpm::material::ILE::computeStress(const VectorDDOF& strain, VectorD6x1& str
     // }
     stress += dStress;
 }
+
+
+//! FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES
+//!           In plane strain only the normal strains (0, 1) are non-zero
+//!           in the strain increment used by computeStress, and the shear
+//!           row of De is zero: only the three normal stresses change, by
+//!           two products each instead of a 6x6 product. The components
+//!           are updated with vectorized Eigen array expressions.
+//!
+void mpm::material::ILE::computeStress(const mpm::material::StressBatch& batch) {
+
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    const unsigned n = batch.size;
+    const unsigned s = batch.stride;
+
+    if (dim == 2) {
+        Component strain0(batch.dStrain, n);
+        Component strain1(batch.dStrain + s, n);
+
+        Component(batch.stress, n)         += De(0,0) * strain0 + De(0,1) * strain1;
+        Component(batch.stress + s, n)     += De(1,0) * strain0 + De(1,1) * strain1;
+        Component(batch.stress + 2 * s, n) += De(2,0) * strain0 + De(2,1) * strain1;
+    }
+}
+
+
+//! FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES IN LANES
+//!           The update of the batch kernel above, with the stiffness of
+//!           the lane of each entry: the stiffness is spread over a chunk
+//!           of entries once, and the chunks of the batch are updated
+//!           with the same array expressions.
+//!
+void mpm::material::ILE::computeStress(const mpm::material::StressBatch& batch, const std::vector<MaterialBase*>& lanes) {
+
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    const unsigned n = batch.size;
+    const unsigned s = batch.stride;
+    const unsigned numLanes = lanes.size();
+    checkLanes(numLanes);
+
+    if (dim == 2) {
+        // De(r, c) of the normal stresses r = 0..2 and strains c = 0, 1
+        Eigen::Array<double, chunkSize, 6> stiffness;
+        for (unsigned j = 0; j < chunkSize; j++) {
+            const ILE* lane = static_cast<const ILE*>(lanes[j % numLanes]);
+            for (unsigned r = 0; r < 3; r++) {
+                stiffness(j, 2 * r) = lane->De(r, 0);
+                stiffness(j, 2 * r + 1) = lane->De(r, 1);
+            }
+        }
+
+        for (unsigned first = 0; first < n; first += chunkSize) {
+            const unsigned m = std::min(n - first, chunkSize);
+            Component strain0(batch.dStrain + first, m);
+            Component strain1(batch.dStrain + s + first, m);
+
+            Component(batch.stress + first, m)         += stiffness.col(0).head(m) * strain0 + stiffness.col(1).head(m) * strain1;
+            Component(batch.stress + s + first, m)     += stiffness.col(2).head(m) * strain0 + stiffness.col(3).head(m) * strain1;
+            Component(batch.stress + 2 * s + first, m) += stiffness.col(4).head(m) * strain0 + stiffness.col(5).head(m) * strain1;
+        }
+    }
+}
@@ -2,6 +2,7 @@
 #ifndef MPM_MATERIAL_MATERIALBASE_H
 #define MPM_MATERIAL_MATERIALBASE_H
 
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -13,12 +14,32 @@
 
 namespace mpm {
     namespace material {
+        struct StressBatch;
         class MaterialBase;
     }
 }
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+//! Strain increments, stresses and pressures of a batch of particles with
+//! the same material. The arrays are stored component by component:
+//! component k of particle i is at [k * stride + i]. dt is the length of
+//! the step of the increments (it changes during a run, e.g. with the
+//! artificial compressibility or on a multi-rate level).
+struct mpm::material::StressBatch {
+    unsigned size;
+    unsigned stride;
+    double dt;
+    // input: strain and volumetric strain increments
+    double* dStrain;            // dof components
+    double* dVolStrain;         // 1 component
+    // input/output: stress and pressure
+    double* stress;             // 6 components
+    double* pressure;           // 1 component
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
 class mpm::material::MaterialBase {
 
 protected:
@@ -30,15 +51,126 @@ protected:
     typedef Eigen::Matrix<double, 1, 6>   VectorD6x1;
 
 public:
+    // the parameters of the material
+    MaterialBase(const mpm::misc::PropertyList& properties)
+        : properties_(properties) { }
+
+    virtual ~MaterialBase() { }
+
     virtual double giveDensity() = 0;
-    virtual void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain) = 0;
 
+    // give the constrained (P-wave) modulus, which sets the wave speed and
+    // the stable time step (0 if the material does not give it)
+    virtual double giveWaveModulus() {
+        return 0.;
+    }
+
+    // give the coefficient of lateral stress at rest, K0, the ratio of the
+    // horizontal to the vertical stress under gravity (1 for a fluid)
+    virtual double giveK0() {
+        return 1.;
+    }
+
+    // give the (plastic) viscosity (0 for a solid)
+    virtual double giveViscosity() {
+        return 0.;
+    }
+
+    // give the largest apparent viscosity, which sets the viscous limit
+    // of the time step (the viscosity of a Newtonian fluid)
+    virtual double giveMaxViscosity() {
+        return this->giveViscosity();
+    }
+
+    // give whether the material is a weakly compressible fluid, whose
+    // bulk modulus is artificial (set by the artificial compressibility)
+    virtual bool isWeaklyCompressible() {
+        return false;
+    }
+
+    // set the bulk modulus of a weakly compressible fluid (nothing for
+    // the other materials)
+    virtual void setBulkModulus(const double&) { }
+
+    virtual void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt) = 0;
+
+    // compute the stress of a batch of particles. By default the particles
+    // are updated one by one with computeStress above.
+    virtual void computeStress(const mpm::material::StressBatch& batch) {
+        VectorDDOF strain;
+        VectorD6x1 stress;
+        for (unsigned i = 0; i < batch.size; i++) {
+            for (unsigned k = 0; k < dof; k++)
+                strain(k) = batch.dStrain[k * batch.stride + i];
+            for (unsigned k = 0; k < 6; k++)
+                stress(k) = batch.stress[k * batch.stride + i];
+            this->computeStress(strain, stress, batch.pressure[i], batch.dVolStrain[i], batch.dt);
+            for (unsigned k = 0; k < 6; k++)
+                batch.stress[k * batch.stride + i] = stress(k);
+        }
+    }
+
+    // compute the stress of a batch of particles in the lanes of an
+    // ensemble: entry i is a particle of the variant i % lanes.size(), whose
+    // material (of the type of this one, with its own parameters) is
+    // lanes[i % lanes.size()]. By default each entry is updated by the
+    // material of its lane.
+    virtual void computeStress(const mpm::material::StressBatch& batch, const std::vector<MaterialBase*>& lanes) {
+        VectorDDOF strain;
+        VectorD6x1 stress;
+        for (unsigned i = 0; i < batch.size; i++) {
+            for (unsigned k = 0; k < dof; k++)
+                strain(k) = batch.dStrain[k * batch.stride + i];
+            for (unsigned k = 0; k < 6; k++)
+                stress(k) = batch.stress[k * batch.stride + i];
+            lanes[i % lanes.size()]->computeStress(strain, stress, batch.pressure[i], batch.dVolStrain[i], batch.dt);
+            for (unsigned k = 0; k < 6; k++)
+                batch.stress[k * batch.stride + i] = stress(k);
+        }
+    }
+
+    // give the value of a parameter of this material (0 if it is not given)
     void setProperty(std::string propName, double& propValue) {
-        propValue = mpm::misc::propertyList[propName];
+        std::map<std::string, double>::const_iterator it = properties_.find(propName);
+        propValue = (it != properties_.end()) ? it->second : 0.;
+    }
+
+    // give the value of a parameter which the material needs; a missing
+    // parameter stops the run
+    void setRequiredProperty(const std::string& material, std::string propName, double& propValue) {
+        if (!properties_.count(propName)) {
+            std::cerr << "ERROR: " << material << " needs the parameter " << propName << " in material.dat" << "\n";
+            abort();
+        }
+        this->setProperty(propName, propValue);
+    }
+
+    // as setRequiredProperty, for a parameter which must be positive
+    void setPositiveProperty(const std::string& material, std::string propName, double& propValue) {
+        this->setRequiredProperty(material, propName, propValue);
+        if (!(propValue > 0.)) {
+            std::cerr << "ERROR: " << material << " needs " << propName << " > 0 (" << propValue << " given)" << "\n";
+            abort();
+        }
     }
 
 protected:
-    double dt = mpm::misc::dt;
+    // parameters of this material, copied when the material is created,
+    // so materials with the same keys do not overwrite each other
+    mpm::misc::PropertyList properties_;
+
+    // number of particles processed at a time by the vectorized kernels
+    // which need temporaries (these are then kept on the stack)
+    static const unsigned chunkSize = 64;
+
+    // check that a chunk holds whole sets of lanes, so entry j of every
+    // chunk is in lane j % lanes
+    static void checkLanes(const unsigned& lanes) {
+        if (!lanes || chunkSize % lanes) {
+            std::cerr << "ERROR: the material kernels take a number of lanes which divides " << chunkSize << " (" << lanes << " given)" << "\n";
+            abort();
+        }
+    }
 
 };
 
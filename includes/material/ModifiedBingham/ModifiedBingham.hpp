@@ -15,6 +15,8 @@ File: ModifiedBingham.hpp
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 // mpm header files
 #include "MaterialBase.hpp"
@@ -41,19 +43,25 @@ protected:
     typedef Eigen::Matrix<double, 1, dof> VectorDDOF;
     typedef Eigen::Matrix<double, 1, 6>   VectorD6x1;
 
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    typedef Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, chunkSize, 1> Chunk;
+
     //%%%%%%%%%%%% FUNCTIONS %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
 public:
 
     // F1. CONSTRUCTOR
-    ModifiedBingham();
+    ModifiedBingham(const mpm::misc::PropertyList& properties);
 
     // F2. CREATE THE MATERIAL
-    static MaterialBase* create() {
-        return new ModifiedBingham();
+    static MaterialBase* create(const mpm::misc::PropertyList& properties) {
+        return new ModifiedBingham(properties);
     }
 
     // COMPUTE STRESS
-    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain) { };
+    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES
+    void computeStress(const mpm::material::StressBatch& batch);
 
     //%%%%%%%%%%% GIVE FUNCTIONS %%%%%%%%%%%%%%%%%%%%%%%%%%
     // G1. GIVE DENSITY
@@ -61,12 +69,40 @@ public:
         return density_;
     }
 
+    // GIVE CONSTRAINED MODULUS (THE BULK MODULUS)
+    double giveWaveModulus() {
+        return bulkModulus_;
+    }
+
+    // GIVE VISCOSITY
+    double giveViscosity() {
+        return viscosity_;
+    }
+
+    // GIVE MAXIMUM VISCOSITY (THE REGULARISED VISCOSITY AT REST)
+    double giveMaxViscosity() {
+        return viscosity_ + regularisation_ * yieldStress_;
+    }
+
+    // WEAKLY COMPRESSIBLE FLUID
+    bool isWeaklyCompressible() {
+        return true;
+    }
+
+    // SET BULK MODULUS (ARTIFICIAL COMPRESSIBILITY)
+    void setBulkModulus(const double& bulkModulus) {
+        bulkModulus_ = bulkModulus;
+    }
+
 
     //%%%%%%%%%%% MATERIAL PARAMETRS %%%%%%%%%%%%%%%%%%%%%%
 public:
     double density_;
     double viscosity_;
     double yieldStress_;
+    double bulkModulus_;
+    // Papanastasiou exponent m (s)
+    double regularisation_;
 };
 
 #include "ModifiedBingham.ipp"
@@ -1,3 +1,85 @@
-mpm::material::ModifiedBingham::ModifiedBingham() {
-    setProperty("density", density_);
+mpm::material::ModifiedBingham::ModifiedBingham(const mpm::misc::PropertyList& properties)
+    : MaterialBase(properties) {
+    setPositiveProperty("ModifiedBingham", "density", density_);
+    setRequiredProperty("ModifiedBingham", "viscosity", viscosity_);
+    setRequiredProperty("ModifiedBingham", "yieldStress", yieldStress_);
+    setPositiveProperty("ModifiedBingham", "bulkModulus", bulkModulus_);
+    setPositiveProperty("ModifiedBingham", "regularisation", regularisation_);
+    if (!(viscosity_ >= 0.) || !(yieldStress_ >= 0.)) {
+        std::cerr << "ERROR: ModifiedBingham needs viscosity >= 0 and yieldStress >= 0" << "\n";
+        abort();
+    }
+}
+
+
+//! FUNCTION: COMPUTE STRESS
+//!           The stress of one particle is computed as a batch of one, so
+//!           that both versions give the same result.
+//!
+void mpm::material::ModifiedBingham::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt) {
+    double dStrain[dof];
+    double dVol = dVolStrain;
+    for (unsigned k = 0; k < dof; k++)
+        dStrain[k] = strain(k);
+
+    mpm::material::StressBatch batch;
+    batch.size = 1;
+    batch.stride = 1;
+    batch.dt = dt;
+    batch.dStrain = dStrain;
+    batch.dVolStrain = &dVol;
+    batch.stress = stress.data();
+    batch.pressure = &pressure;
+    this->computeStress(batch);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES
+          Bingham fluid regularised as proposed by Papanastasiou (1987):
+            eta = viscosity + yieldStress * (1 - exp(-m * gamma)) / gamma
+          where gamma = sqrt(2 D:D) is the equivalent shear rate of the
+          deviatoric strain rate D = dev(dStrain) / dt, dt the step of
+          the increments given with the batch, and m the regularisation
+          exponent. The apparent viscosity is finite
+          (viscosity + m * yieldStress) when gamma is zero, so rigid and
+          flowing particles need no separate branch. The pressure is
+          updated with the bulk modulus as in the Newtonian fluid and
+            stress = -pressure + 2 eta D.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::material::ModifiedBingham::computeStress(const mpm::material::StressBatch& batch) {
+
+    const unsigned s = batch.stride;
+    const double dt = batch.dt;
+    if (dim != 2)
+        return;
+
+    for (unsigned first = 0; first < batch.size; first += chunkSize) {
+        const unsigned n = std::min(batch.size - first, chunkSize);
+        Component strain0(batch.dStrain + first, n);
+        Component strain1(batch.dStrain + s + first, n);
+        Component strain2(batch.dStrain + 2 * s + first, n);
+        Component dVolStrain(batch.dVolStrain + first, n);
+        Component pressure(batch.pressure + first, n);
+
+        pressure -= bulkModulus_ * dVolStrain;
+
+        // deviatoric strain rate, over the step of the increments (dxy is the tensor shear component)
+        Chunk volumetric = (strain0 + strain1) / (3. * dt);
+        Chunk dxx = strain0 / dt - volumetric;
+        Chunk dyy = strain1 / dt - volumetric;
+        Chunk dxy = 0.5 * strain2 / dt;
+        Chunk shearRate = (2. * (dxx.square() + dyy.square() + volumetric.square() + 2. * dxy.square())).sqrt();
+
+        // apparent viscosity; -expm1(-x) = 1 - exp(-x) without cancellation
+        Chunk yielded = -(-regularisation_ * shearRate).expm1() / shearRate;
+        Chunk eta = viscosity_ + yieldStress_ * (shearRate > 0.).select(yielded, regularisation_);
+
+        Component(batch.stress + first, n)         = -pressure + 2. * eta * dxx;
+        Component(batch.stress + s + first, n)     = -pressure + 2. * eta * dyy;
+        Component(batch.stress + 2 * s + first, n) = -pressure - 2. * eta * volumetric;
+        Component(batch.stress + 3 * s + first, n) = 2. * eta * dxy;
+        Component(batch.stress + 4 * s + first, n).setZero();
+        Component(batch.stress + 5 * s + first, n).setZero();
+    }
 }
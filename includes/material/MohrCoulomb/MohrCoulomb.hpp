@@ -15,6 +15,9 @@ File: MohrCoulomb.hpp
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
 
 // mpm header files
 #include "MaterialBase.hpp"
@@ -41,17 +44,24 @@ protected:
     typedef Eigen::Matrix<double, 1, dof> VectorDDOF;
     typedef Eigen::Matrix<double, 1, 6>   VectorD6x1;
 
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    typedef Eigen::Array<double, Eigen::Dynamic, 1, Eigen::ColMajor, chunkSize, 1> Chunk;
+    typedef Eigen::Array<bool, Eigen::Dynamic, 1, Eigen::ColMajor, chunkSize, 1>   Mask;
+
 public:
     // CONSTRUCTOR
-    MohrCoulomb();
+    MohrCoulomb(const mpm::misc::PropertyList& properties);
 
     // CREATE THE MATERIAL
-    static MaterialBase* create() {
-        return new MohrCoulomb();
+    static MaterialBase* create(const mpm::misc::PropertyList& properties) {
+        return new MohrCoulomb(properties);
     }
 
     // COMPUTE STRESS
-    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain) { };
+    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES
+    void computeStress(const mpm::material::StressBatch& batch);
 
 
 
@@ -60,9 +70,39 @@ public:
         return density_;
     }
 
+    // GIVE CONSTRAINED MODULUS
+    double giveWaveModulus() {
+        return a1_;
+    }
+
+    // GIVE K0 (JAKY)
+    double giveK0() {
+        return 1. - sinPhi_;
+    }
+
+
+private:
+    // return the ordered principal stresses s1 >= s2 >= s3 to the yield
+    // surface where the yield function f is positive
+    void return_mapping(Chunk& s1, Chunk& s2, Chunk& s3, const Chunk& f) const;
 
 protected:
     double density_;
+    double E_;
+    double mu_;
+    double cohesion_;
+    double phi_;
+    double psi_;
+
+    // elastic constants: K, G and the plane strain coefficients of De
+    double K_, G_, a1_, a2_;
+    // sin/cos of the friction and dilation angles, stress at the apex
+    double sinPhi_, cosPhi_, sinPsi_, apex_;
+    // change of the principal stresses for a unit plastic multiplier
+    // (A1 on the largest, B on the intermediate, A3 on the smallest)
+    double A1_, B_, A3_;
+    // coefficients of the returns to the main plane and to the edges
+    double a_, bRight_, bLeft_;
 };
 
 #include "MohrCoulomb.ipp"
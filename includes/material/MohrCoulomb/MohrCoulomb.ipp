@@ -1,3 +1,182 @@
-mpm::material::MohrCoulomb::MohrCoulomb() {
-    setProperty("density", density_);
+mpm::material::MohrCoulomb::MohrCoulomb(const mpm::misc::PropertyList& properties)
+    : MaterialBase(properties) {
+    setPositiveProperty("MohrCoulomb", "density", density_);
+    setPositiveProperty("MohrCoulomb", "youngModulus", E_);
+    setRequiredProperty("MohrCoulomb", "poissonRatio", mu_);
+    setRequiredProperty("MohrCoulomb", "cohesion", cohesion_);
+    setRequiredProperty("MohrCoulomb", "frictionAngle", phi_);
+    setRequiredProperty("MohrCoulomb", "dilationAngle", psi_);
+    // the angles are in radians; a dilation angle above the friction
+    // angle would create energy in the plastic flow
+    if (!(mu_ >= 0. && mu_ < 0.5) || !(cohesion_ >= 0.) || !(phi_ >= 0. && phi_ < 0.5 * M_PI) || !(psi_ >= 0. && psi_ <= phi_)) {
+        std::cerr << "ERROR: MohrCoulomb needs 0 <= poissonRatio < 0.5, cohesion >= 0 and 0 <= dilationAngle <= frictionAngle < pi/2 (radians)" << "\n";
+        abort();
+    }
+
+    K_ = E_ / (3.0 * (1. - 2. * mu_));
+    G_ = E_ / (2.0 * (1. + mu_));
+    a1_ = K_ + (4.0 / 3.0) * G_;
+    a2_ = K_ - (2.0 / 3.0) * G_;
+
+    sinPhi_ = std::sin(phi_);
+    cosPhi_ = std::cos(phi_);
+    sinPsi_ = std::sin(psi_);
+    // without friction there is no apex
+    apex_ = (sinPhi_ > 0.) ? cohesion_ * cosPhi_ / sinPhi_ : std::numeric_limits<double>::max();
+
+    A1_ = 2. * G_ * (1. + sinPsi_ / 3.) + 2. * K_ * sinPsi_;
+    B_  = (4. * G_ / 3. - 2. * K_) * sinPsi_;
+    A3_ = 2. * G_ * (1. - sinPsi_ / 3.) - 2. * K_ * sinPsi_;
+
+    a_ = 4. * G_ * (1. + sinPhi_ * sinPsi_ / 3.) + 4. * K_ * sinPhi_ * sinPsi_;
+    bRight_ = 2. * G_ * (1. + sinPhi_ + sinPsi_ - sinPhi_ * sinPsi_ / 3.) + 4. * K_ * sinPhi_ * sinPsi_;
+    bLeft_  = 2. * G_ * (1. - sinPhi_ - sinPsi_ - sinPhi_ * sinPsi_ / 3.) + 4. * K_ * sinPhi_ * sinPsi_;
+}
+
+
+//! FUNCTION: COMPUTE STRESS
+//!           The stress of one particle is computed as a batch of one, so
+//!           that both versions give the same result.
+//!
+void mpm::material::MohrCoulomb::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt) {
+    double dStrain[dof];
+    double dVol = dVolStrain;
+    for (unsigned k = 0; k < dof; k++)
+        dStrain[k] = strain(k);
+
+    mpm::material::StressBatch batch;
+    batch.size = 1;
+    batch.stride = 1;
+    batch.dt = dt;
+    batch.dStrain = dStrain;
+    batch.dVolStrain = &dVol;
+    batch.stress = stress.data();
+    batch.pressure = &pressure;
+    this->computeStress(batch);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES
+          Elastic-perfectly plastic Mohr-Coulomb in plane strain (tension
+          positive), with the closed-form return mapping in principal
+          stress space:
+            1. elastic trial stress;
+            2. principal stresses: the two in-plane ones from the Mohr
+               circle, and the out-of-plane stress;
+            3. return to the yield surface (return_mapping);
+            4. rotation back with the principal directions of the trial
+               stress.
+          Every step is computed for all particles of a chunk and the
+          elastic/plastic cases are chosen per particle with select(), so
+          the loop has no branches per particle and is vectorized.
+          The pressure is minus the mean stress.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::material::MohrCoulomb::computeStress(const mpm::material::StressBatch& batch) {
+
+    const unsigned s = batch.stride;
+    if (dim != 2)
+        return;
+
+    for (unsigned first = 0; first < batch.size; first += chunkSize) {
+        const unsigned n = std::min(batch.size - first, chunkSize);
+        Component strain0(batch.dStrain + first, n);
+        Component strain1(batch.dStrain + s + first, n);
+        Component strain2(batch.dStrain + 2 * s + first, n);
+        Component stressXX(batch.stress + first, n);
+        Component stressYY(batch.stress + s + first, n);
+        Component stressZZ(batch.stress + 2 * s + first, n);
+        Component stressXY(batch.stress + 3 * s + first, n);
+        Component pressure(batch.pressure + first, n);
+
+        // 1. elastic trial stress
+        Chunk sxx = stressXX + a1_ * strain0 + a2_ * strain1;
+        Chunk syy = stressYY + a2_ * strain0 + a1_ * strain1;
+        Chunk szz = stressZZ + a2_ * (strain0 + strain1);
+        Chunk sxy = stressXY + G_ * strain2;
+
+        // 2. in-plane principal stresses sa >= sb and their direction
+        Chunk centre = 0.5 * (sxx + syy);
+        Chunk half = 0.5 * (sxx - syy);
+        Chunk radius = (half.square() + sxy.square()).sqrt();
+        Chunk sa = centre + radius;
+        Chunk sb = centre - radius;
+        Chunk cos2 = (radius > 0.).select(half / radius, 1.);
+        Chunk sin2 = (radius > 0.).select(sxy / radius, 0.);
+
+        // ordered principal stresses: szz is the largest, the smallest or
+        // the intermediate one
+        Mask zzLargest = (szz > sa);
+        Mask zzSmallest = (szz < sb);
+        Chunk s1 = zzLargest.select(szz, sa);
+        Chunk s2 = zzLargest.select(sa, zzSmallest.select(sb, szz));
+        Chunk s3 = zzSmallest.select(szz, sb);
+
+        // 3. return mapping
+        Chunk f = (s1 - s3) + (s1 + s3) * sinPhi_ - 2. * cohesion_ * cosPhi_;
+        this->return_mapping(s1, s2, s3, f);
+
+        // 4. back to the in-plane and out-of-plane stresses
+        Chunk saNew = zzLargest.select(s2, s1);
+        Chunk sbNew = zzSmallest.select(s2, s3);
+        Chunk szzNew = zzLargest.select(s1, zzSmallest.select(s3, s2));
+        Chunk centreNew = 0.5 * (saNew + sbNew);
+        Chunk radiusNew = 0.5 * (saNew - sbNew);
+
+        // elastic particles keep their trial stress
+        stressXX = (f > 0.).select(centreNew + radiusNew * cos2, sxx);
+        stressYY = (f > 0.).select(centreNew - radiusNew * cos2, syy);
+        stressZZ = (f > 0.).select(szzNew, szz);
+        stressXY = (f > 0.).select(radiusNew * sin2, sxy);
+        Component(batch.stress + 4 * s + first, n).setZero();
+        Component(batch.stress + 5 * s + first, n).setZero();
+        pressure = -(stressXX + stressYY + stressZZ) / 3.;
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: RETURN MAPPING
+          Closed-form return of perfect plasticity (de Souza Neto et al.,
+          Computational Methods for Plasticity, section 8.2), with yield
+          function f = (s1 - s3) + (s1 + s3) sin(phi) - 2 c cos(phi):
+            main plane: one multiplier, f / a;
+            edge:       two multipliers (planes s1-s3 and s1-s2 on the
+                        right edge, s1-s3 and s2-s3 on the left edge),
+                        from a 2x2 linear system;
+            apex:       all principal stresses at c cot(phi).
+          All returns are computed and the valid one is selected: the main
+          plane if it keeps s1 >= s2 >= s3, else the edge if its mean
+          stress is below the apex, else the apex.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::material::MohrCoulomb::return_mapping(Chunk& s1, Chunk& s2, Chunk& s3, const Chunk& f) const {
+
+    const double yieldCohesion = 2. * cohesion_ * cosPhi_;
+
+    // main plane
+    Chunk dGamma = f / a_;
+    Chunk m1 = s1 - dGamma * A1_;
+    Chunk m2 = s2 + dGamma * B_;
+    Chunk m3 = s3 + dGamma * A3_;
+
+    // right edge (s1 - s3 and s1 - s2) and left edge (s1 - s3 and s2 - s3)
+    Chunk fRight = (s1 - s2) + (s1 + s2) * sinPhi_ - yieldCohesion;
+    Chunk fLeft  = (s2 - s3) + (s2 + s3) * sinPhi_ - yieldCohesion;
+    Chunk aRight = (a_ * f - bRight_ * fRight) / (a_ * a_ - bRight_ * bRight_);
+    Chunk bRight = (a_ * fRight - bRight_ * f) / (a_ * a_ - bRight_ * bRight_);
+    Chunk aLeft  = (a_ * f - bLeft_ * fLeft) / (a_ * a_ - bLeft_ * bLeft_);
+    Chunk bLeft  = (a_ * fLeft - bLeft_ * f) / (a_ * a_ - bLeft_ * bLeft_);
+
+    Mask right = ((1. - sinPsi_) * s1 - 2. * s2 + (1. + sinPsi_) * s3) > 0.;
+    Chunk e1 = right.select(s1 - (aRight + bRight) * A1_, s1 - aLeft * A1_ + bLeft * B_);
+    Chunk e2 = right.select(s2 + aRight * B_ + bRight * A3_, s2 + aLeft * B_ - bLeft * A1_);
+    Chunk e3 = right.select(s3 + aRight * A3_ + bRight * B_, s3 + (aLeft + bLeft) * A3_);
+
+    Mask plastic = (f > 0.);
+    Mask onMainPlane = (m1 >= m2) && (m2 >= m3);
+    Mask onEdge = ((e1 + e2 + e3) / 3. <= apex_);
+
+    s1 = plastic.select(onMainPlane.select(m1, onEdge.select(e1, apex_)), s1);
+    s2 = plastic.select(onMainPlane.select(m2, onEdge.select(e2, apex_)), s2);
+    s3 = plastic.select(onMainPlane.select(m3, onEdge.select(e3, apex_)), s3);
 }
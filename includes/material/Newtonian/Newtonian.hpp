@@ -44,15 +44,21 @@ protected:
 public:
 
     // CONSTRUCTOR
-    Newtonian();
+    Newtonian(const mpm::misc::PropertyList& properties);
 
     // CREATE THE MATERIAL
-    static MaterialBase* create() {
-        return new Newtonian();
+    static MaterialBase* create(const mpm::misc::PropertyList& properties) {
+        return new Newtonian(properties);
     }
 
     // COMPUTE STRESS
-    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain);
+    void computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES
+    void computeStress(const mpm::material::StressBatch& batch);
+
+    // COMPUTE STRESS OF A BATCH OF PARTICLES IN LANES
+    void computeStress(const mpm::material::StressBatch& batch, const std::vector<MaterialBase*>& lanes);
 
 
 
@@ -61,11 +67,30 @@ public:
         return density_;
     }
 
+    // GIVE CONSTRAINED MODULUS (THE BULK MODULUS)
+    double giveWaveModulus() {
+        return bulkModulus_;
+    }
+
+    // GIVE VISCOSITY
+    double giveViscosity() {
+        return viscosity_;
+    }
+
+    // WEAKLY COMPRESSIBLE FLUID
+    bool isWeaklyCompressible() {
+        return true;
+    }
+
+    // SET BULK MODULUS (ARTIFICIAL COMPRESSIBILITY)
+    void setBulkModulus(const double& bulkModulus) {
+        bulkModulus_ = bulkModulus;
+    }
+
 protected:
     double density_;
     double viscosity_;
     double bulkModulus_;
-    double dt_;
 };
 
 #include "Newtonian.ipp"
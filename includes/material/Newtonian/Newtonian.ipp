@@ -1,23 +1,101 @@
-mpm::material::Newtonian::Newtonian() {
+mpm::material::Newtonian::Newtonian(const mpm::misc::PropertyList& properties)
+    : MaterialBase(properties) {
     setProperty("density", density_);
     setProperty("viscosity", viscosity_);
     setProperty("bulkModulus", bulkModulus_);
-    dt_ = mpm::misc::dt;
 }
 
 
-void mpm::material::Newtonian::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain) {
+//! The viscous stress follows the strain rate, the strain increment of
+//! the step divided by dt.
+void mpm::material::Newtonian::computeStress(const VectorDDOF& strain, VectorD6x1& stress, double& pressure, const double& dVolStrain, const double& dt) {
 
     double dPressure = -(bulkModulus_ * dVolStrain);
     pressure += dPressure;
 
     if (dim == 2) {
-        stress(0) = -pressure + (2 * viscosity_ * strain(0)) - (2 * viscosity_ * (strain(0) + strain(1)) / 3);
-        stress(1) = -pressure + (2 * viscosity_ * strain(1)) - (2 * viscosity_ * (strain(0) + strain(1)) / 3);
-        stress(2) = - pressure - (2 * viscosity_ * (strain(0) + strain(1)) / 3);
-        stress(3) = viscosity_ * strain(2);
+        const VectorDDOF rate = strain / dt;
+        stress(0) = -pressure + (2 * viscosity_ * rate(0)) - (2 * viscosity_ * (rate(0) + rate(1)) / 3);
+        stress(1) = -pressure + (2 * viscosity_ * rate(1)) - (2 * viscosity_ * (rate(0) + rate(1)) / 3);
+        stress(2) = - pressure - (2 * viscosity_ * (rate(0) + rate(1)) / 3);
+        stress(3) = viscosity_ * rate(2);
         stress(4) = 0.0;
         stress(5) = 0.0;
     } 
 
 }
+
+
+//! FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES
+//!           Same update as computeStress, written as Eigen array
+//!           expressions over each component of the batch so that they
+//!           are vectorized (2 to 8 particles per instruction, depending
+//!           on the instruction set enabled by SIMD_FLAGS). The order of
+//!           the operations is the one of computeStress.
+//!
+void mpm::material::Newtonian::computeStress(const mpm::material::StressBatch& batch) {
+
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    const unsigned n = batch.size;
+    const unsigned s = batch.stride;
+
+    if (dim == 2) {
+        const double dt = batch.dt;
+        Component strain0(batch.dStrain, n);
+        Component strain1(batch.dStrain + s, n);
+        Component strain2(batch.dStrain + 2 * s, n);
+        Component dVolStrain(batch.dVolStrain, n);
+        Component pressure(batch.pressure, n);
+
+        pressure -= bulkModulus_ * dVolStrain;
+        Component(batch.stress, n)         = -pressure + (2 * viscosity_ * (strain0 / dt)) - (2 * viscosity_ * (strain0 / dt + strain1 / dt) / 3);
+        Component(batch.stress + s, n)     = -pressure + (2 * viscosity_ * (strain1 / dt)) - (2 * viscosity_ * (strain0 / dt + strain1 / dt) / 3);
+        Component(batch.stress + 2 * s, n) = - pressure - (2 * viscosity_ * (strain0 / dt + strain1 / dt) / 3);
+        Component(batch.stress + 3 * s, n) = viscosity_ * (strain2 / dt);
+        Component(batch.stress + 4 * s, n).setZero();
+        Component(batch.stress + 5 * s, n).setZero();
+    }
+}
+
+
+//! FUNCTION: COMPUTE STRESS OF A BATCH OF PARTICLES IN LANES
+//!           The update of the batch kernel above, with the viscosity and
+//!           the bulk modulus of the lane of each entry, spread over a
+//!           chunk of entries once.
+//!
+void mpm::material::Newtonian::computeStress(const mpm::material::StressBatch& batch, const std::vector<MaterialBase*>& lanes) {
+
+    typedef Eigen::Map<Eigen::ArrayXd> Component;
+    const unsigned n = batch.size;
+    const unsigned s = batch.stride;
+    const unsigned numLanes = lanes.size();
+    checkLanes(numLanes);
+
+    if (dim == 2) {
+        Eigen::Array<double, chunkSize, 1> viscosity, bulkModulus;
+        for (unsigned j = 0; j < chunkSize; j++) {
+            const Newtonian* lane = static_cast<const Newtonian*>(lanes[j % numLanes]);
+            viscosity(j) = lane->viscosity_;
+            bulkModulus(j) = lane->bulkModulus_;
+        }
+
+        const double dt = batch.dt;
+        for (unsigned first = 0; first < n; first += chunkSize) {
+            const unsigned m = std::min(n - first, chunkSize);
+            Component strain0(batch.dStrain + first, m);
+            Component strain1(batch.dStrain + s + first, m);
+            Component strain2(batch.dStrain + 2 * s + first, m);
+            Component dVolStrain(batch.dVolStrain + first, m);
+            Component pressure(batch.pressure + first, m);
+            const auto mu = viscosity.head(m);
+
+            pressure -= bulkModulus.head(m) * dVolStrain;
+            Component(batch.stress + first, m)         = -pressure + (2 * mu * (strain0 / dt)) - (2 * mu * (strain0 / dt + strain1 / dt) / 3);
+            Component(batch.stress + s + first, m)     = -pressure + (2 * mu * (strain1 / dt)) - (2 * mu * (strain0 / dt + strain1 / dt) / 3);
+            Component(batch.stress + 2 * s + first, m) = - pressure - (2 * mu * (strain0 / dt + strain1 / dt) / 3);
+            Component(batch.stress + 3 * s + first, m) = mu * (strain2 / dt);
+            Component(batch.stress + 4 * s + first, m).setZero();
+            Component(batch.stress + 5 * s + first, m).setZero();
+        }
+    }
+}
@@ -43,11 +43,13 @@ protected:
 
 public:
     // F1. CONSTRUCTOR
-    ReadMaterial(std::ifstream& matFile);
+    //! a parameter given in "overrides" replaces the value of
+    //! material.dat in every material
+    ReadMaterial(std::istream& matFile, const mpm::misc::PropertyList& overrides = mpm::misc::PropertyList());
 
 private:
     // F2. REGISTER MATERIALS
-    MaterialBasePtr registerMaterial(std::string& name);
+    MaterialBasePtr registerMaterial(std::string& name, const mpm::misc::PropertyList& properties);
 
     //%%%%%%%%%%%%%%%% GIVE FUNCTIONS %%%%%%%%%%%%%%%%%
 
@@ -1,8 +1,11 @@
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 F1. FUNCTION: CONSTRUCTOR
-              This function reads material.dat file and creates materials
+              This function reads material.dat file and creates materials.
+              Each material keeps a copy of its own parameters only. The
+              overrides (e.g. the viscosity of one case of an ensemble)
+              are applied to the parameters of every material.
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
-mpm::material::ReadMaterial::ReadMaterial(std::ifstream& matFile) {
+mpm::material::ReadMaterial::ReadMaterial(std::istream& matFile, const mpm::misc::PropertyList& overrides) {
 
     unsigned numMatTypes;
     std::string materialName;
@@ -22,11 +25,14 @@ mpm::material::ReadMaterial::ReadMaterial(std::ifstream& matFile) {
         std::getline(matFile, line);
         std::istringstream inpMat(line);
         inpMat >> materialName >> numParameters;
+        mpm::misc::PropertyList properties;
         for (unsigned j = 0; j < numParameters; j++) {
             std::getline(matFile, line);
-            mpm::misc::READ_PROPERTIES(line);
+            mpm::misc::READ_PROPERTIES(line, properties);
         }
-        MaterialBasePtr material = this -> registerMaterial(materialName);
+        for (const auto& parameter : overrides)
+            properties[parameter.first] = parameter.second;
+        MaterialBasePtr material = this -> registerMaterial(materialName, properties);
         materialPtrs_.push_back(material); 
     }
 }
@@ -36,21 +42,21 @@ F2. FUNCTION: REGISTER MATERIAL
               This function reads material.dat file and creates materials
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 typedef mpm::material::MaterialBase* MaterialBasePtr;
-MaterialBasePtr mpm::material::ReadMaterial::registerMaterial(std::string& name) {
+MaterialBasePtr mpm::material::ReadMaterial::registerMaterial(std::string& name, const mpm::misc::PropertyList& properties) {
 
     MaterialBasePtr materialPtr = NULL;
 
     if (name == "Newtonian") { 
-        materialPtr = mpm::material::Newtonian::create();
+        materialPtr = mpm::material::Newtonian::create(properties);
     }
     else if (name == "ModifiedBingham") {
-        materialPtr = mpm::material::ModifiedBingham::create();
+        materialPtr = mpm::material::ModifiedBingham::create(properties);
     }
     else if (name == "MohrCoulomb") {
-        materialPtr = mpm::material::MohrCoulomb::create();
+        materialPtr = mpm::material::MohrCoulomb::create(properties);
     }
     else if (name == "ILE") {
-        materialPtr = mpm::material::ILE::create();
+        materialPtr = mpm::material::ILE::create(properties);
     }
     else {
         std::cerr << "ERROR: no material named " << name << "\n";
@@ -2,6 +2,10 @@
                         Material Point Method
                        Author: Shyamini Kularathna
                          University of Cambridge
+NOTE: The input files of a case are opened (and input.dat parsed) here;
+      the mesh, particles and materials are built from them by
+      CaseInput and Simulation. The results are written here.
+
 FILE: FileHandle.hpp
 **************************************************************************/
 #ifndef MPM_FILEHANDLE_H
@@ -21,12 +25,11 @@ FILE: FileHandle.hpp
 // mpm miscellaneous header files
 #include "Verify.hpp"
 #include "PropertyParse.hpp"
+#include "Timer.hpp"
 
 // mpm main header files
-#include "Mesh.hpp"
 #include "MpmParticle.hpp"
-#include "MaterialBase.hpp"
-#include "ReadMaterial.hpp"
+#include "TaskGraph.hpp"
 
 namespace mpm {
     class FileHandle;
@@ -37,20 +40,23 @@ class mpm::FileHandle {
 protected:
     typedef boost::filesystem::path path_;
 
-    typedef mpm::Mesh*          MeshPtr;
     typedef mpm::MpmParticle*   ParticleSetPtr;
 
 public:
     // CONSTRUCTOR
     FileHandle(path_& p);
 
-    // READ THE MESH
-    MeshPtr read_mesh();
+    // WRITE THE PARTICLE DATA OF A STEP (VTK)
+    void WriteData(const unsigned& step, const ParticleSetPtr& particleSet);
+
+    // WRITE THE PARTICLE DATA OF A STEP TO A GIVEN DIRECTORY
+    static void WriteData(const std::string& directory, const unsigned& step, const ParticleSetPtr& particleSet);
 
-    // READ PARTICLES
-    ParticleSetPtr read_particles();
+    // WRITE THE CHROME TRACE OF THE PHASE TIMERS
+    void WriteTrace(mpm::misc::PhaseTimer& timer);
 
-    void WriteData(const unsigned& step, const ParticleSetPtr& particleSet); 
+    // WRITE THE TASK GRAPH OF A STEP (GRAPHVIZ DOT)
+    void WriteTaskGraph(const mpm::TaskGraph& graph);
 
 public:
     std::ifstream inputStream;
@@ -65,7 +71,8 @@ public:
     std::ifstream feedParticleStream;
 
     std::string ResultsDir;
-    std::vector<mpm::material::MaterialBase*> materials;
+    // parameters of input.dat
+    mpm::misc::Settings settings;
 };
 
 #include "FileHandle.ipp"
@@ -15,8 +15,7 @@ mpm::FileHandle::FileHandle(path_& p) {
     std::string iStressFile = p.string() + "/inputFiles/initStress.dat";
     std::string velConstraintFile = p.string() + "/inputFiles/velCon.dat";
     std::string fricConstraintFile = p.string() + "/inputFiles/fricCon.dat";
-
-    // std::string feedParticleFile = p.string() + "/inputFiles/feedParticle.dat";
+    std::string feedParticleFile = p.string() + "/inputFiles/feedParticle.dat";
 
     // define the input file stream for reading files
     inputStream.open(inputFile.c_str());
@@ -25,10 +24,13 @@ mpm::FileHandle::FileHandle(path_& p) {
     meshDataStream.open(meshFile.c_str());
     particleStream.open(particleFile.c_str());
     materialStream.open(materialFile.c_str());
+    // optional: without initStress.dat the stress is zero or generated
+    // (initialStress)
     iStressStream.open(iStressFile.c_str());
     velConstraintStream.open(velConstraintFile.c_str());
     fricConstraintStream.open(fricConstraintFile.c_str());
-    // feedParticleStream.open(feedParticleFile.c_str());
+    // optional: without feedParticle.dat there are no sources and sinks
+    feedParticleStream.open(feedParticleFile.c_str());
 
     // verify the file is open
     mpm::misc::VERIFY_OPEN(inputStream, inputFile);
@@ -37,10 +39,8 @@ mpm::FileHandle::FileHandle(path_& p) {
     mpm::misc::VERIFY_OPEN(meshDataStream, meshFile);
     mpm::misc::VERIFY_OPEN(particleStream, particleFile);
     mpm::misc::VERIFY_OPEN(materialStream, materialFile);
-    mpm::misc::VERIFY_OPEN(iStressStream, iStressFile);
     mpm::misc::VERIFY_OPEN(velConstraintStream, velConstraintFile);
     mpm::misc::VERIFY_OPEN(fricConstraintStream, fricConstraintFile);
-    // mpm::misc::VERIFY_OPEN(feedParticleStream, feedParticleFile);
 
 
     // create the directory for the results
@@ -58,28 +58,7 @@ mpm::FileHandle::FileHandle(path_& p) {
 
     std::string line;
     while (std::getline(inputStream, line))
-        mpm::misc::PARSE_PROPERTIES(line);
-}
-
-
-
-typedef mpm::Mesh* MeshPtr;
-MeshPtr mpm::FileHandle::read_mesh() {
-    MeshPtr mesh_ = new mpm::Mesh(meshDataStream);
-    mesh_->read_nodes_and_elements(nodeStream, elementStream);
-    mesh_->read_general_constraints(velConstraintStream);
-    return mesh_;
-}
-
-mpm::MpmParticle* mpm::FileHandle::read_particles() {
-    mpm::MpmParticle* particle_ = new mpm::MpmParticle();
-    particle_->read_particles(particleStream, iStressStream);
-
-    // assign material to particles
-    mpm::material::ReadMaterial mat(materialStream);
-    materials = mat.givePtrsToMaterials();
-    particle_->assign_material_to_particles(materials);
-    return particle_;
+        mpm::misc::PARSE_PROPERTIES(line, settings);
 }
 
 
@@ -88,12 +67,17 @@ mpm::MpmParticle* mpm::FileHandle::read_particles() {
 //!                 This function write the particle data to .vtk file.
 //!
 void mpm::FileHandle::WriteData(const unsigned& step, const ParticleSetPtr& particleSet) {
+    WriteData(ResultsDir, step, particleSet);
+}
+
+
+void mpm::FileHandle::WriteData(const std::string& directory, const unsigned& step, const ParticleSetPtr& particleSet) {
 
     // Output file names
-    std::string velocityFile = ResultsDir + "/velocity" + std::to_string(step) + ".vtk";
-    std::string pressureFile = ResultsDir + "/pressure" + std::to_string(step) + ".vtk";
-    std::string stressFile   = ResultsDir + "/stress" + std::to_string(step) + ".vtk";
-    std::string strainFile   = ResultsDir + "/strain" + std::to_string(step) + ".vtk";
+    std::string velocityFile = directory + "/velocity" + std::to_string(step) + ".vtk";
+    std::string pressureFile = directory + "/pressure" + std::to_string(step) + ".vtk";
+    std::string stressFile   = directory + "/stress" + std::to_string(step) + ".vtk";
+    std::string strainFile   = directory + "/strain" + std::to_string(step) + ".vtk";
 
     // Output file stream 
     std::ofstream velocityOut(velocityFile.c_str()); 
@@ -101,6 +85,8 @@ void mpm::FileHandle::WriteData(const unsigned& step, const ParticleSetPtr& part
     std::ofstream stressOut(stressFile.c_str());
     std::ofstream strainOut(strainFile.c_str());
 
+    // the removed particles are not written
+    particleSet->compact();
     particleSet->write_particle_velocity_data_to_file(velocityOut);
     particleSet->write_particle_pressure_data_to_file(pressureOut);
     particleSet->write_particle_stress_data_to_file(stressOut);
@@ -113,3 +99,26 @@ void mpm::FileHandle::WriteData(const unsigned& step, const ParticleSetPtr& part
     strainOut.close();
 
 }
+
+
+
+//! WRITE FUNCTION: WRITE TRACE TO FILE
+//!                 This function writes the recorded phase timers to
+//!                 trace.json, which can be opened in chrome://tracing.
+//!
+void mpm::FileHandle::WriteTrace(mpm::misc::PhaseTimer& timer) {
+    std::string traceFile = ResultsDir + "/trace.json";
+    std::ofstream traceOut(traceFile.c_str());
+    timer.write_trace(traceOut);
+    traceOut.close();
+    std::cout << "\tTrace is in " << traceFile << "\n";
+}
+
+
+void mpm::FileHandle::WriteTaskGraph(const mpm::TaskGraph& graph) {
+    std::string graphFile = ResultsDir + "/taskGraph.dot";
+    std::ofstream graphOut(graphFile.c_str());
+    graph.write_dot(graphOut);
+    graphOut.close();
+    std::cout << "\tTask graph is in " << graphFile << "\n";
+}
@@ -2,6 +2,13 @@
                           Material Point Method
                            Shyamini Kularathna
                          Unversity Of Cambridge
+
+NOTE: The mesh of one simulation. Its topology (coordinates, elements,
+      layout of the grid) is a MeshTopology shared with the other
+      simulations of the case; the mesh owns the state of a step: the
+      nodal fields, the nodes and elements of the particles and the
+      constraints.
+
 File: Mesh.hpp
 ****************************************************************************/
 
@@ -13,26 +20,27 @@ File: Mesh.hpp
 #include <fstream>
 #include <sstream>
 #include <iostream>
-#include <set>
 #include <functional>
+#include <algorithm>
+#include <array>
+#include <memory>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // header files
 #include "Constants.hpp"
+#include "Pool.hpp"
 #include "Element.hpp"
+#include "MeshTopology.hpp"
+#include "NodeData.hpp"
 #include "Node.hpp"
 #include "Particle.hpp"
 #include "MpmParticle.hpp"
 
 namespace mpm {
   class Mesh;
-  template <class T>
-  struct comparator {
-    bool operator () (const T& arg1, const T& arg2) const {
-      unsigned firstId = arg1->give_id();
-      unsigned secondId = arg2->give_id();
-      return firstId < secondId;
-    }
-  };
 }
 
 
@@ -41,11 +49,20 @@ class mpm::Mesh {
 protected:
     static const unsigned dim = mpm::constants::DIM;
     static const unsigned numNodes = mpm::constants::NUMNODES;
-    static const unsigned numCorners = ((dim - 1) * dim) + 2;
 
 public:
-    // default constructor
-    Mesh(std::ifstream& mess_data_file);
+    // constructor on a topology shared with other meshes
+    explicit Mesh(const std::shared_ptr<const mpm::MeshTopology>& topology);
+
+    // constructor of a structured mesh of "num_elements" elements of size
+    // "spacing" whose first node is at "origin"; nodes and elements are
+    // numbered as in mesh_generator
+    Mesh(const Eigen::Matrix<double, 1, dim>& spacing, const Eigen::Matrix<unsigned, 1, dim>& num_elements, const Eigen::Matrix<double, 1, dim>& origin);
+
+    // give the topology of the mesh
+    const mpm::MeshTopology& topology() const {
+        return *topology_;
+    }
 
     // default destructor
     ~Mesh() { free_memory(); }
@@ -62,24 +79,59 @@ public:
     template<typename FP>
     void iterate_over_nodes_of_p(FP function) const;
 
-    void initialise_mesh();
+    // reset the nodal fields and the sets of particles; with a free surface
+    // the pressure constraints are cleared
+    void initialise_mesh(const bool& freeSurface);
+
+    void read_general_constraints(std::istream& vel_con_file);
+
+    void read_friction_constraints(std::istream& fric_con_file);
+
+    // constrain the velocity of a node in direction dir
+    void set_velocity_constraint(const unsigned& node_id, const unsigned& dir, const double& value);
 
-    void read_nodes_and_elements(std::ifstream& node_file, std::ifstream& elem_file);
+    // add Coulomb friction at a node on a boundary of normal direction dir
+    void set_friction_constraint(const unsigned& node_id, const unsigned& dir, const int& sign, const double& coefficient);
 
-    void read_general_constraints(std::ifstream& vel_con_file);
+    // velocity from momentum, acceleration and updated velocity of the
+    // nodes of particles (one vectorized kernel over the nodal fields)
+    void solve_nodal_velocity_and_acceleration(const double& dt);
+
+    // solve the nodes [begin, end) (e.g. the nodes of a level of particles)
+    void solve_nodal_velocity_and_acceleration(const double& dt, const unsigned& begin, const unsigned& end);
+
+    // scale the values of the velocity constraints (1 by default; the
+    // quasi-static mode applies them in load steps)
+    void set_velocity_constraint_scale(const double& scale) {
+        vel_con_scale_ = scale;
+    }
+
+    // sweeps over the constrained nodes only
+    void apply_velocity_constraints();
+    void apply_acceleration_constraints();
+    void apply_friction_constraints(const double& dt);
+
+    // the acceleration and velocity constraints of the fields of variants
+    // stored in lanes (node i of lane w at i * lanes + w)
+    void apply_constraints_to_lanes(mpm::NodeData& nodes, const unsigned& lanes) const;
+
+    // give whether the mesh has friction constraints
+    bool has_friction_constraints() const {
+        return !fric_con_nodes_.empty();
+    }
 
     void locate_particles_in_mesh(mpm::MpmParticle* &particle_set);
 
 
     // give vector of elements which contain particles
     void give_elements_of_p(std::vector<mpm::Element*>& vecOfE) {
-        for (const auto i : p_element_set_)
+        for (const auto i : p_elements_)
             vecOfE.push_back(i);
     }
 
     // give vector of nodes which contain particles
     void give_nodes_o_P(std::vector<mpm::Node*>& vecOfN) {
-        for (auto i : p_node_set_) 
+        for (auto i : p_nodes_)
             vecOfN.push_back(i);
     }
 
@@ -88,35 +140,49 @@ private:
   // free all dynamically allocated memory within "MeshBase" class
   void free_memory();
 
-  void check_particle_is_inside_mesh(Eigen::Matrix<int, 1 , dim> &eGrid, unsigned &pId);
+  // check whether the element grid of a particle is inside the mesh
+  bool check_particle_is_inside_mesh(const Eigen::Matrix<int, 1 , dim> &eGrid);
 
   void set_elements_and_nodes_of_particles(unsigned &elementId, mpm::Particle* &particlePtr);
 
 
 
+private:
+  // Coordinates, elements and layout of the grid (read only)
+  std::shared_ptr<const mpm::MeshTopology> topology_;
+
+  // Storage of the nodes and elements
+  mpm::misc::Pool<mpm::Node> node_pool_;
+  mpm::misc::Pool<mpm::Element> element_pool_;
+
 public :
   // Pointers to all elements in the mesh
   std::vector<mpm::Element*> elements_;
   // Pointers to all nodes in the mesh
   std::vector<mpm::Node*> nodes_;
 
-  // Set of elements which containes particles
-  std::set<mpm::Element*, mpm::comparator<mpm::Element*> > p_element_set_;
-  // Set of nodes which containes particles
-  std::set<mpm::Node*, mpm::comparator<mpm::Node*> > p_node_set_;
-
-    // Mesh spacing
-    Eigen::Matrix<double, 1, dim> mesh_spacing_;
-    // number of oelements in each directions
-    Eigen::Matrix<unsigned, 1, dim> num_elements_;
-    // Ids of the corner elements of the mesh
-    Eigen::Matrix<unsigned, 1, numCorners> corner_elements_;
-    // Ids of the corner noes of the mesh
-    Eigen::Matrix<unsigned, 1, numCorners> corner_nodes_;
-    // coordinates of the first node of the mesh
-    Eigen::Matrix<double, 1, dim> first_node_coord_;
-    // coordinates of the last node of the mesh
-    Eigen::Matrix<double, 1, dim> last_node_coord_;
+  // Elements and nodes which contain particles, in order of id. They are
+  // marked while the particles are located and gathered afterwards (a
+  // scan of the marks costs less than a sorted set per particle)
+  std::vector<mpm::Element*> p_elements_;
+  std::vector<mpm::Node*> p_nodes_;
+  std::vector<unsigned char> element_marks_;
+  std::vector<unsigned char> node_marks_;
+
+  // Fields of all nodes, indexed by node id
+  mpm::NodeData node_data_;
+
+  // Velocity constraints of each direction: node ids and values. A node
+  // given twice takes the last value.
+  std::array<std::vector<unsigned>, dim> vel_con_nodes_;
+  std::array<std::vector<double>, dim> vel_con_values_;
+  double vel_con_scale_;
+  // Friction constraints: nodes, normal direction, sign of the normal
+  // (towards the boundary) and friction coefficient
+  std::vector<mpm::Node*> fric_con_nodes_;
+  std::vector<unsigned> fric_con_dirs_;
+  std::vector<int> fric_con_signs_;
+  std::vector<double> fric_con_coefficients_;
 
 };
 
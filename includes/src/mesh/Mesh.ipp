@@ -12,117 +12,74 @@ void mpm::Mesh::iterate_over_nodes(FP function) const {
 
 template<typename FP>
 void mpm::Mesh::iterate_over_elements_of_p(FP function) const {
-  std::for_each(p_element_set_.begin(), p_element_set_.end(), function);
+  std::for_each(p_elements_.begin(), p_elements_.end(), function);
   return;
 }
 
 template<typename FP>
 void mpm::Mesh::iterate_over_nodes_of_p(FP function) const {
-  std::for_each(p_node_set_.begin(), p_node_set_.end(), function);
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(static)
+    for (unsigned i = 0; i < p_nodes_.size(); i++)
+      function(p_nodes_[i]);
+    return;
+  }
+#endif
+  std::for_each(p_nodes_.begin(), p_nodes_.end(), function);
   return;
 }
 
 
-void mpm::Mesh::initialise_mesh() {
-  p_element_set_.clear();
-  p_node_set_.clear();
+void mpm::Mesh::initialise_mesh(const bool& freeSurface) {
+  p_elements_.clear();
+  p_nodes_.clear();
   for (const auto& elem : elements_)
     elem->initialise_element();
-  for (const auto& node : nodes_)
-    node->initialise_node();
+  node_data_.initialise();
+  if (freeSurface) {
+    for (const auto& node : nodes_)
+      node->initialise_node();
+  }
 }
 
 void mpm::Mesh::free_memory() {
   for (auto ePtr : elements_)
-    delete ePtr;
+    element_pool_.destroy(ePtr);
   for (auto nPtr : nodes_)
-    delete nPtr;
+    node_pool_.destroy(nPtr);
   elements_.clear();
   nodes_.clear();
-  p_element_set_.clear();
-  p_node_set_.clear();
+  p_elements_.clear();
+  p_nodes_.clear();
 }
 
 
-mpm::Mesh::Mesh(std::ifstream& mesh_data_file) {
+mpm::Mesh::Mesh(const std::shared_ptr<const mpm::MeshTopology>& topology) : topology_(topology) {
 
-    std::string line;
-
-    std::getline(mesh_data_file, line);
-    std::istringstream input_mesh_space(line);
-    for (unsigned i = 0; i < dim; i++)
-        input_mesh_space >> mesh_spacing_(i);
-
-    std::getline(mesh_data_file, line);
-    std::istringstream input_num_elem(line);
-    for (unsigned i = 0; i < dim; i++)
-        input_num_elem >> num_elements_(i);
-
-    std::getline(mesh_data_file, line);
-    std::istringstream input_corner_elem(line);
-    for (unsigned i = 0; i < numCorners; i++) 
-        input_corner_elem >> corner_elements_(i);
-
-    std::getline(mesh_data_file, line);
-    std::istringstream input_corner_node(line);
-    for (unsigned i = 0; i < numCorners; i++)
-        input_corner_node >> corner_nodes_(i);            
-
-}
-
-
-void mpm::Mesh::read_nodes_and_elements(std::ifstream& node_file, std::ifstream& elem_file) {
-
-    std::string line;
-
-    // Read Nodes
-    unsigned num_nodes;
-    if(!std::getline(node_file, line)) {
-        std::cerr << "ERROR: reading file" << "\n";
-        abort();
-    } 
-    std::istringstream input_num_nodes(line);
-    input_num_nodes >> num_nodes;
+    const unsigned num_nodes = topology_->number_of_nodes();
+    const unsigned num_elements = topology_->number_of_elements();
+    node_data_.layout = topology_.get();
+    node_data_.resize(num_nodes);
 
     for (unsigned i = 0; i < num_nodes; i++) {
-        if (!std::getline(node_file, line)) {
-            std::cerr << "ERROR: reading file" << "\n";
-            abort();
-        }
-        mpm::Node* node = new mpm::Node(line,i);
+        mpm::Node* node = node_pool_.create(i, &node_data_);
         nodes_.push_back(node);
     }
-
-    // Read Elements
-    unsigned num_elements;
-    if(!std::getline(elem_file, line)) {
-        std::cerr << "ERROR: reading file" << "\n";
-        abort();
-    }
-    std::istringstream input_num_elems(line);
-    input_num_elems >> num_elements;
-
     for (unsigned i = 0; i < num_elements; i++) {
-        mpm::Element* element = new mpm::Element(i);
-        if (!std::getline(elem_file, line)) {
-               std::cerr << "ERROR: reading file" << "\n";
-               abort();
-        }
-        std::istringstream input_elem_nodes(line);
-        for (unsigned j = 0; j < numNodes; j++) {
-            unsigned node_Id;
-            input_elem_nodes >> node_Id;
-            element->set_element_nodes(j, node_Id, nodes_.at(node_Id));
-        }
+        mpm::Element* element = element_pool_.create(i);
         elements_.push_back(element);
     }
 
-    first_node_coord_ = nodes_.at(corner_nodes_(0)) -> give_node_coordinates();
-    last_node_coord_  = nodes_.at(corner_nodes_(3)) -> give_node_coordinates();
+    vel_con_scale_ = 1.;
 }
 
 
-void mpm::Mesh::read_general_constraints(std::ifstream& vel_con_file) {
+mpm::Mesh::Mesh(const Eigen::Matrix<double, 1, dim>& spacing, const Eigen::Matrix<unsigned, 1, dim>& num_elements, const Eigen::Matrix<double, 1, dim>& origin)
+    : Mesh(std::make_shared<const mpm::MeshTopology>(spacing, num_elements, origin)) { }
+
+
+void mpm::Mesh::read_general_constraints(std::istream& vel_con_file) {
 
     std::string line;
     unsigned num_vel_con_nodes, num_pres_con_nodes;
@@ -138,7 +95,7 @@ void mpm::Mesh::read_general_constraints(std::ifstream& vel_con_file) {
         std::istringstream input_vel_con(line);
         input_vel_con >> node_id >> direction;
         input_vel_con >> value;
-        nodes_.at(node_id) -> set_velocity_constraints(direction, value); 
+        this->set_velocity_constraint(node_id, direction, value);
     }
   
     for (unsigned i = 0; i < num_pres_con_nodes; i++) {
@@ -151,23 +108,177 @@ void mpm::Mesh::read_general_constraints(std::ifstream& vel_con_file) {
 }
 
 
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: READ_FRICTION_CONSTRAINTS
+          fricCon.dat:
+            numOfFrictionNodes
+            node   normalDirection   sign   frictionCoefficient
+          where sign (+1 or -1) is the direction of the normal from the
+          material into the boundary, e.g. 1 -1 for a base.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::Mesh::read_friction_constraints(std::istream& fric_con_file) {
+
+    std::string line;
+    unsigned num_fric_con_nodes = 0;
+    if (!std::getline(fric_con_file, line))
+        return;
+    std::istringstream input_num(line);
+    input_num >> num_fric_con_nodes;
+
+    unsigned node_id, direction;
+    int sign;
+    double coefficient;
+    for (unsigned i = 0; i < num_fric_con_nodes; i++) {
+        if (!std::getline(fric_con_file, line)) {
+            std::cerr << "ERROR: in reading fricCon.dat" << "\n";
+            abort();
+        }
+        std::istringstream input_fric_con(line);
+        input_fric_con >> node_id >> direction >> sign >> coefficient;
+        this->set_friction_constraint(node_id, direction, sign, coefficient);
+    }
+}
+
+
+void mpm::Mesh::set_velocity_constraint(const unsigned& node_id, const unsigned& dir, const double& value) {
+    if (dir >= dim) {
+        std::cerr << "ERROR: velocity constraint of node " << node_id << " in direction " << dir << "\n";
+        abort();
+    }
+    vel_con_nodes_[dir].push_back(nodes_.at(node_id)->give_id());
+    vel_con_values_[dir].push_back(value);
+}
+
+
+void mpm::Mesh::set_friction_constraint(const unsigned& node_id, const unsigned& dir, const int& sign, const double& coefficient) {
+    if (dir >= dim || (sign != 1 && sign != -1)) {
+        std::cerr << "ERROR: friction constraint of node " << node_id << "\n";
+        abort();
+    }
+    fric_con_nodes_.push_back(nodes_.at(node_id));
+    fric_con_dirs_.push_back(dir);
+    fric_con_signs_.push_back(sign);
+    fric_con_coefficients_.push_back(coefficient);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SOLVE_NODAL_VELOCITY_AND_ACCELERATION
+          The kernel runs over the range of ids of the nodes of
+          particles; nodes in between without particles have no mass and
+          stay at zero. The range is split among the threads.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::Mesh::solve_nodal_velocity_and_acceleration(const double& dt) {
+  if (p_nodes_.empty())
+    return;
+  this->solve_nodal_velocity_and_acceleration(dt, p_nodes_.front()->give_id(), p_nodes_.back()->give_id() + 1);
+}
+
+
+void mpm::Mesh::solve_nodal_velocity_and_acceleration(const double& dt, const unsigned& begin, const unsigned& end) {
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel
+    {
+      const unsigned numThreads = omp_get_num_threads();
+      const unsigned thread = omp_get_thread_num();
+      const unsigned length = end - begin;
+      const unsigned first = begin + (unsigned long)length * thread / numThreads;
+      const unsigned last = begin + (unsigned long)length * (thread + 1) / numThreads;
+      node_data_.solve_velocity_and_acceleration(dt, first, last);
+    }
+    return;
+  }
+#endif
+  node_data_.solve_velocity_and_acceleration(dt, begin, end);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: APPLY CONSTRAINTS
+          The constraints are applied in separate sweeps over the lists of
+          constrained nodes, so the update of the other nodes has no
+          constraint tests. Nodes without particles are constrained as
+          well; their values are reset by initialise_mesh and never read.
+          After solve_nodal_velocity_and_acceleration the order is:
+          friction (which needs the normal acceleration), acceleration,
+          velocity.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::Mesh::apply_velocity_constraints() {
+    for (unsigned dir = 0; dir < dim; dir++) {
+        const std::vector<unsigned>& ids = vel_con_nodes_[dir];
+        const std::vector<double>& values = vel_con_values_[dir];
+        double* velocity = node_data_.velocity[dir].data();
+        for (unsigned i = 0; i < ids.size(); i++)
+            velocity[ids[i]] = vel_con_scale_ * values[i];
+    }
+}
+
+
+void mpm::Mesh::apply_acceleration_constraints() {
+    for (unsigned dir = 0; dir < dim; dir++) {
+        const std::vector<unsigned>& ids = vel_con_nodes_[dir];
+        double* acceleration = node_data_.acceleration[dir].data();
+        for (unsigned i = 0; i < ids.size(); i++)
+            acceleration[ids[i]] = 0.;
+    }
+}
+
+
+void mpm::Mesh::apply_friction_constraints(const double& dt) {
+    for (unsigned i = 0; i < fric_con_nodes_.size(); i++)
+        fric_con_nodes_[i]->apply_friction(fric_con_dirs_[i], fric_con_signs_[i], fric_con_coefficients_[i], dt);
+}
+
+
+void mpm::Mesh::apply_constraints_to_lanes(mpm::NodeData& nodes, const unsigned& lanes) const {
+    for (unsigned dir = 0; dir < dim; dir++) {
+        const std::vector<unsigned>& ids = vel_con_nodes_[dir];
+        double* acceleration = nodes.acceleration[dir].data();
+        for (unsigned i = 0; i < ids.size(); i++) {
+            for (unsigned w = 0; w < lanes; w++)
+                acceleration[ids[i] * lanes + w] = 0.;
+        }
+    }
+    for (unsigned dir = 0; dir < dim; dir++) {
+        const std::vector<unsigned>& ids = vel_con_nodes_[dir];
+        const std::vector<double>& values = vel_con_values_[dir];
+        double* velocity = nodes.velocity[dir].data();
+        for (unsigned i = 0; i < ids.size(); i++) {
+            for (unsigned w = 0; w < lanes; w++)
+                velocity[ids[i] * lanes + w] = vel_con_scale_ * values[i];
+        }
+    }
+}
+
+
 void mpm::Mesh::locate_particles_in_mesh(mpm::MpmParticle* &particle_set) {
 
     unsigned num_particles = particle_set->number_of_particles();
+    const mpm::MeshTopology& topology = *topology_;
+    element_marks_.resize(elements_.size(), 0);
+    node_marks_.resize(nodes_.size(), 0);
 
     // "elemGrid" is the vecotor holding the element grid which containes
     // the particle
     Eigen::Matrix<int, 1 , dim> elem_grid;
 
     for (unsigned i = 0; i < num_particles; i++) {
+        // a removed particle marks no element or node
+        if (particle_set->pointer_to_particle(i)->is_removed())
+            continue;
         Eigen::Matrix<double, 1 , dim> p_coords = particle_set->particle_coordinates(i);
         for (unsigned j = 0; j < dim; j++)
-            elem_grid(j) = std::fabs((p_coords(j) - first_node_coord_(j)) / mesh_spacing_(j));
-        check_particle_is_inside_mesh(elem_grid, i);
+            elem_grid(j) = std::max(-1., std::min(double(topology.numElements(j)), std::floor((p_coords(j) - topology.firstNodeCoord(j)) / topology.meshSpacing(j))));
+        // a particle which left the mesh is removed at the next compaction
+        if (!check_particle_is_inside_mesh(elem_grid)) {
+            particle_set->remove_particle(i);
+            continue;
+        }
         unsigned elem_id;
         if (dim == 2)
-            elem_id = std::fabs(elem_grid(0) + (num_elements_(0) * elem_grid(1)));
-        if (elem_id > corner_elements_(3) || elem_id < corner_elements_(0)) {
+            elem_id = std::fabs(elem_grid(0) + (topology.numElements(0) * elem_grid(1)));
+        if (elem_id > topology.cornerElements(3) || elem_id < topology.cornerElements(0)) {
             std::cerr << "ERROR: in computing element id for particle " << i << "\n";
             abort();
         }
@@ -176,28 +287,41 @@ void mpm::Mesh::locate_particles_in_mesh(mpm::MpmParticle* &particle_set) {
         set_elements_and_nodes_of_particles(elem_id, pPtr);
     }
 
+    // elements and nodes of particles in order of id (the marks are
+    // cleared for the next step)
+    for (unsigned i = 0; i < elements_.size(); i++) {
+        if (element_marks_[i]) {
+            p_elements_.push_back(elements_[i]);
+            element_marks_[i] = 0;
+        }
+    }
+    for (unsigned i = 0; i < nodes_.size(); i++) {
+        if (node_marks_[i]) {
+            p_nodes_.push_back(nodes_[i]);
+            node_marks_[i] = 0;
+        }
+    }
+
 }
 
-void mpm::Mesh::check_particle_is_inside_mesh(Eigen::Matrix<int, 1 , dim> &eGrid, unsigned &pId) {
+bool mpm::Mesh::check_particle_is_inside_mesh(const Eigen::Matrix<int, 1 , dim> &eGrid) {
 
     for (unsigned i = 0; i < dim; i++) {
-        if (eGrid(i) < 0 || eGrid (i) >= num_elements_(i)) {
-            std::cerr << "ERROR: Particle " << pId << " is out of mesh" << "\n";
-            abort();
-        }
+        if (eGrid(i) < 0 || eGrid (i) >= int(topology_->numElements(i)))
+            return false;
     }
+    return true;
 }
 
 
 void mpm::Mesh::set_elements_and_nodes_of_particles(unsigned &elementId, mpm::Particle* &particlePtr) {
-    mpm::Element* ePtr = elements_.at(elementId);
-    p_element_set_.insert(ePtr);
+    element_marks_.at(elementId) = 1;
 
-    Eigen::Matrix<mpm::Node*, 1, numNodes> nPtrs = ePtr->give_element_node_ptrs();
-    for (unsigned i = 0; i < numNodes; i++) 
-        p_node_set_.insert(nPtrs(i));
+    const unsigned first = topology_->first_node(elementId);
+    for (unsigned i = 0; i < numNodes; i++)
+        node_marks_[first + topology_->nodeOffsets[i]] = 1;
 
-    particlePtr->set_element_and_nodes(ePtr, nPtrs);
+    particlePtr->set_element(elementId, &node_data_);
 }
 
 
@@ -0,0 +1,108 @@
+/***************************************************************************
+                          Material Point Method
+                           Shyamini Kularathna
+                         University Of Cambridge
+
+NOTE: The part of the mesh which does not change during a run: spacing,
+      node coordinates, element connectivity and the layout of the
+      structured grid (a particle keeps only the index of its element,
+      and the ids of the element nodes are computed from it, first_node
+      + nodeOffsets). It is built once from the input files and shared,
+      read only, by the meshes of all simulations of a case
+      (std::shared_ptr<const MeshTopology>); a mesh keeps only the state
+      of a step (NodeData, nodes and elements of particles, constraints).
+
+File: MeshTopology.hpp
+****************************************************************************/
+#ifndef MPM_MESHTOPOLOGY_H
+#define MPM_MESHTOPOLOGY_H
+
+// c++ header files
+#include <vector>
+#include <array>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+
+// eigen header files
+#include <Eigen/Dense>
+
+// mpm header files
+#include "Constants.hpp"
+
+namespace mpm {
+    class MeshTopology;
+}
+
+class mpm::MeshTopology {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+    static const unsigned numCorners = ((dim - 1) * dim) + 2;
+
+public:
+    typedef std::vector<double, Eigen::aligned_allocator<double> > Field;
+    typedef Eigen::Matrix<double, 1, dim> VectorDDIM;
+    typedef Eigen::Matrix<unsigned, 1, numNodes> VectorUNN;
+
+public:
+    // constructor from meshData.dat, node.dat and element.dat
+    MeshTopology(std::istream& mesh_data_file, std::istream& node_file, std::istream& elem_file);
+
+    // constructor of a structured mesh of "num_elements" elements of size
+    // "spacing" whose first node is at "origin"; nodes and elements are
+    // numbered as in mesh_generator
+    MeshTopology(const VectorDDIM& spacing, const Eigen::Matrix<unsigned, 1, dim>& num_elements, const VectorDDIM& origin);
+
+    // give number of nodes and of elements
+    unsigned number_of_nodes() const {
+        return nodeCoord.size();
+    }
+    unsigned number_of_elements() const {
+        return elementNodes.size();
+    }
+
+    // give id of the first node (lower left) of an element
+    unsigned first_node(const unsigned& element) const {
+        return element + element / elementsPerRow;
+    }
+
+private:
+    // check the structured numbering of the elements and store their
+    // centres and lengths
+    void set_structured_layout();
+
+    // not copied: shared by pointer
+    MeshTopology(const MeshTopology&);
+    MeshTopology& operator=(const MeshTopology&);
+
+public:
+    // MESH SPACING AND NUMBER OF ELEMENTS IN EACH DIRECTION
+    VectorDDIM meshSpacing;
+    Eigen::Matrix<unsigned, 1, dim> numElements;
+    // IDS OF THE CORNER ELEMENTS AND NODES
+    Eigen::Matrix<unsigned, 1, numCorners> cornerElements;
+    Eigen::Matrix<unsigned, 1, numCorners> cornerNodes;
+    // COORDINATES OF THE FIRST AND THE LAST NODE
+    VectorDDIM firstNodeCoord;
+    VectorDDIM lastNodeCoord;
+
+    // COORDINATES OF THE NODES AND NODES OF THE ELEMENTS
+    std::vector<VectorDDIM, Eigen::aligned_allocator<VectorDDIM> > nodeCoord;
+    std::vector<VectorUNN, Eigen::aligned_allocator<VectorUNN> > elementNodes;
+
+    // STRUCTURED GRID: the nodes of element e are first_node(e) +
+    // nodeOffsets[k], counterclockwise from the lower left node
+    unsigned elementsPerRow;
+    std::array<unsigned, numNodes> nodeOffsets;
+    // CENTRE AND LENGTH OF THE ELEMENTS
+    std::array<Field, dim> elementCentre;
+    std::array<Field, dim> elementLength;
+};
+
+#include "MeshTopology.ipp"
+
+#endif
@@ -0,0 +1,162 @@
+
+mpm::MeshTopology::MeshTopology(std::istream& mesh_data_file, std::istream& node_file, std::istream& elem_file) {
+
+    std::string line;
+
+    std::getline(mesh_data_file, line);
+    std::istringstream input_mesh_space(line);
+    for (unsigned i = 0; i < dim; i++)
+        input_mesh_space >> meshSpacing(i);
+
+    std::getline(mesh_data_file, line);
+    std::istringstream input_num_elem(line);
+    for (unsigned i = 0; i < dim; i++)
+        input_num_elem >> numElements(i);
+
+    std::getline(mesh_data_file, line);
+    std::istringstream input_corner_elem(line);
+    for (unsigned i = 0; i < numCorners; i++)
+        input_corner_elem >> cornerElements(i);
+
+    std::getline(mesh_data_file, line);
+    std::istringstream input_corner_node(line);
+    for (unsigned i = 0; i < numCorners; i++)
+        input_corner_node >> cornerNodes(i);
+
+    // Read Nodes
+    unsigned num_nodes;
+    if (!std::getline(node_file, line)) {
+        std::cerr << "ERROR: reading file" << "\n";
+        abort();
+    }
+    std::istringstream input_num_nodes(line);
+    input_num_nodes >> num_nodes;
+
+    nodeCoord.resize(num_nodes);
+    for (unsigned i = 0; i < num_nodes; i++) {
+        if (!std::getline(node_file, line)) {
+            std::cerr << "ERROR: reading file" << "\n";
+            abort();
+        }
+        std::istringstream input_node(line);
+        for (unsigned j = 0; j < dim; j++)
+            input_node >> nodeCoord[i](j);
+    }
+
+    // Read Elements
+    unsigned num_elements;
+    if (!std::getline(elem_file, line)) {
+        std::cerr << "ERROR: reading file" << "\n";
+        abort();
+    }
+    std::istringstream input_num_elems(line);
+    input_num_elems >> num_elements;
+
+    elementNodes.resize(num_elements);
+    for (unsigned i = 0; i < num_elements; i++) {
+        if (!std::getline(elem_file, line)) {
+            std::cerr << "ERROR: reading file" << "\n";
+            abort();
+        }
+        std::istringstream input_elem_nodes(line);
+        for (unsigned j = 0; j < numNodes; j++) {
+            unsigned node_Id;
+            input_elem_nodes >> node_Id;
+            if (node_Id >= num_nodes) {
+                std::cerr << "ERROR: node " << node_Id << " of element " << i << " is not in the mesh" << "\n";
+                abort();
+            }
+            elementNodes[i](j) = node_Id;
+        }
+    }
+
+    firstNodeCoord = nodeCoord.at(cornerNodes(0));
+    lastNodeCoord = nodeCoord.at(cornerNodes(numCorners - 1));
+    this->set_structured_layout();
+}
+
+
+mpm::MeshTopology::MeshTopology(const VectorDDIM& spacing, const Eigen::Matrix<unsigned, 1, dim>& num_elements, const VectorDDIM& origin) {
+
+    meshSpacing = spacing;
+    numElements = num_elements;
+
+    unsigned nx = num_elements(0);
+    unsigned ny = num_elements(1);
+    unsigned num_nodes_x = nx + 1;
+    unsigned num_nodes_y = ny + 1;
+
+    cornerElements << 0, nx - 1, nx * (ny - 1), (nx * ny) - 1;
+    cornerNodes << 0, num_nodes_x - 1, num_nodes_x * (num_nodes_y - 1), (num_nodes_x * num_nodes_y) - 1;
+
+    // Create Nodes
+    VectorDDIM coord;
+    for (unsigned j = 0; j < num_nodes_y; j++) {
+        for (unsigned i = 0; i < num_nodes_x; i++) {
+            coord(0) = origin(0) + spacing(0) * i;
+            coord(1) = origin(1) + spacing(1) * j;
+            nodeCoord.push_back(coord);
+        }
+    }
+
+    // Create Elements
+    VectorUNN elem_nodes;
+    for (unsigned j = 0; j < ny; j++) {
+        for (unsigned i = 0; i < nx; i++) {
+            elem_nodes(0) = (j * num_nodes_x) + i;
+            elem_nodes(1) = elem_nodes(0) + 1;
+            elem_nodes(2) = elem_nodes(1) + num_nodes_x;
+            elem_nodes(3) = elem_nodes(0) + num_nodes_x;
+            elementNodes.push_back(elem_nodes);
+        }
+    }
+
+    firstNodeCoord = nodeCoord.at(cornerNodes(0));
+    lastNodeCoord = nodeCoord.at(cornerNodes(numCorners - 1));
+    this->set_structured_layout();
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SET_STRUCTURED_LAYOUT
+          Particles find their nodes from the element index alone, so the
+          elements have to be numbered as mesh_generator does: row by row,
+          nodes counterclockwise from the lower left one. The centre and
+          the length of each element are stored here, as the particles no
+          longer point to the elements.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MeshTopology::set_structured_layout() {
+    const unsigned num_elements = elementNodes.size();
+    elementsPerRow = numElements(0);
+    const unsigned nodesPerRow = elementsPerRow + 1;
+    nodeOffsets[0] = 0;
+    nodeOffsets[1] = 1;
+    nodeOffsets[2] = nodesPerRow + 1;
+    nodeOffsets[3] = nodesPerRow;
+    for (unsigned i = 0; i < dim; i++) {
+        elementCentre[i].assign(num_elements, 0.);
+        elementLength[i].assign(num_elements, 0.);
+    }
+
+    for (unsigned elem_id = 0; elem_id < num_elements; elem_id++) {
+        const VectorUNN& node_ids = elementNodes[elem_id];
+        const unsigned first = this->first_node(elem_id);
+        for (unsigned k = 0; k < numNodes; k++) {
+            if (node_ids(k) != first + nodeOffsets[k]) {
+                std::cerr << "ERROR: element " << elem_id << " is not numbered as a structured grid" << "\n";
+                abort();
+            }
+        }
+
+        VectorDDIM centre = VectorDDIM::Zero();
+        for (unsigned k = 0; k < numNodes; k++)
+            centre += nodeCoord.at(node_ids(k));
+        centre /= numNodes;
+        const VectorDDIM first_coord = nodeCoord.at(node_ids(0));
+        const VectorDDIM corner_coord = nodeCoord.at(node_ids(2));
+        for (unsigned i = 0; i < dim; i++) {
+            elementCentre[i][elem_id] = centre(i);
+            elementLength[i][elem_id] = std::fabs(corner_coord(i) - first_coord(i));
+        }
+    }
+}
@@ -21,6 +21,7 @@ File: Node.hpp
 
 // mpm header files
 #include "Constants.hpp"
+#include "NodeData.hpp"
 
 namespace mpm {
     class Node;
@@ -37,18 +38,14 @@ protected:
 
 
 public:
+    // constructor; the nodal fields are stored in "data", the
+    // coordinates in the layout of the mesh (MeshTopology)
+    Node(const unsigned& id, mpm::NodeData* data);
 
-    // constructor
-    Node(std::string& iLine, unsigned& id);
-
-    // initialise node
+    // initialise node (the fields are reset by NodeData::initialise); used
+    // with a free surface, it clears the pressure constraint
     void initialise_node();
 
-    // set nodal velocity constraint
-    void set_velocity_constraints(unsigned& dir, double& value) {
-        nVelConState_(dir) = 1;
-        nVelConValue_(dir) = value;
-    }
 
     // set nodal pressure constraint
     void set_pressure_constraints(double& value) {
@@ -58,63 +55,58 @@ public:
 
     // assign mass from particles
     void assign_nodal_mass(const double& mass) {
-        nMass_ += mass;
+        data_->add(data_->mass[nodeId_], mass);
     }
 
     // assign volume from particles
     void assign_nodal_volume(const double& volume) {
-        nVolume_ += volume;
+        data_->add(data_->volume[nodeId_], volume);
     }
 
     // assign momentum from paricles
     void assign_nodal_momentum(const VectorDDIM& momentum) {
-        nMomentum_ += momentum;
-    }
-
-    // assign momentum at the beginig of time step
-    void assign_nodal_momentum_at_begin(const VectorDDIM& momentum) {
-        nBeginMomentum_ += momentum;
-    }
-
-    // assign momentum at the end of time step
-    void assign_nodal_momentum_at_end(const VectorDDIM& momentum) {
-        nEndMomentum_ += momentum;
+        for (unsigned i = 0; i < dim; i++)
+            data_->add(data_->momentum[i][nodeId_], momentum(i));
     }
 
     // assign volumetric strain rate from particles
     void assign_nodal_vol_strain_rate(const double& vol_strainrate) {
-        nVolStrainRate_ += vol_strainrate;
+        data_->add(data_->volStrainRate[nodeId_], vol_strainrate);
     }
 
-    // compute nodal velocity from momentum
-    void compute_nodal_velocity_from_momentum();
-
-    // compute nodal velocity from moentum at begining of time step
-    void compute_nodal_velocity_from_begin_momentum();
-
-    // compute nodal velocity for momentum at end of time step
-    void compute_nodal_velocity_from_end_momentum();
-
     // assign external force
     void assign_external_force(const VectorDDIM& extForce) {
-        nExtForce_ += extForce;
+        for (unsigned i = 0; i < dim; i++)
+            data_->add(data_->extForce[i][nodeId_], extForce(i));
     }
 
     // assign internal force
     void assign_internal_force(const VectorDDIM& intForce) {
-        nIntForce_ -= intForce;
+        for (unsigned i = 0; i < dim; i++)
+            data_->add(data_->intForce[i][nodeId_], -intForce(i));
     }
 
-    // solve acceleration and velocity
-    void solve_acceleration_and_velocity(const double dt);
+    // constrain the velocity in direction dir
+    void constrain_velocity(const unsigned& dir, const double& value) {
+        data_->velocity[dir][nodeId_] = value;
+    }
+
+    // constrain the acceleration in direction dir to zero
+    void constrain_acceleration(const unsigned& dir) {
+        data_->acceleration[dir][nodeId_] = 0.;
+    }
+
+    // apply Coulomb friction on a boundary of normal direction dir
+    void apply_friction(const unsigned& dir, const int& sign, const double& coefficient, const double& dt);
 
     // assign nodal pressure
     void assign_nodal_pressure(const double& pressureXmass) {
-        nPressure_ += pressureXmass;
+        data_->add(data_->pressure[nodeId_], pressureXmass);
     }
 
-    // compute pressure at nodes from mapped values
-    void compute_nodal_pressure_from_mapped_pressure();
+    // compute pressure at nodes from mapped values (with a free surface
+    // the pressure constraint is applied)
+    void compute_nodal_pressure_from_mapped_pressure(const bool& freeSurface);
 
     // give node id
     unsigned give_id() const {
@@ -123,27 +115,33 @@ public:
 
     // give node coordinates
     VectorDDIM give_node_coordinates() const {
-        return nodeCoord_;
+        return data_->layout->nodeCoord[nodeId_];
     }
 
     // give velocity at node
     VectorDDIM give_node_velocity() const {
-        return nVelocity_;
+        VectorDDIM velocity;
+        for (unsigned i = 0; i < dim; i++)
+            velocity(i) = data_->velocity[i][nodeId_];
+        return velocity;
     }
 
     // give acceleration at node
     VectorDDIM give_node_acceleration() const {
-        return nAcceleration_;
+        VectorDDIM acceleration;
+        for (unsigned i = 0; i < dim; i++)
+            acceleration(i) = data_->acceleration[i][nodeId_];
+        return acceleration;
     }
 
     // give pressure at node 
     double give_node_pressure() const {
-        return nPressure_;
+        return data_->pressure[nodeId_];
     }
 
     // give volumetric strain rate at node 
     double give_node_vol_strain_rate() const {
-        return nVolStrainRate_;
+        return data_->volStrainRate[nodeId_];
     }
 
 private:
@@ -151,54 +149,20 @@ private:
     // CHECK DOUBLE PRECISION OF A GIVEN VALUE
     void check_double_precision(double& value);
 
-    // ASSIGN VELOCITY CONSTRAINT TO THE NODAL VELOCITY
-    void apply_velocity_constraint();
-
-    // ASSIGN ACCELERATION CONSTRAINT
-    void apply_acceleration_constraint();
-
-    // ASSIGN FRICTION CONSTRAINTS
-    void apply_friction_constraint();
-
     // ASSIGN PRESSURE CONSTRAINT TO THE NODAL PRESSURE
     void apply_pressure_constraint();
 
 
 protected:
-    // ID
+    // ID (index of the node in the nodal fields)
     unsigned nodeId_;
-    // COORDINATES
-    VectorDDIM nodeCoord_;
-
-    // VELOCITY CONSTRAINTS
-    VectorUDIM nVelConState_;
-    VectorDDIM nVelConValue_;
 
     // PRESSURE CONSTRAINTS
     bool pressureConstraintStatus_;
     double pressureConstraintValue_;
 
-    // MASS
-    double nMass_;
-    // MOMENTUM
-    VectorDDIM nMomentum_;
-    // MOMENTUM AT BEGINING OF TIME STEP
-    VectorDDIM nBeginMomentum_;
-    // MOMENTUM AT END OF TIME STEP
-    VectorDDIM nEndMomentum_;
-    // VELOCITY
-    VectorDDIM nVelocity_;
-    // ACCELERATION
-    VectorDDIM nAcceleration_;
-    // PRESSURE
-    double nPressure_;
-    double nVolStrainRate_;
-    double nVolume_;
-
-    // EXTERNAL FORCE
-    VectorDDIM nExtForce_;
-    // INTERNAL FORCE
-    VectorDDIM nIntForce_;
+    // NODAL FIELDS OF THE MESH
+    mpm::NodeData* data_;
 
 };
 
@@ -1,112 +1,72 @@
 
-mpm::Node::Node(std::string& iLine, unsigned& id) {
+mpm::Node::Node(const unsigned& id, mpm::NodeData* data) {
     nodeId_ = id;
-    std::istringstream inp(iLine);
-    if (dim == 2) {
-        double third;
-        inp >> nodeCoord_(0) >> nodeCoord_(1);
-        inp >> third;
-    }
-    else if (dim == 3)
-        inp >> nodeCoord_(0) >> nodeCoord_(1) >> nodeCoord_(2);
-
-    nMass_     = 0.;
-    nMomentum_ = VectorDDIM::Zero();
-    nBeginMomentum_ = VectorDDIM::Zero();
-    nEndMomentum_ = VectorDDIM::Zero();
-    nVelocity_ = VectorDDIM::Zero();
-    nAcceleration_ = VectorDDIM::Zero();
-    nExtForce_ = VectorDDIM::Zero();
-    nIntForce_ = VectorDDIM::Zero();
-    nVelConState_ = VectorUDIM::Zero();
-    nVelConValue_ = VectorDDIM::Zero();
-
-    nVolStrainRate_ = 0.;
-    nVolume_ = 0.;
-    nPressure_ = 0.;
+    data_ = data;
+
     pressureConstraintStatus_ = 0;
     pressureConstraintValue_ = 0;
 }
 
 
-
 void mpm::Node::initialise_node() {
-    nMass_     = 0.;
-    nMomentum_ = VectorDDIM::Zero();
-    nBeginMomentum_ = VectorDDIM::Zero();
-    nEndMomentum_ = VectorDDIM::Zero();
-    nVelocity_ = VectorDDIM::Zero();
-    nAcceleration_ = VectorDDIM::Zero();
-    nExtForce_ = VectorDDIM::Zero();
-    nIntForce_ = VectorDDIM::Zero();
-
-    nVolStrainRate_ = 0.;
-    nVolume_ = 0.;
-    nPressure_ = 0.;
-    if (mpm::misc::freeSurface) {
-        pressureConstraintStatus_ = 0;
-        pressureConstraintValue_  = 0.;
-    }
+    pressureConstraintStatus_ = 0;
+    pressureConstraintValue_  = 0.;
 }
 
 
-void mpm::Node::compute_nodal_velocity_from_momentum() {
-    if (std::fabs(nMass_) > 1.E-15)
-        nVelocity_ = nMomentum_ / nMass_;
+void mpm::Node::compute_nodal_pressure_from_mapped_pressure(const bool& freeSurface) {    
+    double& pressure = data_->pressure[nodeId_];
+    const double mass = data_->mass[nodeId_];
+    if (std::fabs(mass) > 1.E-15)
+        pressure = pressure / mass;
     else {
         std::cerr << "ERROR: nodal mass is lower than the cutoff value" << "\n";
     }
-    for (unsigned i = 0; i < dim; i++)
-        this->check_double_precision(nVelocity_(i));
-    this->apply_velocity_constraint();
+    this->check_double_precision(pressure);
+    if (freeSurface)
+        this->apply_pressure_constraint();
 }
 
 
-void mpm::Node::compute_nodal_velocity_from_begin_momentum() {
-    if (std::fabs(nMass_) > 1.E-15)
-        nVelocity_ = nBeginMomentum_ / nMass_;
-    else {
-        std::cerr << "ERROR: nodal mass is lower than the cutoff value" << "\n";
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: APPLY_FRICTION
+          Coulomb friction on a boundary whose normal is direction dir
+          (the tangential direction is the other one, 2D); sign (+1 or
+          -1) points from the material into the boundary.
+          The node is in contact when its normal acceleration pushes into
+          the boundary. Then the tangential acceleration is reduced by at
+          most coefficient * |normal acceleration|: a sliding node is
+          slowed down (but not reversed), a node at rest stays at rest
+          unless the tangential acceleration is larger. Called after
+          NodeData::solve_velocity_and_acceleration, so the velocity at the start
+          of the step is recovered from the updated one.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::Node::apply_friction(const unsigned& dir, const int& sign, const double& coefficient, const double& dt) {
+    const unsigned dirT = (dir + 1) % dim;
+    const double accN = data_->acceleration[dir][nodeId_];
+    if (accN * sign <= 0.)
+        return;
+
+    double accT = data_->acceleration[dirT][nodeId_];
+    const double velT = data_->velocity[dirT][nodeId_] - dt * accT;
+    const double limit = coefficient * std::fabs(accN);
+    if (velT != 0.) {
+        // kinetic friction
+        const double velNet = velT + dt * accT;
+        if (std::fabs(velNet) <= dt * limit)
+            accT = -velT / dt;
+        else
+            accT -= (velNet > 0. ? limit : -limit);
     }
-    for (unsigned i = 0; i < dim; i++)
-        this->check_double_precision(nVelocity_(i));
-    this->apply_velocity_constraint();
-}
-
-
-void mpm::Node::compute_nodal_velocity_from_end_momentum() {
-    if (std::fabs(nMass_) > 1.E-15)
-        nVelocity_ = nEndMomentum_ / nMass_;
     else {
-        std::cerr << "ERROR: nodal mass is lower than the cutoff value" << "\n";
+        // static friction
+        if (std::fabs(accT) <= limit)
+            accT = 0.;
+        else
+            accT -= (accT > 0. ? limit : -limit);
     }
-    for (unsigned i = 0; i < dim; i++)
-        this->check_double_precision(nVelocity_(i));
-    this->apply_velocity_constraint();
-}
-
-
-void mpm::Node::compute_nodal_pressure_from_mapped_pressure() {    
-    if (std::fabs(nMass_) > 1.E-15)
-        nPressure_ = nPressure_ / nMass_;
-    else {
-        std::cerr << "ERROR: nodal mass is lower than the cutoff value" << "\n";
-    }
-    this->check_double_precision(nPressure_);
-    if (mpm::misc::freeSurface)
-        this->apply_pressure_constraint();
-}
-
-
-
-void mpm::Node::solve_acceleration_and_velocity(const double dt) {
-    if (std::fabs(nMass_) > 1.0E-16)
-        nAcceleration_ = (nExtForce_ + nIntForce_) / nMass_;
-    else 
-        std::cerr << "ERROR: mass is zero" << "\n";
-    this->apply_acceleration_constraint();
-    nVelocity_ += dt * nAcceleration_;
-    this->apply_velocity_constraint();
+    data_->acceleration[dirT][nodeId_] = accT;
+    data_->velocity[dirT][nodeId_] = velT + dt * accT;
 }
 
 
@@ -118,24 +78,8 @@ void mpm::Node::check_double_precision(double& value) {
 
 
 
-void mpm::Node::apply_velocity_constraint() {
-    for (unsigned i = 0; i < dim; i++) {
-        if (nVelConState_(i))
-            nVelocity_(i) = nVelConValue_(i);
-    }
-}
-
-
-void mpm::Node::apply_acceleration_constraint() {
-    for (unsigned i = 0; i < dim; i++) {
-        if (nVelConState_(i))
-            nAcceleration_(i) = 0.;
-    }
-}
-
-
 
 void mpm::Node::apply_pressure_constraint() {
     if (pressureConstraintStatus_) 
-        nPressure_ = pressureConstraintValue_;;
+        data_->pressure[nodeId_] = pressureConstraintValue_;
 }
@@ -0,0 +1,119 @@
+/***************************************************************************
+                          Material Point Method
+                           Shyamini Kularathna
+                         University Of Cambridge
+
+NOTE: Nodal fields which are reset, mapped and solved in every time
+      step, stored as flat arrays indexed by node id (one array for each
+      component). The mesh owns one NodeData; mpm::Node keeps only the
+      rarely used data (id, coordinates, pressure constraint) and reads
+      and writes its fields here, so the nodal kernels run over
+      contiguous memory.
+      NodeData also points to the layout of the structured grid, which
+      is shared by all simulations of a case (MeshTopology): a particle
+      keeps only the index of its element, and the ids of the element
+      nodes are computed from it (first_node + nodeOffsets).
+
+File: NodeData.hpp
+****************************************************************************/
+#ifndef MPM_NODEDATA_H
+#define MPM_NODEDATA_H
+
+// c++ header files
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+// eigen header files
+#include <Eigen/Dense>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// mpm header files
+#include "Constants.hpp"
+#include "MeshTopology.hpp"
+
+namespace mpm {
+    class NodeData;
+}
+
+class mpm::NodeData {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+
+public:
+    // one field component of all nodes
+    typedef std::vector<double, Eigen::aligned_allocator<double> > Field;
+
+public:
+    // constructor; "shared" fields are updated with atomics in parallel
+    // loops, the buffer of one thread is not shared
+    explicit NodeData(const bool& shared = true);
+
+    // set the number of nodes (all fields are zero)
+    void resize(const unsigned& numNodes);
+
+    // give the number of nodes
+    unsigned size() const {
+        return mass.size();
+    }
+
+    // set all fields to zero
+    void initialise();
+
+    // give id of the first node (lower left) of an element
+    unsigned first_node(const unsigned& element) const {
+        return layout->first_node(element);
+    }
+
+    // add to a nodal value (particles of a parallel loop map to the
+    // same node; the order of the sums is not fixed). A team of one
+    // thread, e.g. a simulation of an ensemble, adds without atomics.
+    void add(double& value, const double& increment) const {
+#ifdef _OPENMP
+        if (shared_ && omp_get_num_threads() > 1) {
+#pragma omp atomic
+            value += increment;
+            return;
+        }
+#endif
+        value += increment;
+    }
+
+    // compute velocity from momentum, acceleration from the forces and
+    // the updated velocity of the nodes [begin, end), without constraints
+    void solve_velocity_and_acceleration(const double& dt, const unsigned& begin, const unsigned& end);
+
+public:
+    // MASS
+    Field mass;
+    // MOMENTUM
+    std::array<Field, dim> momentum;
+    // VELOCITY
+    std::array<Field, dim> velocity;
+    // ACCELERATION
+    std::array<Field, dim> acceleration;
+    // EXTERNAL FORCE
+    std::array<Field, dim> extForce;
+    // INTERNAL FORCE
+    std::array<Field, dim> intForce;
+    // PRESSURE, VOLUME AND VOLUMETRIC STRAIN RATE
+    Field pressure;
+    Field volume;
+    Field volStrainRate;
+
+    // STRUCTURED GRID (node offsets, centre and length of the elements)
+    const mpm::MeshTopology* layout;
+
+protected:
+    bool shared_;
+};
+
+#include "NodeData.ipp"
+
+#endif
@@ -0,0 +1,72 @@
+
+mpm::NodeData::NodeData(const bool& shared) {
+    shared_ = shared;
+    layout = NULL;
+}
+
+
+void mpm::NodeData::resize(const unsigned& numNodes) {
+    mass.assign(numNodes, 0.);
+    pressure.assign(numNodes, 0.);
+    volume.assign(numNodes, 0.);
+    volStrainRate.assign(numNodes, 0.);
+    for (unsigned i = 0; i < dim; i++) {
+        momentum[i].assign(numNodes, 0.);
+        velocity[i].assign(numNodes, 0.);
+        acceleration[i].assign(numNodes, 0.);
+        extForce[i].assign(numNodes, 0.);
+        intForce[i].assign(numNodes, 0.);
+    }
+}
+
+
+void mpm::NodeData::initialise() {
+    std::fill(mass.begin(), mass.end(), 0.);
+    std::fill(pressure.begin(), pressure.end(), 0.);
+    std::fill(volume.begin(), volume.end(), 0.);
+    std::fill(volStrainRate.begin(), volStrainRate.end(), 0.);
+    for (unsigned i = 0; i < dim; i++) {
+        std::fill(momentum[i].begin(), momentum[i].end(), 0.);
+        std::fill(velocity[i].begin(), velocity[i].end(), 0.);
+        std::fill(acceleration[i].begin(), acceleration[i].end(), 0.);
+        std::fill(extForce[i].begin(), extForce[i].end(), 0.);
+        std::fill(intForce[i].begin(), intForce[i].end(), 0.);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SOLVE_VELOCITY_AND_ACCELERATION
+          v = p / m (values below 1e-15 set to zero), a = (fext + fint) / m
+          and v += dt * a in one pass over the nodes. Nodes without mass
+          (no particles, or particles on the far edge of their elements)
+          get zero velocity and acceleration through 0/1 factors instead
+          of branches, so the loop is vectorized. The velocity constraints,
+          applied once after this kernel, give the same result as when
+          they were applied also to the velocity from momentum.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::NodeData::solve_velocity_and_acceleration(const double& dt, const unsigned& begin, const unsigned& end) {
+    const double* m = mass.data();
+    for (unsigned d = 0; d < dim; d++) {
+        const double* p = momentum[d].data();
+        const double* fExt = extForce[d].data();
+        const double* fInt = intForce[d].data();
+        double* v = velocity[d].data();
+        double* a = acceleration[d].data();
+        const double step = dt;
+#pragma omp simd
+        for (unsigned i = begin; i < end; i++) {
+            // masks as factors 0 or 1: the divisions are done for all
+            // nodes (by 1 for nodes without mass), which keeps the
+            // compiler from moving them into branches
+            const double hasMass = std::fabs(m[i]) > 1.E-15 ? 1. : 0.;
+            const double hasForceMass = std::fabs(m[i]) > 1.E-16 ? 1. : 0.;
+            const double divisor = m[i] + (1. - hasForceMass);
+            double vel = hasMass * (p[i] / divisor);
+            vel = std::fabs(vel) < 1.E-15 ? 0. : vel;
+            const double acc = hasForceMass * ((fExt[i] + fInt[i]) / divisor);
+            a[i] = acc;
+            v[i] = vel + step * acc;
+        }
+    }
+}
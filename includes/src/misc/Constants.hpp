@@ -5,6 +5,16 @@ namespace mpm {
     namespace constants{
         static const unsigned DIM = 2;
         static const unsigned NUMNODES = 4;
+
+        // precision of the stored particle coordinates, velocity and
+        // stress (build with -DMPM_MIXED_PRECISION for float)
+#ifdef MPM_MIXED_PRECISION
+        typedef float ParticleReal;
+        static const bool MIXED_PRECISION = true;
+#else
+        typedef double ParticleReal;
+        static const bool MIXED_PRECISION = false;
+#endif
     }
 }
 
@@ -0,0 +1,102 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Pool allocator for the nodes, elements and particles. Objects of
+      one type are placed one after the other in large blocks (arenas),
+      each slot aligned to a cache line, instead of one heap allocation
+      per object. Freed slots are kept in a free list, so create and
+      destroy are O(1) and never return memory to the system; the blocks
+      are released when the pool is destroyed. With hugePagesFlag the
+      blocks are aligned to 2 MB and marked for transparent huge pages.
+      A pool is not thread safe.
+
+FILE: Pool.hpp
+**************************************************************************/
+#ifndef MPM_MISC_POOL_H
+#define MPM_MISC_POOL_H
+
+// c++ header files
+#include <cstdlib>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include <new>
+#include <utility>
+#include <algorithm>
+
+// system header files
+#include <sys/mman.h>
+
+// mpm header files
+#include "PropertyParse.hpp"
+
+namespace mpm {
+    namespace misc {
+        template <class T> class Pool;
+    }
+}
+
+
+template <class T>
+class mpm::misc::Pool {
+
+public:
+    static const std::size_t cacheLine = 64;
+    static const std::size_t hugePage = 2 * 1024 * 1024;
+
+    // bytes of one object, rounded up to whole cache lines
+    static const std::size_t slotBytes = (sizeof(T) + cacheLine - 1) / cacheLine * cacheLine;
+    // objects in one block (a block is one huge page, or more for very
+    // large objects)
+    static const std::size_t slotsPerBlock = (hugePage / slotBytes) ? (hugePage / slotBytes) : 1;
+
+public:
+    // constructor
+    Pool();
+
+    // destructor: releases the blocks. The objects have to be destroyed
+    // before, the pool does not know which slots are in use.
+    ~Pool();
+
+    // construct an object in a free slot
+    template <typename... Args>
+    T* create(Args&&... args);
+
+    // destroy an object and put its slot in the free list
+    void destroy(T* object);
+
+    // give number of objects in the pool
+    std::size_t size() const {
+        return numObjects_;
+    }
+
+    // give number of bytes allocated by the pool
+    std::size_t capacity_bytes() const {
+        return blocks_.size() * slotsPerBlock * slotBytes;
+    }
+
+private:
+    Pool(const Pool&);
+    Pool& operator=(const Pool&);
+
+    // allocate a new block (2 MB aligned with huge pages)
+    void add_block();
+
+    // a free slot keeps the pointer to the next free slot
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+protected:
+    std::vector<char*> blocks_;
+    // slots of the last block not used yet
+    std::size_t unusedSlots_;
+    FreeSlot* freeList_;
+    std::size_t numObjects_;
+};
+
+#include "Pool.ipp"
+
+#endif
@@ -0,0 +1,82 @@
+
+template <class T>
+const std::size_t mpm::misc::Pool<T>::cacheLine;
+template <class T>
+const std::size_t mpm::misc::Pool<T>::hugePage;
+template <class T>
+const std::size_t mpm::misc::Pool<T>::slotBytes;
+template <class T>
+const std::size_t mpm::misc::Pool<T>::slotsPerBlock;
+
+
+template <class T>
+mpm::misc::Pool<T>::Pool() {
+    unusedSlots_ = 0;
+    freeList_ = NULL;
+    numObjects_ = 0;
+}
+
+
+template <class T>
+mpm::misc::Pool<T>::~Pool() {
+    for (auto block : blocks_)
+        std::free(block);
+    blocks_.clear();
+}
+
+
+template <class T>
+template <typename... Args>
+T* mpm::misc::Pool<T>::create(Args&&... args) {
+    void* slot;
+    if (freeList_) {
+        slot = freeList_;
+        freeList_ = freeList_->next;
+    }
+    else {
+        if (!unusedSlots_)
+            this->add_block();
+        slot = blocks_.back() + (slotsPerBlock - unusedSlots_) * slotBytes;
+        unusedSlots_--;
+    }
+    numObjects_++;
+    return new (slot) T(std::forward<Args>(args)...);
+}
+
+
+template <class T>
+void mpm::misc::Pool<T>::destroy(T* object) {
+    if (!object)
+        return;
+    object->~T();
+    FreeSlot* slot = reinterpret_cast<FreeSlot*>(object);
+    slot->next = freeList_;
+    freeList_ = slot;
+    numObjects_--;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: ADD_BLOCK
+          The block is only reserved here; its pages are touched (and so
+          placed in memory) by the first object constructed in them. With
+          hugePagesFlag the kernel is asked to back the block with 2 MB
+          pages, which cuts the TLB misses of the particle and node loops.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+template <class T>
+void mpm::misc::Pool<T>::add_block() {
+    const std::size_t bytes = slotsPerBlock * slotBytes;
+    const std::size_t alignment = mpm::misc::hugePages ? hugePage : cacheLine;
+
+    void* block = NULL;
+    if (posix_memalign(&block, alignment, bytes)) {
+        std::cerr << "ERROR: in allocating " << bytes << " bytes for a pool block \n";
+        abort();
+    }
+#ifdef MADV_HUGEPAGE
+    if (mpm::misc::hugePages)
+        madvise(block, bytes, MADV_HUGEPAGE);
+#endif
+    blocks_.push_back(static_cast<char*>(block));
+    unusedSlots_ = slotsPerBlock;
+}
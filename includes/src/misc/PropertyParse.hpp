@@ -3,7 +3,8 @@
                        Author: Shyamini Kularathna
                          University of Cambridge
 
-NOTE:
+NOTE: The parameters of input.dat are parsed into a Settings and the
+      parameters of a material into a PropertyList.
 
 FILE: PropertyParse.hpp
 **************************************************************************/
@@ -26,20 +27,84 @@ FILE: PropertyParse.hpp
 
 namespace mpm {
     namespace misc {
-        void PARSE_PROPERTIES(std::string& iLine);
+        // parameters of a material (name, value)
+        typedef std::map<std::string, double> PropertyList;
 
-        bool gravity = 0;
-        bool freeSurface = 0.;
+        struct Settings;
 
-        double dt;
-        unsigned numOfTotalSteps;
-        unsigned numOfSubSteps;
-        std::map<std::string, double> propertyList;
+        void PARSE_PROPERTIES(std::string& iLine, Settings& settings);
 
-        void READ_PROPERTIES(std::string& line);
+        void READ_PROPERTIES(std::string& line, PropertyList& properties);
+
+        // the pools take memory from the process, so hugePagesFlag is not
+        // a setting of a simulation: PARSE_PROPERTIES sets it here, for
+        // the whole process
+        bool hugePages = 0;
     }
 }
 
+
+//! The parameters of input.dat. Each simulation keeps its own copy, so
+//! several simulations can run in one process.
+struct mpm::misc::Settings {
+    bool gravity = 0;
+    bool freeSurface = 0;
+    bool phaseTimer = 0;
+    bool chromeTrace = 0;
+    bool deterministic = 0;
+    bool taskGraph = 0;
+
+    double dt = 0.;
+    unsigned numOfTotalSteps = 0;
+    unsigned numOfSubSteps = 0;
+    unsigned numOfThreads = 0;
+    unsigned tileSize = 0;
+
+    // steady state: the run stops when the relative changes of the nodal
+    // velocity and of the kinetic energy across steadyStateWindow steps
+    // are below steadyStateTolerance (0: never)
+    double steadyStateTolerance = 0.;
+    unsigned steadyStateWindow = 100;
+
+    // quasi-static mode (quasiStaticFlag): the velocity constraints over
+    // numOfSteps * dt are applied in numOfLoadSteps load steps, each one
+    // relaxed with damping ("local" or "kinetic") until the force residual
+    // is below residualTolerance (or maxRelaxationSteps). The inertia of a
+    // particle is scaled up to massScaling times for a stable dt, and the
+    // kinetic energy must be below kineticEnergyRatio times the strain
+    // energy at the end of a load step.
+    bool quasiStatic = 0;
+    unsigned numOfLoadSteps = 10;
+    std::string dampingType = "local";
+    double localDamping = 0.8;
+    double residualTolerance = 1.E-3;
+    unsigned maxRelaxationSteps = 10000;
+    double massScaling = 1.;
+    double kineticEnergyRatio = 0.05;
+
+    // initial stress of the particles (initialStress): "file" reads
+    // initStress.dat (zero stress without it), "hydrostatic" and
+    // "geostatic" generate it from the weight of the particles above with
+    // gravity. The geostatic horizontal stress is K0 times the vertical
+    // one; without K0 (0) that of the material of each particle.
+    std::string initialStress = "file";
+    double K0 = 0.;
+
+    // artificial compressibility (machNumber > 0): the bulk modulus of the
+    // weakly compressible fluids is set so that the flow speed, at first
+    // maxFlowSpeed (0: sqrt(2 g H) of the fluid column), is machNumber
+    // times the speed of sound, and raised with the peak speed of the
+    // particles. dt is then courantNumber times the stable time step.
+    double machNumber = 0.;
+    double maxFlowSpeed = 0.;
+    double courantNumber = 0.2;
+
+    // multi-rate time integration (multiRateLevels > 1): the materials are
+    // grouped in up to multiRateLevels levels by their stable time step
+    // (courantNumber), and level L advances by dt / 2^L.
+    unsigned multiRateLevels = 0;
+};
+
 #include "PropertyParse.ipp"
 
 #endif
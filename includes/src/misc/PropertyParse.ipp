@@ -3,9 +3,9 @@ FUNCTION: PARSE_PROPERTIES
           This fuction first tokenize the given line using white space 
           as the delimiter.
           Then the value correspond to the each parameter is saved by its
-          appropriate type.
+          appropriate type in "settings".
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
-void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
+void mpm::misc::PARSE_PROPERTIES(std::string& iLine, Settings& settings) {
 
     typedef boost::tokenizer<boost::char_separator<char> > tokenizer; 
     boost::char_separator<char> separator(" ");
@@ -16,7 +16,7 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
 
     if (par == "gravityFlag") {
         try {
-            gravity = boost::lexical_cast<int>(*parameter);
+            settings.gravity = boost::lexical_cast<int>(*parameter);
         }
         catch (const boost::bad_lexical_cast &) {
             std::cerr << "ERROR: failed to parse properties" << "\n";
@@ -25,7 +25,34 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
     }
     if (par == "freeSurfaceFlag") {
         try {
-            freeSurface = boost::lexical_cast<int>(*parameter);
+            settings.freeSurface = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "phaseTimerFlag") {
+        try {
+            settings.phaseTimer = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "chromeTraceFlag") {
+        try {
+            settings.chromeTrace = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "hugePagesFlag") {
+        try {
+            mpm::misc::hugePages = boost::lexical_cast<int>(*parameter);
         }
         catch (const boost::bad_lexical_cast &) {
             std::cerr << "ERROR: failed to parse properties" << "\n";
@@ -35,7 +62,7 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
 
     if (par == "dt") {
         try {
-            dt = boost::lexical_cast<double>(*parameter);
+            settings.dt = boost::lexical_cast<double>(*parameter);
         }
         catch (const boost::bad_lexical_cast &) {
             std::cerr << "ERROR: failed to parse properties" << "\n";
@@ -44,7 +71,43 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
     }
     if (par == "numOfSteps") {
         try {
-            numOfTotalSteps = boost::lexical_cast<unsigned>(*parameter);
+            settings.numOfTotalSteps = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "numOfThreads") {
+        try {
+            settings.numOfThreads = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "deterministicFlag") {
+        try {
+            settings.deterministic = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "taskGraphFlag") {
+        try {
+            settings.taskGraph = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "tileSize") {
+        try {
+            settings.tileSize = boost::lexical_cast<unsigned>(*parameter);
         }
         catch (const boost::bad_lexical_cast &) {
             std::cerr << "ERROR: failed to parse properties" << "\n";
@@ -53,7 +116,151 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
     }
     if (par == "numOfSubStep") {
         try {
-            numOfSubSteps = boost::lexical_cast<unsigned>(*parameter);
+            settings.numOfSubSteps = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "steadyStateTolerance") {
+        try {
+            settings.steadyStateTolerance = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "steadyStateWindow") {
+        try {
+            settings.steadyStateWindow = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "quasiStaticFlag") {
+        try {
+            settings.quasiStatic = boost::lexical_cast<int>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "numOfLoadSteps") {
+        try {
+            settings.numOfLoadSteps = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "dampingType") {
+        try {
+            settings.dampingType = boost::lexical_cast<std::string>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "localDamping") {
+        try {
+            settings.localDamping = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "residualTolerance") {
+        try {
+            settings.residualTolerance = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "maxRelaxationSteps") {
+        try {
+            settings.maxRelaxationSteps = boost::lexical_cast<unsigned>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "massScaling") {
+        try {
+            settings.massScaling = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "kineticEnergyRatio") {
+        try {
+            settings.kineticEnergyRatio = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "initialStress") {
+        try {
+            settings.initialStress = boost::lexical_cast<std::string>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "K0") {
+        try {
+            settings.K0 = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "machNumber") {
+        try {
+            settings.machNumber = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "maxFlowSpeed") {
+        try {
+            settings.maxFlowSpeed = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "courantNumber") {
+        try {
+            settings.courantNumber = boost::lexical_cast<double>(*parameter);
+        }
+        catch (const boost::bad_lexical_cast &) {
+            std::cerr << "ERROR: failed to parse properties" << "\n";
+            abort();
+        }
+    }
+    if (par == "multiRateLevels") {
+        try {
+            settings.multiRateLevels = boost::lexical_cast<unsigned>(*parameter);
         }
         catch (const boost::bad_lexical_cast &) {
             std::cerr << "ERROR: failed to parse properties" << "\n";
@@ -69,9 +276,9 @@ void mpm::misc::PARSE_PROPERTIES(std::string& iLine) {
 FUNCTION: READ_PROPERTIES
           This fuction first tokenize the given line using white space 
           as the delimiter.
-          Then the value and the property name is stored in a std::map.
+          Then the value and the property name is stored in "properties".
 ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
-void mpm::misc::READ_PROPERTIES(std::string& line) {
+void mpm::misc::READ_PROPERTIES(std::string& line, PropertyList& properties) {
 
     typedef boost::tokenizer<boost::char_separator<char> > tokenizer; 
     boost::char_separator<char> separator(" ");
@@ -81,6 +288,6 @@ void mpm::misc::READ_PROPERTIES(std::string& line) {
     std::advance(parameter,1);
 
     double propValue = boost::lexical_cast<double>(*parameter);
-    propertyList[propName] = propValue;
+    properties[propName] = propValue;
 
 }
@@ -0,0 +1,136 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Phase timers for the solver loop. A ScopedTimer measures the
+      enclosing scope and reports it to a PhaseTimer, which keeps the
+      per-phase samples and (optionally) the events for a Chrome
+      trace_event file. When the timer is disabled a ScopedTimer only
+      tests a flag.
+
+FILE: Timer.hpp
+**************************************************************************/
+#ifndef MPM_MISC_TIMER_H
+#define MPM_MISC_TIMER_H
+
+// c++ header files
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace mpm {
+    namespace misc {
+        class PhaseTimer;
+        class ScopedTimer;
+    }
+}
+
+
+class mpm::misc::PhaseTimer {
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+public:
+    // constructor
+    PhaseTimer();
+
+    // switch timing and tracing on/off
+    void enable(const bool& timing, const bool& tracing);
+
+    // record one sample of a phase
+    void record(const char* phase, const Clock::time_point& begin, const Clock::time_point& end);
+
+    // write totals, mean and p99 of each phase
+    void write_summary(std::ostream& outFile);
+
+    // write the recorded events in Chrome trace_event format
+    void write_trace(std::ostream& outFile);
+
+    // give status of the timer
+    bool is_enabled() const {
+        return enabled_;
+    }
+
+    // give status of the tracing
+    bool is_tracing() const {
+        return tracing_;
+    }
+
+    // give lane (trace "tid") of the calling thread
+    static unsigned thread_lane();
+
+private:
+    // give index of the phase, registering it if it is new
+    unsigned phase_index(const char* phase);
+
+    // give the p-th percentile of a phase from its histogram
+    double percentile(const unsigned& index, const double& p) const;
+
+    // samples are binned logarithmically, from 10 ns to 1000 s
+    static const unsigned binsPerDecade = 20;
+    static const unsigned numBins = 11 * binsPerDecade;
+    static constexpr double firstBinEdge = 1.E-8;
+    // trace events kept at most (about 40 bytes each)
+    static const unsigned maxTraceEvents = 4000000;
+
+    struct Event {
+        unsigned phase;
+        unsigned lane;
+        double begin;
+        double duration;
+    };
+
+protected:
+    bool enabled_;
+    bool tracing_;
+    Clock::time_point origin_;
+
+    // phase names in order of first appearance
+    std::vector<std::string> names_;
+    std::map<std::string, unsigned> ids_;
+    // number of samples, total time (seconds) and histogram of each phase
+    std::vector<unsigned long> count_;
+    std::vector<double> total_;
+    std::vector<std::vector<unsigned long> > histogram_;
+    // trace events (only if tracing)
+    std::vector<Event> events_;
+
+    std::mutex mutex_;
+};
+
+
+class mpm::misc::ScopedTimer {
+
+public:
+    // constructor: starts the clock if the timer is enabled
+    ScopedTimer(mpm::misc::PhaseTimer& timer, const char* phase)
+        : timer_(timer), phase_(phase), active_(timer.is_enabled()) {
+        if (active_)
+            begin_ = mpm::misc::PhaseTimer::Clock::now();
+    }
+
+    // destructor: reports the elapsed time of the scope
+    ~ScopedTimer() {
+        if (active_)
+            timer_.record(phase_, begin_, mpm::misc::PhaseTimer::Clock::now());
+    }
+
+private:
+    mpm::misc::PhaseTimer& timer_;
+    const char* phase_;
+    bool active_;
+    mpm::misc::PhaseTimer::Clock::time_point begin_;
+};
+
+#include "Timer.ipp"
+
+#endif
@@ -0,0 +1,158 @@
+
+constexpr double mpm::misc::PhaseTimer::firstBinEdge;
+
+mpm::misc::PhaseTimer::PhaseTimer() {
+    enabled_ = false;
+    tracing_ = false;
+    origin_ = Clock::now();
+}
+
+
+void mpm::misc::PhaseTimer::enable(const bool& timing, const bool& tracing) {
+    enabled_ = timing || tracing;
+    tracing_ = tracing;
+    origin_ = Clock::now();
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: THREAD_LANE
+          Each thread which records a sample gets a small, fixed lane
+          number in the order it first reports. The main thread is lane 0
+          as long as it reports first.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+unsigned mpm::misc::PhaseTimer::thread_lane() {
+    static std::mutex laneMutex;
+    static std::map<std::thread::id, unsigned> lanes;
+    thread_local int lane = -1;
+    if (lane < 0) {
+        std::lock_guard<std::mutex> lock(laneMutex);
+        std::thread::id tid = std::this_thread::get_id();
+        if (lanes.find(tid) == lanes.end()) {
+            unsigned newLane = lanes.size();
+            lanes[tid] = newLane;
+        }
+        lane = lanes[tid];
+    }
+    return lane;
+}
+
+
+unsigned mpm::misc::PhaseTimer::phase_index(const char* phase) {
+    std::map<std::string, unsigned>::iterator it = ids_.find(phase);
+    if (it != ids_.end())
+        return it->second;
+    unsigned index = names_.size();
+    names_.push_back(phase);
+    ids_[phase] = index;
+    count_.push_back(0);
+    total_.push_back(0.);
+    histogram_.push_back(std::vector<unsigned long>(numBins, 0));
+    return index;
+}
+
+
+double mpm::misc::PhaseTimer::percentile(const unsigned& index, const double& p) const {
+    const std::vector<unsigned long>& histogram = histogram_.at(index);
+    unsigned long rank = std::ceil(p * count_.at(index));
+    unsigned long cumulative = 0;
+    unsigned bin = 0;
+    for (bin = 0; bin < numBins - 1; bin++) {
+        cumulative += histogram.at(bin);
+        if (cumulative >= rank)
+            break;
+    }
+    // upper edge of the bin
+    return firstBinEdge * std::pow(10., double(bin + 1) / binsPerDecade);
+}
+
+
+void mpm::misc::PhaseTimer::record(const char* phase, const Clock::time_point& begin, const Clock::time_point& end) {
+    unsigned lane = thread_lane();
+    double duration = std::chrono::duration<double>(end - begin).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    unsigned index = phase_index(phase);
+    count_.at(index) += 1;
+    total_.at(index) += duration;
+    double bin = std::floor(binsPerDecade * std::log10(std::max(duration, firstBinEdge) / firstBinEdge));
+    histogram_.at(index).at(std::min(unsigned(bin), numBins - 1)) += 1;
+
+    if (tracing_ && events_.size() < maxTraceEvents) {
+        Event event;
+        event.phase = index;
+        event.lane = lane;
+        event.begin = std::chrono::duration<double>(begin - origin_).count();
+        event.duration = duration;
+        events_.push_back(event);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: WRITE_SUMMARY
+          For each phase, the number of samples, the total time, the mean
+          and the 99th percentile of a sample are written, followed by the
+          share of the sum of all phases. The p99 is the upper edge of its
+          histogram bin, i.e. it is accurate to about 12%.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::misc::PhaseTimer::write_summary(std::ostream& outFile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    double allPhases = 0.;
+    for (const auto& total : total_)
+        allPhases += total;
+
+    outFile << "\n \t Phase timings \n";
+    outFile << std::left;
+    outFile.width(56); outFile << "phase";
+    outFile.width(10); outFile << "count";
+    outFile.width(14); outFile << "total(s)";
+    outFile.width(14); outFile << "mean(ms)";
+    outFile.width(14); outFile << "p99(ms)";
+    outFile << "share(%)" << "\n";
+
+    for (unsigned i = 0; i < names_.size(); i++) {
+        if (!count_.at(i))
+            continue;
+        outFile.width(56); outFile << names_.at(i);
+        outFile.width(10); outFile << count_.at(i);
+        outFile.width(14); outFile << total_.at(i);
+        outFile.width(14); outFile << 1.E3 * total_.at(i) / count_.at(i);
+        outFile.width(14); outFile << 1.E3 * percentile(i, 0.99);
+        outFile << (allPhases > 0. ? 100. * total_.at(i) / allPhases : 0.) << "\n";
+    }
+    outFile << std::right;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: WRITE_TRACE
+          Writes complete ("X") events in the JSON format read by
+          chrome://tracing and Perfetto. Every thread lane becomes one row
+          of the timeline. Times are in microseconds.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::misc::PhaseTimer::write_trace(std::ostream& outFile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    unsigned numLanes = 0;
+    for (const auto& event : events_)
+        numLanes = std::max(numLanes, event.lane + 1);
+
+    outFile.precision(15);
+    outFile << "{\"traceEvents\":[";
+    std::string separator = "\n";
+    for (unsigned i = 0; i < numLanes; i++) {
+        outFile << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i;
+        outFile << ",\"args\":{\"name\":\"" << (i ? "worker " : "main ") << i << "\"}}";
+        separator = ",\n";
+    }
+    for (const auto& event : events_) {
+        outFile << separator << "{\"name\":\"" << names_.at(event.phase) << "\",\"ph\":\"X\",\"pid\":0";
+        outFile << ",\"tid\":" << event.lane;
+        outFile << ",\"ts\":" << 1.E6 * event.begin;
+        outFile << ",\"dur\":" << 1.E6 * event.duration << "}";
+        separator = ",\n";
+    }
+    outFile << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
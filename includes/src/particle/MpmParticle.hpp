@@ -11,12 +11,19 @@ FILE: MpmParticle.hpp
 #include <vector>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 // eigen header files
 #include <Eigen/Dense>
 
 // mpm header files
 #include "Constants.hpp"
+#include "Pool.hpp"
 #include "Particle.hpp"
 #include "MaterialBase.hpp"
 
@@ -40,15 +47,50 @@ protected:
     typedef Eigen::Matrix<double, 1, 6>   VectorD6x1;
 
 public:
-    // constructor
-    MpmParticle();
+    // constructor; with "gravity" the particles carry a body force of
+    // -9.81 m/s^2 in the last direction
+    MpmParticle(const bool& gravity);
 
     // Destructor
     //! Free all dynamically allocated memory within this class
     ~MpmParticle();
 
     // read particles
-    void read_particles(std::ifstream& pFile, std::ifstream& sFile);
+    void read_particles(std::istream& pFile, std::istream& sFile);
+
+    // add a particle at given coordinates
+    ParticlePtr add_particle(const VectorDDIM& coord, const unsigned& matId, const VectorDDIM& spacing);
+
+    // insert a particle during the run; it is sorted into the range of its
+    // material at the next compaction
+    ParticlePtr insert_particle(const VectorDDIM& coord, const unsigned& matId, const VectorDDIM& velocity);
+
+    // mark the particle of given index for removal (a tombstone)
+    void remove_particle(const unsigned& index);
+
+    // drop the removed particles and sort in the inserted ones
+    void compact();
+
+    // true if particles were inserted or more than 1/removedShare of the
+    // particles are removed since the last compaction
+    bool compaction_due() const {
+        return numInserted_ || removedShare * numRemoved_ > particles_.size();
+    }
+
+    // give number of particles marked for removal
+    unsigned number_of_removed_particles() const {
+        return numRemoved_;
+    }
+
+    // give spacing of the particles
+    VectorDDIM give_spacing() const {
+        return spacing_;
+    }
+
+    // give gravity (body force per unit mass) of the particles
+    VectorDDIM give_gravity() const {
+        return gravity_;
+    }
 
     // Read traction at particles
     //! param[in] tractionFile input file for traction force at particles
@@ -57,10 +99,57 @@ public:
     // assign material to particle
     void assign_material_to_particles(VecOfMaterialBasePtr& materialPtrs);
 
+    // generate the initial stress of the particles from the weight of the
+    // particles above them, after the materials are assigned: hydrostatic,
+    // or geostatic with the horizontal stress K0 times the vertical one
+    // (K0 <= 0: K0 of the material of each particle)
+    void generate_initial_stress(const bool& geostatic, const double& K0);
+
+    // sort the particles by material id, so each material is a range
+    void group_particles_by_material();
+
+    // give number of materials, the material of given id and the range
+    // [begin, end) of its particles
+    unsigned number_of_materials() const {
+        return materials_.size();
+    }
+    MaterialBasePtr give_material(const unsigned& material) const {
+        return materials_.at(material);
+    }
+    void material_range(const unsigned& material, unsigned& begin, unsigned& end) const {
+        begin = materialOffsets_.at(material);
+        end = materialOffsets_.at(material + 1);
+    }
+
+    // compute stress of the particles, one batch per material
+    void compute_stress(const double& dt);
+
+    // compute stress of the particles [begin, end) (of any materials)
+    void compute_stress(const unsigned& begin, const unsigned& end, const double& dt);
+
+    // compute local coordinates, shape functions and their global
+    // derivatives of the particles, in batches of ShapeBatch::width
+    void compute_shape_functions();
+
+    // compute shape functions of the particles [begin, end)
+    void compute_shape_functions(const unsigned& begin, const unsigned& end) {
+        this->compute_shape_functions_of_range(begin, end);
+    }
+
     // Iterate over particles
     template<typename FP>
     void iterate_over_particles(FP function);
 
+    // Iterate over the particles [begin, end)
+    template<typename FP>
+    void iterate_over_particles(const unsigned& begin, const unsigned& end, FP function);
+
+    // split the particles [begin, end) in one contiguous share per thread
+    // and call function(first, last) for each share (e.g. the batched
+    // kernels of a range)
+    template<typename FR>
+    void iterate_over_shares(const unsigned& begin, const unsigned& end, FR function);
+
     // give total number of particles
     unsigned number_of_particles() {
         return particles_.size();
@@ -90,9 +179,42 @@ public:
     void write_particle_strain_data_to_file(std::ostream& outFile);
 
 
+private:
+    // find the range of each material in the sorted particles
+    void compute_material_offsets();
+
+    // compute stress of the particles [begin, end) of one material
+    void compute_stress_of_range(MaterialBasePtr material, const unsigned& begin, const unsigned& end, const double& dt);
+
+    // compute shape functions of the particles [begin, end)
+    void compute_shape_functions_of_range(const unsigned& begin, const unsigned& end);
+
+    // number of particles in a StressBatch
+    static const unsigned batchSize = 128;
+
+    // removed particles are dropped once they are more than 1/removedShare
+    // of the particles
+    static const unsigned removedShare = 16;
+
 protected:
+    // 0. Storage of the particles
+    mpm::misc::Pool<mpm::Particle> particlePool_;
+
     // 1. Pointers to the all particles
     std::vector<mpm::Particle*> particles_;
+
+    // 2. Materials. The particles of material m are
+    //    particles_[materialOffsets_[m], materialOffsets_[m + 1])
+    VecOfMaterialBasePtr materials_;
+    std::vector<unsigned> materialOffsets_;
+
+    // 3. Spacing and gravity of the particles, id of the next inserted particle and the
+    //    number of particles removed and inserted since the last compaction
+    VectorDDIM spacing_;
+    VectorDDIM gravity_;
+    unsigned nextId_;
+    unsigned numRemoved_;
+    unsigned numInserted_;
 };
 
 #include "MpmParticle.ipp"
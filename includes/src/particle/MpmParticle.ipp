@@ -1,18 +1,28 @@
 
-mpm::MpmParticle::MpmParticle() {
+const unsigned mpm::MpmParticle::batchSize;
+const unsigned mpm::MpmParticle::removedShare;
+
+mpm::MpmParticle::MpmParticle(const bool& gravity) {
     particles_.clear();
+    spacing_ = VectorDDIM::Zero();
+    gravity_ = VectorDDIM::Zero();
+    if (gravity)
+        gravity_(dim - 1) = -9.81;
+    nextId_ = 0;
+    numRemoved_ = 0;
+    numInserted_ = 0;
 }
 
 mpm::MpmParticle::~MpmParticle() {
   for (auto pPtr : particles_)
-    delete pPtr;
+    particlePool_.destroy(pPtr);
   particles_.clear();
 }
 
 
-void mpm::MpmParticle::read_particles(std::ifstream& pFile, std::ifstream& sFile) {
+void mpm::MpmParticle::read_particles(std::istream& pFile, std::istream& sFile) {
     std::string line;
-    unsigned numOfParticles, matId;
+    unsigned numOfParticles, matId, pMatId;
     VectorDDIM spacing, coordinates;
     VectorD6x1 iStress;
 
@@ -25,23 +35,29 @@ void mpm::MpmParticle::read_particles(std::ifstream& pFile, std::ifstream& sFile
     std::istringstream space(line);
     for (unsigned i = 0; i < dim; i++)
         space >> spacing(i);
+    spacing_ = spacing;
 
+    // a material id after the coordinates overrides the one of the header
     for (unsigned i = 0; i < numOfParticles; i++) {
-        ParticlePtr particle = new Particle(i, matId, spacing);
         std::getline(pFile, line);
         std::istringstream coord(line);
         for (unsigned j = 0; j < dim; j++)
             coord >> coordinates(j);
+        if (!(coord >> pMatId))
+            pMatId = matId;
+        ParticlePtr particle = particlePool_.create(i, pMatId, spacing, gravity_);
         particle->set_coordinates(coordinates);
         particles_.push_back(particle);
     }
+    nextId_ = numOfParticles;
 
-    // read particle initial stress
-    unsigned numOfInitStressParticles;
+    // read particle initial stress (none in an empty stream)
+    unsigned numOfInitStressParticles = 0;
     unsigned particleId;
-    std::getline(sFile, line);
-    std::istringstream is(line);
-    is >> numOfInitStressParticles;
+    if (std::getline(sFile, line)) {
+        std::istringstream is(line);
+        is >> numOfInitStressParticles;
+    }
     for (unsigned i = 0; i < numOfInitStressParticles; i++) {
         std::getline(sFile, line);
         std::istringstream stress(line);
@@ -53,20 +69,380 @@ void mpm::MpmParticle::read_particles(std::ifstream& pFile, std::ifstream& sFile
 }
 
 
+typedef mpm::Particle* ParticlePtr;
+ParticlePtr mpm::MpmParticle::add_particle(const VectorDDIM& coord, const unsigned& matId, const VectorDDIM& spacing) {
+    ParticlePtr particle = particlePool_.create(nextId_++, matId, spacing, gravity_);
+    particle->set_coordinates(coord);
+    particles_.push_back(particle);
+    spacing_ = spacing;
+    return particle;
+}
+
+
+ParticlePtr mpm::MpmParticle::insert_particle(const VectorDDIM& coord, const unsigned& matId, const VectorDDIM& velocity) {
+    if (matId >= materials_.size()) {
+        std::cerr << "ERROR: no material " << matId << " for an inserted particle \n";
+        abort();
+    }
+    ParticlePtr particle = particlePool_.create(nextId_++, matId, spacing_, gravity_);
+    particle->set_coordinates(coord);
+    particle->set_velocity(velocity);
+    particle->set_material(materials_);
+    particles_.push_back(particle);
+    numInserted_++;
+    return particle;
+}
+
+
+void mpm::MpmParticle::remove_particle(const unsigned& index) {
+    ParticlePtr particle = particles_.at(index);
+    if (particle->is_removed())
+        return;
+    particle->set_removed();
+    numRemoved_++;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPACT
+          Removed particles stay in place (as massless tombstones) until
+          this function is called, which drops all of them in one pass and
+          gives their slots back to the pool, where the next inserted
+          particles find them. The inserted particles, which are at the
+          end, are then merged into the ranges of their materials. Both
+          steps are stable, so the order of the other particles is kept.
+          The storage of the pointers is not reallocated unless the number
+          of particles grows beyond its largest value. The solver calls it
+          only when compaction_due(), so the pass is amortised over the
+          steps which remove a few particles each.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::compact() {
+    if (!numRemoved_ && !numInserted_)
+        return;
+
+    // particles before "sorted" are sorted by material
+    const unsigned sorted = materialOffsets_.empty() ? 0 : materialOffsets_.back();
+    unsigned kept = 0;
+    unsigned keptSorted = 0;
+    for (unsigned i = 0; i < particles_.size(); i++) {
+        ParticlePtr particle = particles_[i];
+        if (particle->is_removed()) {
+            particlePool_.destroy(particle);
+            continue;
+        }
+        particles_[kept++] = particle;
+        if (i < sorted)
+            keptSorted = kept;
+    }
+    particles_.resize(kept);
+
+    auto byMaterial = [](const ParticlePtr& a, const ParticlePtr& b) {
+        return a->give_mat_id() < b->give_mat_id();
+    };
+    std::stable_sort(particles_.begin() + keptSorted, particles_.end(), byMaterial);
+    std::inplace_merge(particles_.begin(), particles_.begin() + keptSorted, particles_.end(), byMaterial);
+    this->compute_material_offsets();
+
+    numRemoved_ = 0;
+    numInserted_ = 0;
+}
+
 
 void mpm::MpmParticle::assign_material_to_particles(VecOfMaterialBasePtr& materialPtrs) {
 
-    for (const auto& particle : particles_)
+    for (const auto& particle : particles_) {
+        if (particle->give_mat_id() >= materialPtrs.size()) {
+            std::cerr << "ERROR: particle " << particle->give_id() << " has material id " << particle->give_mat_id();
+            std::cerr << " but only " << materialPtrs.size() << " materials are given \n";
+            abort();
+        }
         particle->set_material(materialPtrs);
+    }
+    materials_ = materialPtrs;
+    this->group_particles_by_material();
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: GENERATE_INITIAL_STRESS
+          The particles are binned into vertical columns of the width of
+          the particle spacing and each column is sorted from the top.
+          Going down a column, the vertical stress of a particle is the
+          weight of the particles above it and of the upper half of
+          itself, rho g h over the vertical spacing h of each particle,
+          so layers of different density and a free surface which is not
+          flat are followed. The columns are independent and are done in
+          parallel. Stresses are negative in compression; the shear
+          stresses are zero.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::generate_initial_stress(const bool& geostatic, const double& K0) {
+    const unsigned vertical = dim - 1;
+    const double g = -gravity_(vertical);
+    if (g <= 0.) {
+        std::cerr << "ERROR: the initial stress is generated from the weight of the particles (gravityFlag)" << "\n";
+        abort();
+    }
+    if (materials_.empty()) {
+        std::cerr << "ERROR: the initial stress is generated after the materials are assigned" << "\n";
+        abort();
+    }
+
+    const unsigned numOfParticles = particles_.size();
+    if (!numOfParticles)
+        return;
+
+    // column of each particle, numbered over the horizontal directions
+    VectorDDIM minCoord = particles_[0]->give_coordinates();
+    VectorDDIM maxCoord = minCoord;
+    for (unsigned i = 1; i < numOfParticles; i++) {
+        const VectorDDIM coord = particles_[i]->give_coordinates();
+        minCoord = minCoord.cwiseMin(coord);
+        maxCoord = maxCoord.cwiseMax(coord);
+    }
+    std::vector<std::pair<long, unsigned> > order;
+    order.reserve(numOfParticles);
+    for (unsigned i = 0; i < numOfParticles; i++) {
+        const VectorDDIM coord = particles_[i]->give_coordinates();
+        long column = 0;
+        for (unsigned d = 0; d < vertical; d++) {
+            const long numColumns = std::lround((maxCoord(d) - minCoord(d)) / spacing_(d)) + 1;
+            column = column * numColumns + std::lround((coord(d) - minCoord(d)) / spacing_(d));
+        }
+        order.push_back(std::make_pair(column, i));
+    }
+    std::sort(order.begin(), order.end(), [&](const std::pair<long, unsigned>& a, const std::pair<long, unsigned>& b) {
+        if (a.first != b.first)
+            return a.first < b.first;
+        return particles_[a.second]->give_coordinates()(vertical) > particles_[b.second]->give_coordinates()(vertical);
+    });
+    std::vector<unsigned> columnStarts;
+    for (unsigned i = 0; i < order.size(); i++) {
+        if (i == 0 || order[i].first != order[i - 1].first)
+            columnStarts.push_back(i);
+    }
+    columnStarts.push_back(order.size());
+
+    const int numColumns = columnStarts.size() - 1;
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int c = 0; c < numColumns; c++) {
+        double weight = 0.;
+        for (unsigned i = columnStarts[c]; i < columnStarts[c + 1]; i++) {
+            ParticlePtr particle = particles_[order[i].second];
+            MaterialBasePtr material = materials_[particle->give_mat_id()];
+            const double halfWeight = 0.5 * material->giveDensity() * g * particle->give_spacing()(vertical);
+            const double verticalStress = -(weight + halfWeight);
+            weight += 2. * halfWeight;
+
+            double lateral = 1.;
+            if (geostatic)
+                lateral = (K0 > 0.) ? K0 : material->giveK0();
+            VectorD6x1 stress = VectorD6x1::Zero();
+            for (unsigned d = 0; d < 3; d++)
+                stress(d) = lateral * verticalStress;
+            stress(vertical) = verticalStress;
+            particle->set_initial_stress(stress);
+        }
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: GROUP_PARTICLES_BY_MATERIAL
+          The particles are sorted by material id (stable, so a single
+          material keeps the order of particles.dat) and the range of each
+          material is recorded. The particles keep their ids (their line
+          in particles.dat), but the results are written in this order.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::group_particles_by_material() {
+    std::stable_sort(particles_.begin(), particles_.end(), [](const ParticlePtr& a, const ParticlePtr& b) {
+        return a->give_mat_id() < b->give_mat_id();
+    });
+    this->compute_material_offsets();
+}
+
+
+void mpm::MpmParticle::compute_material_offsets() {
+    materialOffsets_.assign(materials_.size() + 1, 0);
+    for (const auto& particle : particles_)
+        materialOffsets_.at(particle->give_mat_id() + 1) += 1;
+    for (unsigned m = 0; m < materials_.size(); m++)
+        materialOffsets_.at(m + 1) += materialOffsets_.at(m);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE_STRESS
+          Same update as Particle::compute_stress, but the particles of each
+          material are updated in batches: the stress state of up to
+          batchSize particles is gathered in a StressBatch, the material
+          computes the stress of the whole batch in one call (no virtual
+          call per particle), and the results are scattered back. The
+          batch is small enough to stay in L1 cache while its particles
+          are still in cache. The particles of a material are contiguous
+          (see group_particles_by_material). When running in parallel each
+          thread takes a contiguous share of the particles of the material.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::compute_stress(const double& dt) {
+    for (unsigned m = 0; m < materials_.size(); m++) {
+        const unsigned first = materialOffsets_.at(m);
+        const unsigned n = materialOffsets_.at(m + 1) - first;
+        MaterialBasePtr material = materials_.at(m);
+
+#ifdef _OPENMP
+        if (omp_get_max_threads() > 1) {
+#pragma omp parallel
+            {
+                unsigned numThreads = omp_get_num_threads();
+                unsigned thread = omp_get_thread_num();
+                unsigned begin = (unsigned long)n * thread / numThreads;
+                unsigned end = (unsigned long)n * (thread + 1) / numThreads;
+                this->compute_stress_of_range(material, first + begin, first + end, dt);
+            }
+            continue;
+        }
+#endif
+        this->compute_stress_of_range(material, first, first + n, dt);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE_STRESS (OF THE PARTICLES [BEGIN, END))
+          The range is cut at the ranges of the materials. The stress of
+          a particle does not depend on the other particles of its batch,
+          so the results are the same as compute_stress().
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::compute_stress(const unsigned& begin, const unsigned& end, const double& dt) {
+    for (unsigned m = 0; m < materials_.size(); m++) {
+        const unsigned first = std::max(begin, materialOffsets_.at(m));
+        const unsigned last = std::min(end, materialOffsets_.at(m + 1));
+        if (first < last)
+            this->compute_stress_of_range(materials_.at(m), first, last, dt);
+    }
+}
+
+
+void mpm::MpmParticle::compute_stress_of_range(MaterialBasePtr material, const unsigned& begin, const unsigned& end, const double& dt) {
+    double dStrain[dof * batchSize];
+    double dVolStrain[batchSize];
+    double stress[6 * batchSize];
+    double pressure[batchSize];
+
+    mpm::material::StressBatch batch;
+    batch.stride = batchSize;
+    batch.dt = dt;
+    batch.dStrain = dStrain;
+    batch.dVolStrain = dVolStrain;
+    batch.stress = stress;
+    batch.pressure = pressure;
+
+    for (unsigned first = begin; first < end; first += batchSize) {
+        batch.size = std::min(end - first, batchSize);
+        for (unsigned i = 0; i < batch.size; i++)
+            particles_[first + i]->gather_stress_state(batch, i, dt);
+        material->computeStress(batch);
+        for (unsigned i = 0; i < batch.size; i++)
+            particles_[first + i]->scatter_stress_state(batch, i);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE_SHAPE_FUNCTIONS
+          Replaces the passes compute_local_coordinates,
+          compute_shape_functions and
+          compute_global_derivatives_shape_functions over the particles
+          (same results). The particles are taken in order, ShapeBatch::width
+          at a time; the unused entries of the last batch are padded with
+          a particle at the centre of a unit element. When running in
+          parallel each thread takes a contiguous share of the particles.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmParticle::compute_shape_functions() {
+    const unsigned n = particles_.size();
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1) {
+#pragma omp parallel
+        {
+            unsigned numThreads = omp_get_num_threads();
+            unsigned thread = omp_get_thread_num();
+            unsigned begin = (unsigned long)n * thread / numThreads;
+            unsigned end = (unsigned long)n * (thread + 1) / numThreads;
+            this->compute_shape_functions_of_range(begin, end);
+        }
+        return;
+    }
+#endif
+    this->compute_shape_functions_of_range(0, n);
+}
+
+
+void mpm::MpmParticle::compute_shape_functions_of_range(const unsigned& begin, const unsigned& end) {
+    const unsigned width = mpm::ShapeBatch::width;
+    mpm::ShapeBatch batch;
+    for (unsigned first = begin; first < end; first += width) {
+        batch.size = std::min(end - first, width);
+        for (unsigned i = 0; i < batch.size; i++)
+            particles_[first + i]->gather_shape_state(batch, i);
+        for (unsigned i = batch.size; i < width; i++) {
+            for (unsigned k = 0; k < dim; k++) {
+                batch.coord[k * width + i] = 0.;
+                batch.centre[k * width + i] = 0.;
+                batch.length[k * width + i] = 1.;
+            }
+        }
+        batch.compute();
+        for (unsigned i = 0; i < batch.size; i++)
+            particles_[first + i]->scatter_shape_state(batch, i);
+    }
 }
 
 
 template<typename FP>
 void mpm::MpmParticle::iterate_over_particles(FP function) {
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(static)
+    for (unsigned i = 0; i < particles_.size(); i++)
+      function(particles_[i]);
+    return;
+  }
+#endif
   std::for_each(particles_.begin(), particles_.end(), function);
 }
 
 
+template<typename FP>
+void mpm::MpmParticle::iterate_over_particles(const unsigned& begin, const unsigned& end, FP function) {
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(static)
+    for (unsigned i = begin; i < end; i++)
+      function(particles_[i]);
+    return;
+  }
+#endif
+  std::for_each(particles_.begin() + begin, particles_.begin() + end, function);
+}
+
+
+template<typename FR>
+void mpm::MpmParticle::iterate_over_shares(const unsigned& begin, const unsigned& end, FR function) {
+  const unsigned n = end - begin;
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel
+    {
+      unsigned numThreads = omp_get_num_threads();
+      unsigned thread = omp_get_thread_num();
+      function(begin + (unsigned)((unsigned long)n * thread / numThreads), begin + (unsigned)((unsigned long)n * (thread + 1) / numThreads));
+    }
+    return;
+  }
+#endif
+  function(begin, end);
+}
+
+
 
 
 
@@ -9,8 +9,10 @@ File: Particle.hpp
 
 // c++ header files
 #include <vector>
+#include <array>
 #include <fstream>
 #include <iostream>
+#include <cmath>
 
 // eigen header files
 #include <Eigen/Dense>
@@ -20,8 +22,8 @@ File: Particle.hpp
 
 // mpm header files
 #include "Constants.hpp"
-#include "Node.hpp"
-#include "Element.hpp"
+#include "NodeData.hpp"
+#include "ShapeBatch.hpp"
 #include "MaterialBase.hpp"
 
 namespace mpm {
@@ -36,14 +38,11 @@ protected:
     static const unsigned numNodes = mpm::constants::NUMNODES;
     static const unsigned dof = 3 * (dim - 1);
 
-    typedef mpm::Element* ElementPtr;
-    typedef mpm::Node* NodePtr;
     typedef mpm::material::MaterialBase* MaterialBasePtr;
 
     typedef Eigen::Matrix<double, 1, dim>        VectorDDIM;
     typedef Eigen::Matrix<double, 1, dof>        VectorDDOF;
     typedef Eigen::Matrix<double, 1, 6>          VectorD1x6;
-    typedef Eigen::Matrix<NodePtr,1, numNodes>   VectorNPtrNN;
  
     typedef Eigen::Matrix<double, dim, dim>      MatrixDDIMDIM;
     typedef Eigen::Matrix<double, dof, dim>      MatrixDDOFDIM;
@@ -55,23 +54,65 @@ protected:
     typedef Eigen::Matrix<double, 1, numNodes>   VectorDNN;
     typedef Eigen::Matrix<double, dim, numNodes> MatrixDDIMNN;
 
+    typedef std::array<mpm::NodeData::Field, dim> NodalVectorField;
+
+    // stored particle state (float in a mixed precision build)
+    typedef mpm::constants::ParticleReal               StoredReal;
+    typedef Eigen::Matrix<StoredReal, 1, dim>          StoredVectorDDIM;
+    typedef Eigen::Matrix<StoredReal, 1, 6>            StoredVectorD1x6;
+
 public:
+    // ids of the nodes of an element, in the numbering of a grid
+    typedef std::array<unsigned, numNodes>       NodeIds;
 
-    // constructor
-    Particle(const unsigned& id, const unsigned& matID, const VectorDDIM& spacing);
+    // fixed size Eigen members need an aligned new
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    // constructor; "gravity" is the body force per unit mass
+    Particle(const unsigned& id, const unsigned& matID, const VectorDDIM& spacing, const VectorDDIM& gravity);
 
     // initialise particle
     void initialise_particle();
 
     // set coordinates
     void set_coordinates(const Eigen::Matrix<double, 1, dim> &coord) {
-        coord_ = coord;
+        if (mpm::constants::MIXED_PRECISION)
+            coord_ = (coord - this->coordinate_origin()).cast<StoredReal>();
+        else
+            coord_ = coord.cast<StoredReal>();
+    }
+
+    // set velocity
+    void set_velocity(const VectorDDIM& velocity) {
+        velocity_ = velocity.cast<StoredReal>();
+    }
+
+    // mark the particle as removed; until the next compaction it stays in
+    // place without mass, volume and velocity, so it adds nothing to the nodes
+    void set_removed() {
+        removed_ = true;
+        mass_ = 0.;
+        volume_ = 0.;
+        velocity_.setZero();
     }
 
-    // set element and nodes
-    void set_element_and_nodes(const ElementPtr& ptrE, const VectorNPtrNN& ptrsN) {
-        element_ = ptrE;
-        nodes_   = ptrsN;
+    // set element; its nodes follow from the layout of the grid
+    void set_element(const unsigned& element, mpm::NodeData* nodeData) {
+        if (mpm::constants::MIXED_PRECISION) {
+            // the stored coordinates move to the origin of the new element
+            const VectorDDIM coord = this->give_coordinates();
+            element_ = element;
+            nodeData_ = nodeData;
+            this->set_coordinates(coord);
+            return;
+        }
+        element_ = element;
+        nodeData_ = nodeData;
+    }
+
+    // give element
+    unsigned give_element() const {
+        return element_;
     }
 
     // set initial stress
@@ -83,20 +124,32 @@ public:
     //set initial velocity
     void set_initial_velocity();
 
+    // give ids of the nodes of the element in the mesh
+    NodeIds give_node_ids() const {
+        NodeIds nodes;
+        const unsigned first = nodeData_->first_node(element_);
+        for (unsigned i = 0; i < numNodes; i++)
+            nodes[i] = first + nodeData_->layout->nodeOffsets[i];
+        return nodes;
+    }
+
     // map mass to nodes
     void map_mass_to_nodes();
 
+    // map mass to the nodes "nodes" of a grid (the mesh, or a tile)
+    void map_mass_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
+
     // map volume to nodes
     void map_volume_to_nodes();
 
+    // map volume to the nodes "nodes" of a grid
+    void map_volume_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
+
     // map momentum to nodes
     void map_momentum_to_nodes();
 
-    // map momentum to nodes specially begining of time step 
-    void map_momentum_to_nodes_at_begin();
-
-    // map momentum to nodes specially end of time step
-    void map_momentum_to_nodes_at_end();
+    // map momentum to the nodes "nodes" of a grid
+    void map_momentum_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
 
     // map pressure to nodes
     void map_pressure_to_nodes();
@@ -104,15 +157,24 @@ public:
     // map volumetric strain rate to nodes
     void map_volumetric_strain_rate_to_nodes();
 
+    // map volumetric strain rate to the nodes "nodes" of a grid
+    void map_volumetric_strain_rate_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
+
     // assign body force to nodes
     void assign_body_force_to_nodes();
 
+    // assign body force to the nodes "nodes" of a grid
+    void assign_body_force_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
+
     // assign traction force to nodes
     void assign_traction_force_to_nodes();
 
     // assign internal force to nodes
     void assign_internal_force_to_nodes();
 
+    // assign internal force to the nodes "nodes" of a grid
+    void assign_internal_force_to_grid(mpm::NodeData& grid, const NodeIds& nodes);
+
     // compute strain rate
     void compute_strain_rate();
 
@@ -129,10 +191,24 @@ public:
     void compute_centre_vol_strain_rate_from_nodes();
 
     // compute strain
-    void compute_strain();
+    void compute_strain(const double& dt);
 
     // compute stress
-    void compute_stress();
+    void compute_stress(const double& dt);
+
+    // copy coordinates, centre and length of the element to entry i of a
+    // batch
+    void gather_shape_state(mpm::ShapeBatch& batch, const unsigned& i) const;
+
+    // copy local coordinates, shape functions and derivatives back from
+    // entry i of a batch
+    void scatter_shape_state(const mpm::ShapeBatch& batch, const unsigned& i);
+
+    // copy strain increment, stress and pressure to entry i of a batch
+    void gather_stress_state(const mpm::material::StressBatch& batch, const unsigned& i, const double& dt) const;
+
+    // copy stress and pressure back from entry i of a batch
+    void scatter_stress_state(const mpm::material::StressBatch& batch, const unsigned& i);
 
     // compute stress using enhanced strain
     void compute_stress_BBar_method();
@@ -140,11 +216,17 @@ public:
     // update velocity
     void update_velocity(const double& dt);
 
+    // update velocity from the nodes "nodes" of a grid
+    void update_velocity_from_grid(const mpm::NodeData& grid, const NodeIds& nodes, const double& dt);
+
     // update position
     void update_position(const double& dt);
 
+    // update position from the nodes "nodes" of a grid
+    void update_position_from_grid(const mpm::NodeData& grid, const NodeIds& nodes, const double& dt);
+
     // update density
-    void update_density();
+    void update_density(const double& dt);
 
     // update pressure
     void update_pressure();
@@ -156,7 +238,9 @@ public:
 
     // give particle coordinates
     VectorDDIM give_coordinates() const {
-        return coord_;
+        if (mpm::constants::MIXED_PRECISION)
+            return this->coordinate_origin() + coord_.cast<double>();
+        return coord_.cast<double>();
     }
 
     // give particle spacing
@@ -166,12 +250,78 @@ public:
 
     // give particle material id
     unsigned give_mat_id() const {
-        unsigned mat_id_;
+        return mat_id_;
     }
 
+    // give particle mass
+    double give_mass() const {
+        return mass_;
+    }
+
+    // give particle density
+    double give_density() const {
+        return density_;
+    }
+
+    // give the speed of the pressure waves in the particle (0 if its
+    // material does not give a modulus)
+    double give_wave_speed() const {
+        return std::sqrt(material_->giveWaveModulus() / density_);
+    }
+
+    // give the strain energy of the particle, 0.5 stress : strain times
+    // its volume (of a linear material from a state without stress)
+    double give_strain_energy() const;
+
     // give particle velocity
     VectorDDIM give_velocity() const {
-        return velocity_;
+        return velocity_.cast<double>();
+    }
+
+    // give particle volume, stress, pressure and strain
+    double give_volume() const {
+        return volume_;
+    }
+    VectorD1x6 give_stress() const {
+        return stress_.cast<double>();
+    }
+    double give_pressure() const {
+        return pressure_;
+    }
+    VectorDDOF give_strain() const {
+        return strain_;
+    }
+
+    // set the state of the particle computed outside of it (e.g. in a lane
+    // of a LaneEnsemble); the volume follows from the density
+    void set_state(const VectorDDIM& coord, const VectorDDIM& velocity, const VectorD1x6& stress, const double& pressure, const VectorDDOF& strain, const double& density) {
+        this->set_coordinates(coord);
+        this->set_velocity(velocity);
+        stress_ = stress.cast<StoredReal>();
+        pressure_ = pressure;
+        strain_ = strain;
+        density_ = density;
+        volume_ = mass_ / density_;
+    }
+
+    // give local coordinates in the element
+    VectorDDIM give_local_coordinates() const {
+        return xi_;
+    }
+
+    // give shape functions
+    VectorDNN give_shape_functions() const {
+        return shape_fun_;
+    }
+
+    // give global derivatives of shape functions
+    MatrixDDIMNN give_global_derivatives_shape_functions() const {
+        return grad_shape_fun_;
+    }
+
+    // give status of the removal
+    bool is_removed() const {
+        return removed_;
     }
 
     // compute local coordinates
@@ -226,24 +376,51 @@ private:
     // change the sign of value
     void sign(double& variable, double value);
 
+    // give the origin of the stored coordinates: the centre of the element
+    // in a mixed precision build (once the particle is located), else zero
+    VectorDDIM coordinate_origin() const {
+        VectorDDIM origin = VectorDDIM::Zero();
+        if (mpm::constants::MIXED_PRECISION && nodeData_) {
+            for (unsigned i = 0; i < dim; i++)
+                origin(i) = nodeData_->layout->elementCentre[i][element_];
+        }
+        return origin;
+    }
+
+    // give the value of a nodal vector field at a node
+    VectorDDIM give_nodal_vector(const NodalVectorField& field, const unsigned& node) const {
+        VectorDDIM value;
+        for (unsigned i = 0; i < dim; i++)
+            value(i) = field[i][node];
+        return value;
+    }
+
+    // add to a nodal vector field of a grid at a node
+    void add_to_nodal_vector(const mpm::NodeData& grid, NodalVectorField& field, const unsigned& node, const VectorDDIM& value) {
+        for (unsigned i = 0; i < dim; i++)
+            grid.add(field[i][node], value(i));
+    }
+
 
 protected:
 
     unsigned id_;
-    VectorDDIM coord_;
+    // coordinates relative to coordinate_origin()
+    StoredVectorDDIM coord_;
     VectorDDIM spacing_;
 
     unsigned mat_id_;
     MaterialBasePtr material_;
+    bool removed_;
     VectorDDIM gravity_;
 
     double mass_;
     double volume_;
-    VectorDDIM velocity_;
+    StoredVectorDDIM velocity_;
     double pressure_;
     double density_;
 
-    VectorD1x6 stress_;
+    StoredVectorD1x6 stress_;
     VectorDDOF strain_;
 
     VectorDDOF strain_rate_;
@@ -255,8 +432,9 @@ protected:
     double centre_vol_strain_rate_p_;
     double centre_vol_strain_rate_n_;
 
-    VectorNPtrNN nodes_;
-    ElementPtr element_;
+    // index of the element (32 bit) and fields of the grid
+    unsigned element_;
+    mpm::NodeData* nodeData_;
 
     VectorDDIM xi_;
 
@@ -1,15 +1,15 @@
-mpm::Particle::Particle(const unsigned& id, const unsigned& matID, const VectorDDIM& spacing) {
+mpm::Particle::Particle(const unsigned& id, const unsigned& matID, const VectorDDIM& spacing, const VectorDDIM& gravity) {
     id_ = id;
     spacing_ = spacing;
     mat_id_ = matID;
-    gravity_ = VectorDDIM::Zero();
-    if (mpm::misc::gravity)
-        gravity_(dim -1) = -9.81;
+    removed_ = false;
+    gravity_ = gravity;
 
     mass_ = 0.;
-    velocity_ = VectorDDIM::Zero();
+    coord_ = StoredVectorDDIM::Zero();
+    velocity_ = StoredVectorDDIM::Zero();
     pressure_ = 0.;
-    stress_ = VectorD1x6::Zero();
+    stress_ = StoredVectorD1x6::Zero();
     strain_ = VectorDDOF::Zero();
     principle_strain_ = VectorDDIM::Zero();  
  
@@ -21,13 +21,12 @@ mpm::Particle::Particle(const unsigned& id, const unsigned& matID, const VectorD
     centre_vol_strain_rate_p_ = 0.;
     centre_vol_strain_rate_n_ = 0.;
 
-    nodes_   = VectorNPtrNN::Zero();
-    element_ = NULL;
+    element_ = 0;
+    nodeData_ = NULL;
 }
 
 
 void mpm::Particle::initialise_particle() {
-    nodes_ = VectorNPtrNN::Zero();
     strain_rate_ = VectorDDOF::Zero();
     BBar_strain_rate_ = VectorDDOF::Zero();
     centre_strain_rate_ = VectorDDOF::Zero();
@@ -36,7 +35,7 @@ void mpm::Particle::initialise_particle() {
 
 
 void mpm::Particle::set_initial_stress(const VectorD1x6& stress) {    
-    stress_ = stress;
+    stress_ = stress.cast<StoredReal>();
     pressure_ = -(stress(0) + stress(1) + stress(2)) / 3.;   
 }
 
@@ -49,10 +48,13 @@ void mpm::Particle::set_material(VecOfMaterialBasePtr materials) {
 
 
 void mpm::Particle::set_initial_velocity() {
+    VectorDDIM velocity = velocity_.cast<double>();
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
-        VectorDDIM nVelocity = nodes_(i)->give_node_velocity();
-        velocity_ += (shape_fun_(i) * nVelocity);
+        VectorDDIM nVelocity = this->give_nodal_vector(nodeData_->velocity, nodes[i]);
+        velocity += (shape_fun_(i) * nVelocity);
     }
+    velocity_ = velocity.cast<StoredReal>();
 }
 
 
@@ -66,72 +68,81 @@ void mpm::Particle::compute_mass() {
 
 
 void mpm::Particle::map_mass_to_nodes() {
+    this->map_mass_to_grid(*nodeData_, this->give_node_ids());
+}
+
+
+void mpm::Particle::map_mass_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
     double node_mass = 0.;
     for (unsigned i = 0; i < numNodes; i++) {
         node_mass = mass_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_mass(node_mass);
+        grid.add(grid.mass[nodes[i]], node_mass);
     }
 }
 
 
 void mpm::Particle::map_volume_to_nodes() {
-    double node_volume = 0.;
-    for (unsigned i = 0; i < numNodes; i++) {
-        node_volume = volume_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_volume(node_volume);
-    }
+    this->map_volume_to_grid(*nodeData_, this->give_node_ids());
 }
 
 
-void mpm::Particle::map_momentum_to_nodes() {
-    VectorDDIM node_momentum = VectorDDIM::Zero();
+void mpm::Particle::map_volume_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
+    double node_volume = 0.;
     for (unsigned i = 0; i < numNodes; i++) {
-        node_momentum = mass_ * velocity_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_momentum(node_momentum);
+        node_volume = volume_ * shape_fun_(i);
+        grid.add(grid.volume[nodes[i]], node_volume);
     }
 }
 
 
-void mpm::Particle::map_momentum_to_nodes_at_begin() {
-    VectorDDIM node_momentum = VectorDDIM::Zero();
-    for (unsigned i = 0; i < numNodes; i++) {
-        node_momentum = mass_ * velocity_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_momentum_at_begin(node_momentum);
-    }
+void mpm::Particle::map_momentum_to_nodes() {
+    this->map_momentum_to_grid(*nodeData_, this->give_node_ids());
 }
 
 
-void mpm::Particle::map_momentum_to_nodes_at_end() {
+void mpm::Particle::map_momentum_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
     VectorDDIM node_momentum = VectorDDIM::Zero();
+    const VectorDDIM velocity = velocity_.cast<double>();
     for (unsigned i = 0; i < numNodes; i++) {
-        node_momentum = mass_ * velocity_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_momentum_at_end(node_momentum);
+        node_momentum = mass_ * velocity * shape_fun_(i);
+        this->add_to_nodal_vector(grid, grid.momentum, nodes[i], node_momentum);
     }
 }
 
 
 void mpm::Particle::map_pressure_to_nodes() {
     double node_pressure = 0.;
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
         node_pressure = mass_ * pressure_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_pressure(node_pressure);
+        nodeData_->add(nodeData_->pressure[nodes[i]], node_pressure);
     }
 }
 
 
 void mpm::Particle::map_volumetric_strain_rate_to_nodes() {
+    this->map_volumetric_strain_rate_to_grid(*nodeData_, this->give_node_ids());
+}
+
+
+void mpm::Particle::map_volumetric_strain_rate_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
     double node_vol_strain_rate = 0.;
     for (unsigned i = 0; i < numNodes; i++) {
         node_vol_strain_rate = volume_ * vol_strain_rate_ * shape_fun_(i);
-        nodes_(i)->assign_nodal_vol_strain_rate(node_vol_strain_rate);
+        grid.add(grid.volStrainRate[nodes[i]], node_vol_strain_rate);
     }
 }
 
 
 void mpm::Particle::assign_body_force_to_nodes() {
+    this->assign_body_force_to_grid(*nodeData_, this->give_node_ids());
+}
+
+
+void mpm::Particle::assign_body_force_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
     for (unsigned i = 0; i < numNodes; i++) {
         VectorDDIM node_body_force = shape_fun_(i) * mass_ * gravity_;
-        nodes_(i)->assign_external_force(node_body_force);
+        this->add_to_nodal_vector(grid, grid.extForce, nodes[i], node_body_force);
     }
 }
 
@@ -143,6 +154,11 @@ void mpm::Particle::assign_traction_force_to_nodes() {
 
 
 void mpm::Particle::assign_internal_force_to_nodes() {
+    this->assign_internal_force_to_grid(*nodeData_, this->give_node_ids());
+}
+
+
+void mpm::Particle::assign_internal_force_to_grid(mpm::NodeData& grid, const NodeIds& nodes) {
     VectorDDIM node_int_force;
     VectorDDOF temp_stress;
     if (dim == 2) {
@@ -164,7 +180,7 @@ void mpm::Particle::assign_internal_force_to_nodes() {
         MatrixDDOFDIM Bi = B_.at(i);
         int_force = (mass_/density_)*(Bi.transpose() * temp_stress.transpose());
         node_int_force = int_force.transpose();
-        nodes_(i)->assign_internal_force(node_int_force);
+        this->add_to_nodal_vector(grid, grid.intForce, nodes[i], -node_int_force);
     }
 }
 
@@ -174,9 +190,10 @@ void mpm::Particle::assign_internal_force_to_nodes() {
 void mpm::Particle::compute_strain_rate() {
     Eigen::Matrix<double, dim, 1> node_velocity;
     strain_rate_ = VectorDDOF::Zero();
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
         MatrixDDOFDIM Bi = B_.at(i);
-        VectorDDIM velocity = nodes_(i)->give_node_velocity();
+        VectorDDIM velocity = this->give_nodal_vector(nodeData_->velocity, nodes[i]);
         node_velocity = velocity.transpose();
         strain_rate_ += (Bi * node_velocity);
     }
@@ -189,9 +206,10 @@ void mpm::Particle::compute_strain_rate() {
 void mpm::Particle::compute_centre_strain_rate() {
     Eigen::Matrix<double, dim, 1> node_Velocity;
     centre_strain_rate_ = VectorDDOF::Zero();
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
         MatrixDDOFDIM Bi_centre = BCentre_.at(i);
-        VectorDDIM velocity = nodes_(i)->give_node_velocity();
+        VectorDDIM velocity = this->give_nodal_vector(nodeData_->velocity, nodes[i]);
         node_Velocity = velocity.transpose();
         centre_strain_rate_ += (Bi_centre * node_Velocity);
     }
@@ -204,9 +222,10 @@ void mpm::Particle::compute_centre_strain_rate() {
 void mpm::Particle::compute_BBar_strain_rate() {
     Eigen::Matrix<double, dim, 1> node_Velocity;
     BBar_strain_rate_ = VectorDDOF::Zero();
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
         MatrixDDOFDIM BBari = BBar_.at(i);
-        VectorDDIM velocity = nodes_(i)->give_node_velocity();
+        VectorDDIM velocity = this->give_nodal_vector(nodeData_->velocity, nodes[i]);
         node_Velocity = velocity.transpose();
         BBar_strain_rate_ += (BBari * node_Velocity);
     }
@@ -215,8 +234,9 @@ void mpm::Particle::compute_BBar_strain_rate() {
 void mpm::Particle::compute_centre_vol_strain_rate_from_nodes() {
     double node_centre_vstrainrate = 0.;
     centre_vol_strain_rate_n_ = 0.;
+    const NodeIds nodes = this->give_node_ids();
     for (unsigned i = 0; i < numNodes; i++) {
-        node_centre_vstrainrate = nodes_(i)->give_node_vol_strain_rate();
+        node_centre_vstrainrate = nodeData_->volStrainRate[nodes[i]];
         centre_vol_strain_rate_n_ += (shape_fun_centre_(i) * node_centre_vstrainrate);
     }
 }
@@ -242,24 +262,89 @@ void mpm::Particle::compute_principle_strain(const VectorDDOF& strain) {
 }
 */
 
-void mpm::Particle::compute_strain() {
-    double dt = mpm::misc::dt;
+void mpm::Particle::compute_strain(const double& dt) {
     strain_ += (BBar_strain_rate_ * dt);
 }
 
 
-void mpm::Particle::compute_stress() {
-    double dt = mpm::misc::dt;
+void mpm::Particle::compute_stress(const double& dt) {
     double dvolume_strain = dt * centre_vol_strain_rate_n_;
     VectorDDOF dstrain = (dt * BBar_strain_rate_);
-    material_->computeStress(dstrain, stress_, pressure_, dvolume_strain);
+    VectorD1x6 stress = stress_.cast<double>();
+    material_->computeStress(dstrain, stress, pressure_, dvolume_strain, dt);
+    stress_ = stress.cast<StoredReal>();
+}
+
+
+double mpm::Particle::give_strain_energy() const {
+    // the strain has engineering shear components
+    double energy = 0.;
+    if (dim == 2)
+        energy = stress_(0) * strain_(0) + stress_(1) * strain_(1) + stress_(3) * strain_(2);
+    if (dim == 3) {
+        for (unsigned i = 0; i < 6; i++)
+            energy += stress_(i) * strain_(i);
+    }
+    return 0.5 * volume_ * energy;
+}
+
+
+//! FUNCTION: GATHER STRESS STATE
+//!           The strain and volumetric strain increments of
+//!           compute_stress, with the current stress and pressure, are
+//!           written to entry i of a material batch.
+//!
+void mpm::Particle::gather_shape_state(mpm::ShapeBatch& batch, const unsigned& i) const {
+    const VectorDDIM coordinates = this->give_coordinates();
+    for (unsigned k = 0; k < dim; k++) {
+        batch.coord[k * batch.width + i] = coordinates(k);
+        batch.centre[k * batch.width + i] = nodeData_->layout->elementCentre[k][element_];
+        batch.length[k * batch.width + i] = nodeData_->layout->elementLength[k][element_];
+    }
+}
+
+
+void mpm::Particle::scatter_shape_state(const mpm::ShapeBatch& batch, const unsigned& i) {
+    for (unsigned k = 0; k < dim; k++)
+        xi_(k) = batch.xi[k * batch.width + i];
+    for (unsigned n = 0; n < numNodes; n++) {
+        shape_fun_(n) = batch.shapeFun[n * batch.width + i];
+        shape_fun_centre_(n) = 1. / numNodes;
+        for (unsigned k = 0; k < dim; k++)
+            grad_shape_fun_(k, n) = batch.gradShapeFun[(k * numNodes + n) * batch.width + i];
+    }
+}
+
+
+void mpm::Particle::gather_stress_state(const mpm::material::StressBatch& batch, const unsigned& i, const double& dt) const {
+    const double* strainRate = BBar_strain_rate_.data();
+    for (unsigned k = 0; k < dof; k++)
+        batch.dStrain[k * batch.stride + i] = dt * strainRate[k];
+    batch.dVolStrain[i] = dt * centre_vol_strain_rate_n_;
+    for (unsigned k = 0; k < 6; k++)
+        batch.stress[k * batch.stride + i] = stress_(k);
+    batch.pressure[i] = pressure_;
+}
+
+
+void mpm::Particle::scatter_stress_state(const mpm::material::StressBatch& batch, const unsigned& i) {
+    for (unsigned k = 0; k < 6; k++)
+        stress_(k) = batch.stress[k * batch.stride + i];
+    pressure_ = batch.pressure[i];
 }
 
 
 void mpm::Particle::update_velocity(const double& dt) {
+    this->update_velocity_from_grid(*nodeData_, this->give_node_ids(), dt);
+}
+
+
+void mpm::Particle::update_velocity_from_grid(const mpm::NodeData& grid, const NodeIds& nodes, const double& dt) {
+    if (removed_)
+        return;
     VectorDDIM temp_acceleration = VectorDDIM::Zero();
     for (unsigned i = 0; i < numNodes; i++) {
-        VectorDDIM node_acceleration = nodes_(i)->give_node_acceleration();
+        VectorDDIM node_acceleration = this->give_nodal_vector(grid.acceleration, nodes[i]);
         temp_acceleration += (shape_fun_(i) * node_acceleration);
     }
 
@@ -267,28 +352,39 @@ void mpm::Particle::update_velocity(const double& dt) {
         if (std::fabs(temp_acceleration(i)) < 1.0E-16)
             temp_acceleration(i) = 0.;
     }
-    velocity_ += (dt * temp_acceleration);
+    velocity_ = (velocity_.cast<double>() + dt * temp_acceleration).cast<StoredReal>();
 }
 
 
 
 void mpm::Particle::update_position(const double& dt) {
+    this->update_position_from_grid(*nodeData_, this->give_node_ids(), dt);
+}
+
+
+void mpm::Particle::update_position_from_grid(const mpm::NodeData& grid, const NodeIds& nodes, const double& dt) {
+    if (removed_)
+        return;
     VectorDDIM temp_velocity = VectorDDIM::Zero();
     for (unsigned i = 0; i < numNodes; i++) {
-         VectorDDIM node_velocity = nodes_(i)->give_node_velocity();
+         VectorDDIM node_velocity = this->give_nodal_vector(grid.velocity, nodes[i]);
         temp_velocity += (shape_fun_(i) * node_velocity);
     }
     for (unsigned i = 0; i < dim; i++) {
         if (std::fabs(temp_velocity(i)) < 1.0E-16)
             temp_velocity(i) = 0.;
     }
-    coord_ += (dt * temp_velocity);
+    // the new position is computed in double (also in a mixed precision
+    // build) and only then stored
+    this->set_coordinates(this->give_coordinates() + dt * temp_velocity);
 }
 
 
 
-void mpm::Particle::update_density() {
-    density_ = density_ / (1 + (mpm::misc::dt * centre_vol_strain_rate_n_));
+void mpm::Particle::update_density(const double& dt) {
+    if (removed_)
+        return;
+    density_ = density_ / (1 + (dt * centre_vol_strain_rate_n_));
     volume_ = mass_ / density_;
 }
 
@@ -343,11 +439,11 @@ void mpm::Particle::write_strain(std::ostream& oFile) {
 
 
 void mpm::Particle::compute_local_coordinates() {
-    VectorDDIM elem_centre__coord = element_ -> give_element_centre_coord();
-    VectorDDIM elem_length        = element_ -> give_element_length();
-
+    const VectorDDIM coordinates = this->give_coordinates();
     for (unsigned i = 0; i < dim; i++) {
-        xi_(i) = 2. * (coord_(i) - elem_centre__coord(i)) / elem_length(i);
+        const double elem_centre_coord = nodeData_->layout->elementCentre[i][element_];
+        const double elem_length = nodeData_->layout->elementLength[i][element_];
+        xi_(i) = 2. * (coordinates(i) - elem_centre_coord) / elem_length;
         if (((std::fabs(xi_(i)) > 0.999999) && (std::fabs(xi_(i)) < 1.)) || (std::fabs(xi_(i)) > 1.))
             sign(xi_(i), 1.);
         else if ((std::fabs(xi_(i)) > 0.) && (std::fabs(xi_(i)) < 0.000001))
@@ -381,7 +477,9 @@ void mpm::Particle::compute_shape_functions() {
 
 
 void mpm::Particle::compute_global_derivatives_shape_functions() {
-    VectorDDIM L = element_ -> give_element_length();
+    VectorDDIM L;
+    for (unsigned i = 0; i < dim; i++)
+        L(i) = nodeData_->layout->elementLength[i][element_];
     if (dim == 2) {
         grad_shape_fun_(0, 0) = -0.5 * (1 - xi_(1)) / L(0);
         grad_shape_fun_(0, 1) =  0.5 * (1 - xi_(1)) / L(0);
@@ -398,7 +496,9 @@ void mpm::Particle::compute_global_derivatives_shape_functions() {
 
 
 void mpm::Particle::compute_global_derivatives_shape_functions_at_centre() {
-    VectorDDIM L = element_ -> give_element_length();
+    VectorDDIM L;
+    for (unsigned i = 0; i < dim; i++)
+        L(i) = nodeData_->layout->elementLength[i][element_];
     if (dim == 2) {
         grad_shape_fun_centre_(0, 0) = -0.5 / L(0);
         grad_shape_fun_centre_(0, 1) =  0.5 / L(0);
@@ -469,7 +569,8 @@ void mpm::Particle::compute_B_matrix_at_centre() {
 
 
 void mpm::Particle::compute_BBar_matrix() {
-    MatrixDDOFDIM BBari_;
+    // entry (1,0) is not set in 2D
+    MatrixDDOFDIM BBari_ = MatrixDDOFDIM::Zero();
     for (unsigned i = 0; i < numNodes; i++) {
         if (dim == 2) {
             BBari_(0,0) = (1/3.0)*(grad_shape_fun_centre_(0,i) + (2*grad_shape_fun_(0,i)));
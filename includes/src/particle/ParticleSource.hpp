@@ -0,0 +1,102 @@
+/*****************************************************************************
+                        Material Point Method
+                         Shyamini Kularathna
+                       University of Cambridge
+
+NOTE: Sources and sinks of particles for inflow/outflow runs, read from
+      feedParticle.dat. A source is a box which is filled with particles
+      of a material and velocity each time the previous layer has moved
+      out of it. A sink is a box whose particles are removed. Particles
+      which leave the mesh are removed by the mesh.
+
+FILE: ParticleSource.hpp
+*****************************************************************************/
+#ifndef MPM_PARTICLESOURCE_H
+#define MPM_PARTICLESOURCE_H
+
+// c++ header files
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+
+// eigen header files
+#include <Eigen/Dense>
+
+// mpm header files
+#include "Constants.hpp"
+#include "MpmParticle.hpp"
+
+namespace mpm {
+    class ParticleSource;
+}
+
+class mpm::ParticleSource {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+
+    typedef Eigen::Matrix<double, 1, dim> VectorDDIM;
+
+public:
+    // constructor
+    ParticleSource();
+
+    // read sources and sinks
+    void read_sources_and_sinks(std::istream& feedFile);
+
+    // add a source box of a material, filled with particles of "velocity"
+    void add_source(const VectorDDIM& lower, const VectorDDIM& upper, const unsigned& matId, const VectorDDIM& velocity);
+
+    // add a sink box
+    void add_sink(const VectorDDIM& lower, const VectorDDIM& upper);
+
+    // insert and remove the particles of one time step
+    void apply(mpm::MpmParticle* particles, const double& dt);
+
+    // give status of sources and sinks
+    bool empty() const {
+        return sources_.empty() && sinks_.empty();
+    }
+
+    // give total number of inserted particles
+    unsigned long number_of_inserted_particles() const {
+        return numInserted_;
+    }
+
+    // give total number of removed particles
+    unsigned long number_of_removed_particles() const {
+        return numRemoved_;
+    }
+
+private:
+    struct Source {
+        VectorDDIM lower;
+        VectorDDIM upper;
+        VectorDDIM velocity;
+        unsigned matId;
+        // length of the box along the velocity and the distance the last
+        // layer has moved
+        double length;
+        double travelled;
+    };
+
+    struct Sink {
+        VectorDDIM lower;
+        VectorDDIM upper;
+    };
+
+    // fill a source box with particles, shifted by "shift" along the flow
+    void fill_source(const Source& source, const double& shift, mpm::MpmParticle* particles);
+
+protected:
+    std::vector<Source> sources_;
+    std::vector<Sink> sinks_;
+    unsigned long numInserted_;
+    unsigned long numRemoved_;
+};
+
+#include "ParticleSource.ipp"
+
+#endif
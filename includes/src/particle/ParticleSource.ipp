@@ -0,0 +1,137 @@
+
+mpm::ParticleSource::ParticleSource() {
+    numInserted_ = 0;
+    numRemoved_ = 0;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: READ_SOURCES_AND_SINKS
+          feedParticle.dat:
+            numOfSources   numOfSinks
+            lower-x  lower-y  upper-x  upper-y  materialID  velocity-x  velocity-y
+            ...      (one line per source)
+            lower-x  lower-y  upper-x  upper-y
+            ...      (one line per sink)
+          An empty file (or a 0) means no sources and no sinks.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::ParticleSource::read_sources_and_sinks(std::istream& feedFile) {
+    std::string line;
+    unsigned numOfSources = 0, numOfSinks = 0;
+    if (!std::getline(feedFile, line))
+        return;
+    std::istringstream in(line);
+    in >> numOfSources >> numOfSinks;
+
+    VectorDDIM lower, upper, velocity;
+    unsigned matId;
+    for (unsigned i = 0; i < numOfSources + numOfSinks; i++) {
+        if (!std::getline(feedFile, line)) {
+            std::cerr << "ERROR: in reading feedParticle.dat" << "\n";
+            abort();
+        }
+        std::istringstream box(line);
+        for (unsigned j = 0; j < dim; j++)
+            box >> lower(j);
+        for (unsigned j = 0; j < dim; j++)
+            box >> upper(j);
+        if (i < numOfSources) {
+            box >> matId;
+            for (unsigned j = 0; j < dim; j++)
+                box >> velocity(j);
+            this->add_source(lower, upper, matId, velocity);
+        }
+        else
+            this->add_sink(lower, upper);
+    }
+}
+
+
+void mpm::ParticleSource::add_source(const VectorDDIM& lower, const VectorDDIM& upper, const unsigned& matId, const VectorDDIM& velocity) {
+    Source source;
+    source.lower = lower;
+    source.upper = upper;
+    source.velocity = velocity;
+    source.matId = matId;
+    // extent of the box along the direction of the flow
+    double speed = velocity.norm();
+    source.length = 0.;
+    if (speed > 0.)
+        source.length = (upper - lower).cwiseAbs().dot(velocity.cwiseAbs()) / speed;
+    // the box is filled in the first step
+    source.travelled = source.length;
+    sources_.push_back(source);
+}
+
+
+void mpm::ParticleSource::add_sink(const VectorDDIM& lower, const VectorDDIM& upper) {
+    Sink sink;
+    sink.lower = lower;
+    sink.upper = upper;
+    sinks_.push_back(sink);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: APPLY
+          A source is filled again once its last layer has moved the
+          length of the box; the new layer is shifted by the distance
+          moved beyond that, so the spacing of the particles stays even.
+          A source without velocity is filled only once. Particles inside
+          a sink are marked for removal, and the particle container is
+          compacted once for all changes of the step if it is due (new
+          particles are always sorted in at once).
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::ParticleSource::apply(mpm::MpmParticle* particles, const double& dt) {
+    for (auto& source : sources_) {
+        if (source.travelled >= source.length) {
+            source.travelled -= source.length;
+            this->fill_source(source, source.travelled, particles);
+            if (source.length <= 0.)
+                source.travelled = -1.;
+        }
+        if (source.length > 0.)
+            source.travelled += source.velocity.norm() * dt;
+    }
+
+    if (!sinks_.empty()) {
+        for (unsigned i = 0; i < particles->number_of_particles(); i++) {
+            if (particles->pointer_to_particle(i)->is_removed())
+                continue;
+            VectorDDIM coord = particles->pointer_to_particle(i)->give_coordinates();
+            for (const auto& sink : sinks_) {
+                if ((coord.array() >= sink.lower.array()).all() && (coord.array() <= sink.upper.array()).all()) {
+                    particles->remove_particle(i);
+                    numRemoved_++;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (particles->compaction_due())
+        particles->compact();
+}
+
+
+void mpm::ParticleSource::fill_source(const Source& source, const double& shift, mpm::MpmParticle* particles) {
+    VectorDDIM spacing = particles->give_spacing();
+    VectorDDIM offset = VectorDDIM::Zero();
+    double speed = source.velocity.norm();
+    if (speed > 0.)
+        offset = source.velocity * (shift / speed);
+
+    Eigen::Matrix<unsigned, 1, dim> num;
+    for (unsigned j = 0; j < dim; j++)
+        num(j) = std::round((source.upper(j) - source.lower(j)) / spacing(j));
+
+    VectorDDIM coord;
+    for (unsigned iy = 0; iy < num(1); iy++) {
+        for (unsigned ix = 0; ix < num(0); ix++) {
+            coord(0) = source.lower(0) + (ix + 0.5) * spacing(0) + offset(0);
+            coord(1) = source.lower(1) + (iy + 0.5) * spacing(1) + offset(1);
+            particles->insert_particle(coord, source.matId, source.velocity);
+            numInserted_++;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+                        Material Point Method
+                         Shyamini Kularathna
+                       University of Cambridge
+
+NOTE: Local coordinates, shape functions and their global derivatives of
+      a batch of particles, computed in one vectorized pass. The inputs
+      (particle coordinates, centre and length of the element) are
+      gathered from the particles and the results scattered back, as for
+      the StressBatch of the materials. Component k of particle i is
+      stored at [k * width + i].
+
+FILE: ShapeBatch.hpp
+*****************************************************************************/
+#ifndef MPM_SHAPEBATCH_H
+#define MPM_SHAPEBATCH_H
+
+// c++ header files
+#include <cmath>
+
+// mpm header files
+#include "Constants.hpp"
+
+namespace mpm {
+    struct ShapeBatch;
+}
+
+struct mpm::ShapeBatch {
+
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+    // particles of a batch (one or two SIMD registers of doubles)
+    static const unsigned width = 8;
+
+    // compute xi, N and dN/dx of the first "size" particles
+    void compute();
+
+    unsigned size;
+    // input: coordinates of the particles, centre and length of their
+    // elements (dim components)
+    alignas(64) double coord[dim * width];
+    alignas(64) double centre[dim * width];
+    alignas(64) double length[dim * width];
+    // output: local coordinates (dim components), shape functions
+    // (numNodes components) and derivatives (component d * numNodes + n
+    // is dN_n / dx_d)
+    alignas(64) double xi[dim * width];
+    alignas(64) double shapeFun[numNodes * width];
+    alignas(64) double gradShapeFun[dim * numNodes * width];
+};
+
+#include "ShapeBatch.ipp"
+
+#endif
@@ -0,0 +1,113 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Non-interactive builder of the shipped test configurations
+      (dam break, lid driven cavity and standing wave) at an arbitrary
+      resolution. The mesh, particles, constraints, initial stress and
+      materials are created in memory, without input files. The settings
+      of the scene (dt, gravity) are set as if they were read from
+      input.dat.
+
+FILE: SceneBuilder.hpp
+**************************************************************************/
+#ifndef MPM_SCENE_SCENEBUILDER_H
+#define MPM_SCENE_SCENEBUILDER_H
+
+// c++ header files
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+// eigen header files
+#include <Eigen/Dense>
+
+// mpm header files
+#include "Constants.hpp"
+#include "PropertyParse.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "ReadMaterial.hpp"
+
+namespace mpm {
+    namespace scene {
+        struct Scene;
+        class SceneBuilder;
+    }
+}
+
+
+//! A built configuration. It owns the mesh, particles and materials.
+struct mpm::scene::Scene {
+    std::string name;
+    mpm::Mesh* mesh;
+    mpm::MpmParticle* particles;
+    std::vector<mpm::material::MaterialBase*> materials;
+    mpm::misc::Settings settings;
+
+    Scene() : mesh(NULL), particles(NULL) { }
+
+    ~Scene() {
+        delete mesh;
+        delete particles;
+        for (auto material : materials)
+            delete material;
+    }
+};
+
+
+class mpm::scene::SceneBuilder {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+
+    typedef Eigen::Matrix<double, 1, dim>   VectorDDIM;
+    typedef Eigen::Matrix<unsigned, 1, dim> VectorUDIM;
+    typedef Eigen::Matrix<double, 1, 6>     VectorD1x6;
+
+public:
+    // constructor
+    //! param[in] resolution number of elements along the x direction
+    //! param[in] ppc number of particles per element (a square number)
+    SceneBuilder(const unsigned& resolution, const unsigned& ppc);
+
+    // build the scene of a given name: "damBreak", "lidDrivenCavity"
+    // or "standingWave"
+    mpm::scene::Scene* build(const std::string& name);
+
+    // water column of half the tank width collapsing in a square tank
+    mpm::scene::Scene* dam_break();
+
+    // square cavity full of fluid driven by a lid moving at 1 m/s
+    mpm::scene::Scene* lid_driven_cavity();
+
+    // sloshing of a cosine free surface in a 3 x 2 tank
+    mpm::scene::Scene* standing_wave();
+
+private:
+    // create the mesh of a box with "resolution" elements along x
+    mpm::Mesh* box_mesh(const double& width, const double& height);
+
+    // fix the normal velocity on the walls of the box (as mesh_generator)
+    void set_tank_constraints(mpm::Mesh* mesh);
+
+    // fill the particles below the free surface "height(x)"
+    void fill_particles(mpm::scene::Scene* scene, const double& width, const double& depth, std::function<double(double)> height, const bool& hydrostatic);
+
+    // create the Newtonian fluid and the stable time step of the scene
+    void set_fluid(mpm::scene::Scene* scene, const double& density, const double& viscosity, const double& bulkModulus);
+
+protected:
+    unsigned resolution_;
+    unsigned ppcDir_;
+    // fraction of the stable time step used
+    double courant_;
+};
+
+#include "SceneBuilder.ipp"
+
+#endif
@@ -0,0 +1,176 @@
+
+mpm::scene::SceneBuilder::SceneBuilder(const unsigned& resolution, const unsigned& ppc) {
+    resolution_ = resolution;
+    ppcDir_ = std::round(std::sqrt(double(ppc)));
+    if (!resolution_ || ppcDir_ * ppcDir_ != ppc) {
+        std::cerr << "ERROR: scene needs a resolution > 0 and a square number of particles per cell" << "\n";
+        abort();
+    }
+    courant_ = 0.2;
+}
+
+
+typedef mpm::scene::Scene* ScenePtr;
+ScenePtr mpm::scene::SceneBuilder::build(const std::string& name) {
+    if (name == "damBreak")
+        return this->dam_break();
+    else if (name == "lidDrivenCavity")
+        return this->lid_driven_cavity();
+    else if (name == "standingWave")
+        return this->standing_wave();
+    std::cerr << "ERROR: no scene named " << name << "\n";
+    abort();
+}
+
+
+ScenePtr mpm::scene::SceneBuilder::dam_break() {
+    ScenePtr scene = new mpm::scene::Scene();
+    scene->name = "damBreak";
+    scene->settings.gravity = 1;
+    scene->settings.freeSurface = 0;
+
+    scene->mesh = this->box_mesh(1.0, 1.0);
+    this->set_tank_constraints(scene->mesh);
+    this->set_fluid(scene, 1000., 0., 2.1E+6);
+    this->fill_particles(scene, 0.5, 0.5, [](double) { return 0.5; }, true);
+    return scene;
+}
+
+
+ScenePtr mpm::scene::SceneBuilder::lid_driven_cavity() {
+    ScenePtr scene = new mpm::scene::Scene();
+    scene->name = "lidDrivenCavity";
+    scene->settings.gravity = 0;
+    scene->settings.freeSurface = 0;
+
+    double width = 0.1;
+    scene->mesh = this->box_mesh(width, width);
+
+    // no slip on the walls, the lid moves at 1 m/s
+    mpm::Mesh* mesh = scene->mesh;
+    unsigned numNodesX = mesh->topology().numElements(0) + 1;
+    unsigned numNodesY = mesh->topology().numElements(1) + 1;
+    unsigned dirX = 0, dirY = 1;
+    double zero = 0., lid = 1.;
+    for (unsigned j = 0; j < numNodesY; j++) {
+        for (unsigned i = 0; i < numNodesX; i++) {
+            unsigned node = j * numNodesX + i;
+            bool wall = (i == 0 || i == numNodesX - 1 || j == 0);
+            if (wall) {
+                mesh->set_velocity_constraint(node, dirX, zero);
+                mesh->set_velocity_constraint(node, dirY, zero);
+            }
+            else if (j == numNodesY - 1) {
+                mesh->set_velocity_constraint(node, dirX, lid);
+                mesh->set_velocity_constraint(node, dirY, zero);
+            }
+        }
+    }
+
+    this->set_fluid(scene, 1000., 10., 2.0E+9);
+    this->fill_particles(scene, width, width, [width](double) { return width; }, false);
+    return scene;
+}
+
+
+ScenePtr mpm::scene::SceneBuilder::standing_wave() {
+    ScenePtr scene = new mpm::scene::Scene();
+    scene->name = "standingWave";
+    scene->settings.gravity = 1;
+    scene->settings.freeSurface = 0;
+
+    double width = 3.0, depth = 1.0, amplitude = 0.1;
+    double pi = std::acos(-1.);
+    scene->mesh = this->box_mesh(width, 2.0);
+    this->set_tank_constraints(scene->mesh);
+    this->set_fluid(scene, 1000., 0., 2.2E+6);
+    this->fill_particles(scene, width, depth, [=](double x) { return (depth - amplitude) + amplitude * std::cos(pi * x / width); }, true);
+    return scene;
+}
+
+
+typedef mpm::Mesh* MeshPtr;
+MeshPtr mpm::scene::SceneBuilder::box_mesh(const double& width, const double& height) {
+    double h = width / resolution_;
+    VectorDDIM spacing = VectorDDIM::Constant(h);
+    VectorUDIM numElements;
+    numElements << resolution_, std::max(1., std::round(height / h));
+    MeshPtr mesh = new mpm::Mesh(spacing, numElements, VectorDDIM::Zero());
+    return mesh;
+}
+
+
+//! FUNCTION: SET TANK CONSTRAINTS
+//!           Normal velocity is zero on all four walls and both velocity
+//!           components are zero at the corners, as in mesh_generator.
+//!
+void mpm::scene::SceneBuilder::set_tank_constraints(MeshPtr mesh) {
+    unsigned numNodesX = mesh->topology().numElements(0) + 1;
+    unsigned numNodesY = mesh->topology().numElements(1) + 1;
+    unsigned dirX = 0, dirY = 1;
+    double zero = 0.;
+    for (unsigned j = 0; j < numNodesY; j++) {
+        for (unsigned i = 0; i < numNodesX; i++) {
+            unsigned node = j * numNodesX + i;
+            if (i == 0 || i == numNodesX - 1)
+                mesh->set_velocity_constraint(node, dirX, zero);
+            if (j == 0 || j == numNodesY - 1)
+                mesh->set_velocity_constraint(node, dirY, zero);
+        }
+    }
+}
+
+
+//! FUNCTION: FILL PARTICLES
+//!           Particles are placed at the centres of a regular sub-grid of
+//!           the elements, ppc per element, wherever the centre lies below
+//!           the free surface. With "hydrostatic" the initial stress is
+//!           -rho * g * (height(x) - y) in the three normal directions.
+//!
+void mpm::scene::SceneBuilder::fill_particles(ScenePtr scene, const double& width, const double& depth, std::function<double(double)> height, const bool& hydrostatic) {
+    double h = scene->mesh->topology().meshSpacing(0);
+    VectorDDIM spacing = VectorDDIM::Constant(h / ppcDir_);
+    double density = scene->materials.at(0)->giveDensity();
+
+    scene->particles = new mpm::MpmParticle(scene->settings.gravity);
+    unsigned numX = std::round(width / spacing(0));
+    unsigned numY = std::round(depth / spacing(1));
+    VectorDDIM coord;
+    VectorD1x6 stress = VectorD1x6::Zero();
+    for (unsigned j = 0; j < numY; j++) {
+        for (unsigned i = 0; i < numX; i++) {
+            coord(0) = (i + 0.5) * spacing(0);
+            coord(1) = (j + 0.5) * spacing(1);
+            double surface = height(coord(0));
+            if (coord(1) > surface)
+                continue;
+            mpm::Particle* particle = scene->particles->add_particle(coord, 0, spacing);
+            if (hydrostatic) {
+                stress(0) = stress(1) = stress(2) = -density * 9.81 * (surface - coord(1));
+                particle->set_initial_stress(stress);
+            }
+        }
+    }
+    scene->particles->assign_material_to_particles(scene->materials);
+}
+
+
+//! FUNCTION: SET FLUID
+//!           The time step is a fraction (courant_) of the smaller of the
+//!           acoustic limit s / sqrt(K / rho) and the viscous limit
+//!           rho * s^2 / (2 mu), where s is the particle spacing.
+//!
+void mpm::scene::SceneBuilder::set_fluid(ScenePtr scene, const double& density, const double& viscosity, const double& bulkModulus) {
+    double spacing = scene->mesh->topology().meshSpacing(0) / ppcDir_;
+    double dt = spacing / std::sqrt(bulkModulus / density);
+    if (viscosity > 0.)
+        dt = std::min(dt, density * spacing * spacing / (2. * viscosity));
+    scene->settings.dt = courant_ * dt;
+
+    // as if read from material.dat
+    mpm::misc::PropertyList properties;
+    properties["density"] = density;
+    properties["viscosity"] = viscosity;
+    properties["bulkModulus"] = bulkModulus;
+    scene->materials.push_back(mpm::material::Newtonian::create(properties));
+}
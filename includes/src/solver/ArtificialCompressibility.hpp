@@ -0,0 +1,136 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Artificial compressibility of the weakly compressible fluids
+      (Newtonian, ModifiedBingham) by a target Mach number. The bulk
+      modulus of such a fluid only has to make the speed of sound c
+      large against the flow speed U: the density varies by about
+      Ma^2 = (U / c)^2 (Bernoulli), while the time step falls with c.
+      With machNumber the bulk modulus of material.dat is replaced by
+      K = rho (U / machNumber)^2, and dt of input.dat by courantNumber
+      times the stable time step of all materials, the smaller of the
+      acoustic limit s / (c + U) and the viscous limit rho s^2 / (2 mu),
+      s the particle spacing (as SceneBuilder::set_fluid) and mu the
+      largest apparent viscosity of the material.
+      U is at first maxFlowSpeed, or without it the speed of a fall from
+      the top of the fluid, sqrt(2 g H), H the height of the fluid
+      particles. After each step U follows the peak speed of the
+      particles when it is higher, so K and dt change only when the flow
+      is faster than before; the pressure, updated by increments, does
+      not jump when K changes.
+      The density variation of the fluid particles, |rho / rho0 - 1|, is
+      followed to compare with the expected Ma^2.
+
+FILE: ArtificialCompressibility.hpp
+**************************************************************************/
+#ifndef MPM_ARTIFICIALCOMPRESSIBILITY_H
+#define MPM_ARTIFICIALCOMPRESSIBILITY_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// mpm miscellaneous header files
+#include "PropertyParse.hpp"
+
+// mpm main header files
+#include "MpmParticle.hpp"
+#include "Particle.hpp"
+#include "MaterialBase.hpp"
+
+namespace mpm {
+    class ArtificialCompressibility;
+}
+
+class mpm::ArtificialCompressibility {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+
+    typedef mpm::material::MaterialBase* MaterialBasePtr;
+    typedef std::vector<MaterialBasePtr> MaterialVector;
+
+public:
+    // constructor; without machNumber the mode is disabled
+    ArtificialCompressibility(const mpm::misc::Settings& settings);
+
+    // give status of the mode
+    bool enabled() const {
+        return enabled_;
+    }
+
+    // set the bulk modulus of the fluids for the estimated flow speed and
+    // give the time step
+    double initialise(mpm::MpmParticle* particles, const MaterialVector& materials);
+
+    // follow the peak speed and the density variation of the particles
+    // after a step and give the time step of the next one
+    double update(mpm::MpmParticle* particles, const MaterialVector& materials);
+
+    // give the flow speed U and the speed of sound c of the fluids
+    double flow_speed() const {
+        return flowSpeed_;
+    }
+    double sound_speed() const {
+        return soundSpeed_;
+    }
+
+    // give the time step
+    double dt() const {
+        return dt_;
+    }
+
+    // give the Mach number of the peak speed of the last step
+    double mach_number() const {
+        return (soundSpeed_ > 0.) ? peakSpeed_ / soundSpeed_ : 0.;
+    }
+
+    // give the largest density variation of a fluid particle in the last
+    // step and in the run, and the expected one, machNumber^2
+    double density_variation() const {
+        return densityVariation_;
+    }
+    double max_density_variation() const {
+        return maxDensityVariation_;
+    }
+    double expected_density_variation() const {
+        return machNumber_ * machNumber_;
+    }
+
+    // give number of times the bulk modulus was raised
+    unsigned number_of_changes() const {
+        return numChanges_;
+    }
+
+protected:
+    // set the bulk modulus of the fluids for the flow speed and compute
+    // the time step
+    void set_sound_speed(const MaterialVector& materials);
+
+protected:
+    bool enabled_;
+    double machNumber_;
+    double courantNumber_;
+    double gravity_;
+    // particle spacing
+    double spacing_;
+    // materials whose bulk modulus is set
+    std::vector<bool> fluid_;
+
+    double flowSpeed_;
+    double soundSpeed_;
+    double dt_;
+    double peakSpeed_;
+    double densityVariation_;
+    double maxDensityVariation_;
+    unsigned numChanges_;
+};
+
+#include "ArtificialCompressibility.ipp"
+
+#endif
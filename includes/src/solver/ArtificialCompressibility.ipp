@@ -0,0 +1,118 @@
+
+mpm::ArtificialCompressibility::ArtificialCompressibility(const mpm::misc::Settings& settings)
+    : enabled_(settings.machNumber > 0.), machNumber_(settings.machNumber), courantNumber_(settings.courantNumber),
+      gravity_(settings.gravity ? 9.81 : 0.), spacing_(0.), flowSpeed_(settings.maxFlowSpeed), soundSpeed_(0.),
+      dt_(settings.dt), peakSpeed_(0.), densityVariation_(0.), maxDensityVariation_(0.), numChanges_(0) {
+    if (!enabled_)
+        return;
+    if (settings.quasiStatic) {
+        std::cerr << "ERROR: machNumber is not used with quasiStaticFlag" << "\n";
+        abort();
+    }
+    if (courantNumber_ <= 0.) {
+        std::cerr << "ERROR: machNumber needs courantNumber > 0" << "\n";
+        abort();
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: INITIALISE
+          Without maxFlowSpeed the flow speed is that of a fall from the
+          top to the bottom of the fluid particles (with half a spacing
+          above and below them). A case without fluid, or without a
+          flow speed, stops the run.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+double mpm::ArtificialCompressibility::initialise(mpm::MpmParticle* particles, const MaterialVector& materials) {
+    const Eigen::Matrix<double, 1, dim> spacing = particles->give_spacing();
+    spacing_ = spacing.minCoeff();
+
+    // the fluids take the bulk modulus of the flow speed
+    fluid_.assign(materials.size(), false);
+    for (unsigned m = 0; m < materials.size(); m++)
+        fluid_[m] = materials[m]->isWeaklyCompressible();
+    if (std::find(fluid_.begin(), fluid_.end(), true) == fluid_.end()) {
+        std::cerr << "ERROR: machNumber needs a weakly compressible fluid (Newtonian or ModifiedBingham)" << "\n";
+        abort();
+    }
+
+    if (flowSpeed_ <= 0.) {
+        double bottom = HUGE_VAL;
+        double top = -HUGE_VAL;
+        const unsigned numParticles = particles->number_of_particles();
+        for (unsigned p = 0; p < numParticles; p++) {
+            const mpm::Particle* particle = particles->pointer_to_particle(p);
+            if (!fluid_[particle->give_mat_id()])
+                continue;
+            const double height = particle->give_coordinates()(dim - 1);
+            bottom = std::min(bottom, height);
+            top = std::max(top, height);
+        }
+        if (top >= bottom)
+            flowSpeed_ = std::sqrt(2. * gravity_ * (top - bottom + spacing(dim - 1)));
+    }
+    if (!(flowSpeed_ > 0.)) {
+        std::cerr << "ERROR: machNumber needs maxFlowSpeed (or gravityFlag and fluid particles)" << "\n";
+        abort();
+    }
+    this->set_sound_speed(materials);
+    return dt_;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: UPDATE
+          One pass over the particles gives the peak speed and the
+          largest density variation of a fluid particle; the density of
+          a particle starts at that of its material.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+double mpm::ArtificialCompressibility::update(mpm::MpmParticle* particles, const MaterialVector& materials) {
+    const int numParticles = particles->number_of_particles();
+    double peakSquared = 0.;
+    double variation = 0.;
+#pragma omp parallel for schedule(static) reduction(max : peakSquared, variation)
+    for (int p = 0; p < numParticles; p++) {
+        const mpm::Particle* particle = particles->pointer_to_particle(p);
+        peakSquared = std::max(peakSquared, particle->give_velocity().squaredNorm());
+        const unsigned matId = particle->give_mat_id();
+        if (fluid_[matId])
+            variation = std::max(variation, std::fabs(particle->give_density() / materials[matId]->giveDensity() - 1.));
+    }
+    peakSpeed_ = std::sqrt(peakSquared);
+    densityVariation_ = variation;
+    maxDensityVariation_ = std::max(maxDensityVariation_, variation);
+
+    if (!std::isfinite(peakSpeed_)) {
+        std::cerr << "ERROR: the speed of the particles is not finite" << "\n";
+        abort();
+    }
+    if (peakSpeed_ > flowSpeed_) {
+        flowSpeed_ = peakSpeed_;
+        this->set_sound_speed(materials);
+        numChanges_++;
+    }
+    return dt_;
+}
+
+
+//! FUNCTION: SET SOUND SPEED
+//!           K = rho c^2 for each fluid, with c = U / machNumber. The
+//!           other materials keep their wave speed and the time step is
+//!           the smallest over all materials.
+//!
+void mpm::ArtificialCompressibility::set_sound_speed(const MaterialVector& materials) {
+    soundSpeed_ = flowSpeed_ / machNumber_;
+    double dt = HUGE_VAL;
+    for (unsigned m = 0; m < materials.size(); m++) {
+        MaterialBasePtr material = materials[m];
+        const double density = material->giveDensity();
+        if (fluid_[m])
+            material->setBulkModulus(density * soundSpeed_ * soundSpeed_);
+        const double waveSpeed = std::sqrt(material->giveWaveModulus() / density);
+        dt = std::min(dt, spacing_ / (waveSpeed + flowSpeed_));
+        const double viscosity = material->giveMaxViscosity();
+        if (viscosity > 0.)
+            dt = std::min(dt, density * spacing_ * spacing_ / (2. * viscosity));
+    }
+    dt_ = courantNumber_ * dt;
+}
@@ -0,0 +1,115 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Transfer of the particle contributions to the nodes with sums in a
+      fixed order. The atomic adds of the parallel particle loops sum the
+      contributions at a node in the order the threads reach it, so the
+      results change in the last bits from run to run. Here particle p
+      writes its contribution to node k of its element to its own slot
+      4p + k of a buffer (in parallel, without atomics), and then each
+      node adds the slots of its particles in the order of the particle
+      index (in parallel over the nodes). The sums are the ones of a
+      sequential loop over the particles, for any number of threads.
+
+FILE: DeterministicTransfer.hpp
+**************************************************************************/
+#ifndef MPM_DETERMINISTICTRANSFER_H
+#define MPM_DETERMINISTICTRANSFER_H
+
+// c++ header files
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// mpm header files
+#include "Constants.hpp"
+#include "NodeData.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "Particle.hpp"
+
+namespace mpm {
+    class DeterministicTransfer;
+}
+
+class mpm::DeterministicTransfer {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+
+    typedef mpm::Particle::NodeIds NodeIds;
+    typedef mpm::NodeData::Field Field;
+
+public:
+    // constructor; the transfer is used when "enabled" is true
+    DeterministicTransfer(mpm::Mesh* mesh, const bool& enabled);
+
+    // give status of the deterministic transfer
+    bool enabled() const {
+        return enabled_;
+    }
+
+    // list the slots of the particles at each node (after the particles
+    // are located)
+    void build_node_slots(mpm::MpmParticle* particles);
+
+    // map mass, momentum, body force and internal force to the nodes
+    void map_particles_to_nodes(mpm::MpmParticle* particles);
+
+    // map volume and volumetric strain rate to the nodes
+    void map_volume_and_strain_rate_to_nodes(mpm::MpmParticle* particles);
+
+    // give number of nodes of the mesh
+    unsigned number_of_nodes() const {
+        return mesh_->node_data_.size();
+    }
+
+    // the two passes of map_particles_to_nodes over the particles
+    // [begin, end) and the nodes [begin, end)
+    void map_particles_to_slots(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end);
+    void add_slots_to_nodes(const unsigned& begin, const unsigned& end);
+
+    // the two passes of map_volume_and_strain_rate_to_nodes
+    void map_volume_and_strain_rate_to_slots(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end);
+    void add_volume_and_strain_rate_slots_to_nodes(const unsigned& begin, const unsigned& end);
+
+private:
+    // call function(begin, end) on a contiguous share of [0, size) for
+    // each thread; each index writes its own entries only
+    template<typename FP>
+    void iterate_over_ranges(const unsigned& size, FP function) const;
+
+    // give the slots of particle i
+    NodeIds particle_slots(const unsigned& i) const {
+        NodeIds slots;
+        for (unsigned k = 0; k < numNodes; k++)
+            slots[k] = numNodes * i + k;
+        return slots;
+    }
+
+    // give the sum of the slots of a node in the order of the particles
+    double sum_slots(const Field& field, const unsigned& node) const {
+        double sum = 0.;
+        for (unsigned s = slotOffsets_[node]; s < slotOffsets_[node + 1]; s++)
+            sum += field[nodeSlots_[s]];
+        return sum;
+    }
+
+protected:
+    mpm::Mesh* mesh_;
+    bool enabled_;
+    // slots of node n are nodeSlots_[slotOffsets_[n] .. slotOffsets_[n+1])
+    std::vector<unsigned> slotOffsets_;
+    std::vector<unsigned> nodeSlots_;
+    // contribution of each particle to each node of its element
+    mpm::NodeData slots_;
+};
+
+#include "DeterministicTransfer.ipp"
+
+#endif
@@ -0,0 +1,140 @@
+
+mpm::DeterministicTransfer::DeterministicTransfer(mpm::Mesh* mesh, const bool& enabled)
+    : mesh_(mesh), enabled_(enabled), slots_(false) { }
+
+
+template<typename FP>
+void mpm::DeterministicTransfer::iterate_over_ranges(const unsigned& size, FP function) const {
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1) {
+#pragma omp parallel
+    {
+      const unsigned numThreads = omp_get_num_threads();
+      const unsigned thread = omp_get_thread_num();
+      function((unsigned long)size * thread / numThreads, (unsigned long)size * (thread + 1) / numThreads);
+    }
+    return;
+  }
+#endif
+  function(0u, size);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: BUILD_NODE_SLOTS
+          Counting sort of the slots by node. The particles are visited in
+          the order of their index, so the slots of a node are sorted by
+          particle index.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::DeterministicTransfer::build_node_slots(mpm::MpmParticle* particles) {
+    const mpm::NodeData& meshData = mesh_->node_data_;
+    const unsigned numMeshNodes = meshData.size();
+    const unsigned numParticles = particles->number_of_particles();
+    std::vector<unsigned> nodeOfSlot(numNodes * numParticles);
+    slotOffsets_.assign(numMeshNodes + 1, 0);
+    for (unsigned i = 0; i < numParticles; i++) {
+        const unsigned first = meshData.first_node(particles->pointer_to_particle(i)->give_element());
+        for (unsigned k = 0; k < numNodes; k++) {
+            const unsigned node = first + meshData.layout->nodeOffsets[k];
+            nodeOfSlot[numNodes * i + k] = node;
+            slotOffsets_[node + 1]++;
+        }
+    }
+    for (unsigned n = 0; n < numMeshNodes; n++)
+        slotOffsets_[n + 1] += slotOffsets_[n];
+
+    nodeSlots_.resize(nodeOfSlot.size());
+    std::vector<unsigned> next(slotOffsets_.begin(), slotOffsets_.end() - 1);
+    for (unsigned s = 0; s < nodeOfSlot.size(); s++)
+        nodeSlots_[next[nodeOfSlot[s]]++] = s;
+
+    if (slots_.size() < nodeOfSlot.size())
+        slots_.resize(nodeOfSlot.size());
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: MAP_PARTICLES_TO_NODES
+          The slots of a particle are reset before its contributions are
+          added, so each slot holds exactly one contribution. The fields
+          of the mesh nodes are zero (initialise_mesh) and are set to the
+          sums of the slots.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::DeterministicTransfer::map_particles_to_nodes(mpm::MpmParticle* particles) {
+    this->iterate_over_ranges(particles->number_of_particles(), [&](const unsigned& begin, const unsigned& end) {
+        this->map_particles_to_slots(particles, begin, end);
+    });
+    this->iterate_over_ranges(this->number_of_nodes(), [&](const unsigned& begin, const unsigned& end) {
+        this->add_slots_to_nodes(begin, end);
+    });
+}
+
+
+void mpm::DeterministicTransfer::map_volume_and_strain_rate_to_nodes(mpm::MpmParticle* particles) {
+    this->iterate_over_ranges(particles->number_of_particles(), [&](const unsigned& begin, const unsigned& end) {
+        this->map_volume_and_strain_rate_to_slots(particles, begin, end);
+    });
+    this->iterate_over_ranges(this->number_of_nodes(), [&](const unsigned& begin, const unsigned& end) {
+        this->add_volume_and_strain_rate_slots_to_nodes(begin, end);
+    });
+}
+
+
+void mpm::DeterministicTransfer::map_particles_to_slots(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end) {
+    for (unsigned i = begin; i < end; i++) {
+        const NodeIds slots = this->particle_slots(i);
+        for (unsigned k = 0; k < numNodes; k++) {
+            slots_.mass[slots[k]] = 0.;
+            for (unsigned d = 0; d < dim; d++) {
+                slots_.momentum[d][slots[k]] = 0.;
+                slots_.extForce[d][slots[k]] = 0.;
+                slots_.intForce[d][slots[k]] = 0.;
+            }
+        }
+        mpm::Particle* particle = particles->pointer_to_particle(i);
+        particle->map_mass_to_grid(slots_, slots);
+        particle->map_momentum_to_grid(slots_, slots);
+        particle->assign_body_force_to_grid(slots_, slots);
+        particle->assign_internal_force_to_grid(slots_, slots);
+    }
+}
+
+
+void mpm::DeterministicTransfer::add_slots_to_nodes(const unsigned& begin, const unsigned& end) {
+    mpm::NodeData& meshData = mesh_->node_data_;
+    for (unsigned n = begin; n < end; n++) {
+        if (slotOffsets_[n] == slotOffsets_[n + 1])
+            continue;
+        meshData.mass[n] = this->sum_slots(slots_.mass, n);
+        for (unsigned d = 0; d < dim; d++) {
+            meshData.momentum[d][n] = this->sum_slots(slots_.momentum[d], n);
+            meshData.extForce[d][n] = this->sum_slots(slots_.extForce[d], n);
+            meshData.intForce[d][n] = this->sum_slots(slots_.intForce[d], n);
+        }
+    }
+}
+
+
+void mpm::DeterministicTransfer::map_volume_and_strain_rate_to_slots(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end) {
+    for (unsigned i = begin; i < end; i++) {
+        const NodeIds slots = this->particle_slots(i);
+        for (unsigned k = 0; k < numNodes; k++) {
+            slots_.volume[slots[k]] = 0.;
+            slots_.volStrainRate[slots[k]] = 0.;
+        }
+        mpm::Particle* particle = particles->pointer_to_particle(i);
+        particle->map_volume_to_grid(slots_, slots);
+        particle->map_volumetric_strain_rate_to_grid(slots_, slots);
+    }
+}
+
+
+void mpm::DeterministicTransfer::add_volume_and_strain_rate_slots_to_nodes(const unsigned& begin, const unsigned& end) {
+    mpm::NodeData& meshData = mesh_->node_data_;
+    for (unsigned n = begin; n < end; n++) {
+        if (slotOffsets_[n] == slotOffsets_[n + 1])
+            continue;
+        meshData.volume[n] = this->sum_slots(slots_.volume, n);
+        meshData.volStrainRate[n] = this->sum_slots(slots_.volStrainRate, n);
+    }
+}
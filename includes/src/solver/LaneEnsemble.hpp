@@ -0,0 +1,193 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Variants of a case (e.g. a sweep over the parameters of a
+      material) advanced in lockstep, up to "width" at a time. Every
+      field of the particles and of the nodes is stored in lanes: the
+      value of particle (or node) i in variant w is at [i * width + w]
+      of the array of the field. One pass over the particles or the
+      nodes advances all variants, and the loops over the lanes are
+      vectorized (the four lanes of doubles fill one AVX register). The
+      variants need the same particles, constraints and time step; they
+      differ in the parameters of the materials (and gravity).
+      The step is that of MpmSolver::solve_one_step (sequential, without
+      tiles) with the same arithmetic in each lane, so a variant gives
+      the same bits as its own Simulation. The nodes of the grid are a
+      NodeData whose "node" i * width + w is node i of variant w, so the
+      nodal solve runs over all lanes in one sweep. The materials give
+      the stress of a batch of lanes (vectorized in ILE and Newtonian);
+      the fields which the step does not read (centre strain rate, nodal
+      volume and pressure) are not computed.
+      Each variant keeps a Simulation, which builds its particles,
+      materials and constraints from the case input as usual. Its
+      particles are copied to the lanes at the start and copied back by
+      write_variants (e.g. for the output). With less than width
+      variants the last one fills the remaining lanes.
+      Not supported (the variants would need different particles or
+      steps): sources and sinks, friction constraints, particles which
+      leave the mesh, and the quasi-static, steady state, artificial
+      compressibility and multi-rate modes. The lanes hold doubles also
+      in a mixed precision build.
+
+FILE: LaneEnsemble.hpp
+**************************************************************************/
+#ifndef MPM_LANEENSEMBLE_H
+#define MPM_LANEENSEMBLE_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+
+// eigen header files
+#include <Eigen/Dense>
+
+// mpm header files
+#include "PropertyParse.hpp"
+#include "NodeData.hpp"
+#include "ShapeBatch.hpp"
+#include "MaterialBase.hpp"
+#include "Simulation.hpp"
+
+namespace mpm {
+    class LaneEnsemble;
+}
+
+
+class mpm::LaneEnsemble {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+    static const unsigned dof = 3 * (dim - 1);
+
+    typedef mpm::NodeData::Field Field;
+    typedef std::vector<mpm::material::MaterialBase*> MaterialVector;
+
+    // entries of a stress batch (a multiple of width, so a batch starts at
+    // lane 0)
+    static const unsigned batchSize = 128;
+
+public:
+    // number of lanes: the variants advanced together
+    static const unsigned width = 4;
+
+    // CONSTRUCTOR: the variants of the case (at most width) with their
+    // settings and the parameters of their materials
+    LaneEnsemble(const mpm::CaseInput& input, const std::vector<mpm::misc::Settings>& settings, const std::vector<mpm::misc::PropertyList>& overrides);
+
+    // DESTRUCTOR
+    ~LaneEnsemble();
+
+    // GIVE WHY A VARIANT OF THESE SETTINGS CANNOT RUN IN THE LANES (EMPTY
+    // IF IT CAN)
+    static std::string unsupported(const mpm::misc::Settings& settings);
+
+    // SOLVE ONE TIME STEP OF ALL VARIANTS
+    void solve_one_step();
+
+    // COPY THE STATE OF THE LANES TO THE PARTICLES OF THE VARIANTS
+    void write_variants();
+
+    // GIVE NUMBER OF VARIANTS
+    unsigned number_of_variants() const {
+        return simulations_.size();
+    }
+
+    // GIVE THE SIMULATION OF A VARIANT (ITS PARTICLES ARE UP TO DATE AFTER
+    // write_variants)
+    mpm::Simulation& simulation(const unsigned& variant) {
+        return *simulations_.at(variant);
+    }
+
+    // GIVE NUMBER OF PARTICLES (OF EACH VARIANT)
+    unsigned number_of_particles() const {
+        return numParticles_;
+    }
+
+    // GIVE NUMBER OF STEPS AND TIME SOLVED
+    unsigned step() const {
+        return step_;
+    }
+    double time() const {
+        return time_;
+    }
+
+protected:
+    // the stages of the step
+    void locate_particles();
+    void compute_shape_functions();
+    void map_particles_to_nodes();
+    void solve_nodes();
+    void compute_strain_rates();
+    void update_stress();
+    void update_particles();
+
+    // compute the stress of the particles [begin, end) of a material
+    void compute_stress_of_range(const unsigned& material, const unsigned& begin, const unsigned& end);
+
+    // give the slot (node * width + lane) of node k of the element of each
+    // lane of a particle
+    void node_slots(const unsigned& particle, const unsigned& k, unsigned* slots) const {
+        const unsigned offset = layout_->nodeOffsets[k] * width;
+        for (unsigned w = 0; w < width; w++)
+            slots[w] = firstSlot_[particle * width + w] + offset;
+    }
+
+private:
+    // not copied: the simulations are owned
+    LaneEnsemble(const LaneEnsemble&);
+    LaneEnsemble& operator=(const LaneEnsemble&);
+
+protected:
+    // the simulations of the variants and their materials, by material id
+    // and lane
+    std::vector<mpm::Simulation*> simulations_;
+    std::vector<MaterialVector> materials_;
+    const mpm::MeshTopology* layout_;
+    double dt_;
+    unsigned numParticles_;
+    // first particle of each material, and the end of the last one
+    std::vector<unsigned> materialOffsets_;
+
+    // STATE OF THE PARTICLES
+    std::array<Field, dim> coord_;
+    std::array<Field, dim> velocity_;
+    std::array<Field, 6> stress_;
+    std::array<Field, dof> strain_;
+    Field pressure_;
+    Field density_;
+    Field mass_;
+    Field volume_;
+    // gravity of each lane
+    std::array<Field, dim> gravity_;
+
+    // FIELDS OF A STEP: element and slot of its first node, shape
+    // functions and their derivatives (component d * numNodes + n is
+    // dN_n / dx_d), length of the element, BBar strain rate, volumetric
+    // strain rate and that of the centre of the element from the nodes
+    std::vector<unsigned> element_;
+    std::vector<unsigned> firstSlot_;
+    std::array<Field, numNodes> shapeFun_;
+    std::array<Field, dim * numNodes> gradShapeFun_;
+    std::array<Field, dim> length_;
+    std::array<Field, dof> BBarStrainRate_;
+    Field volStrainRate_;
+    Field centreVolStrainRate_;
+
+    // NODES OF ALL LANES, AND THE RANGE OF THE NODES OF THE PARTICLES
+    mpm::NodeData nodes_;
+    unsigned nodeBegin_;
+    unsigned nodeEnd_;
+
+    unsigned step_;
+    double time_;
+};
+
+#include "LaneEnsemble.ipp"
+
+#endif
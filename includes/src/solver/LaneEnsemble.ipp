@@ -0,0 +1,500 @@
+const unsigned mpm::LaneEnsemble::width;
+const unsigned mpm::LaneEnsemble::batchSize;
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: CONSTRUCTOR
+          Each variant is built as a Simulation of its own, and the state
+          of its particles is copied to its lane. The particles of all
+          variants are in the same order (that of particles.dat, sorted by
+          material), so particle i of every lane is the same particle.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+mpm::LaneEnsemble::LaneEnsemble(const mpm::CaseInput& input, const std::vector<mpm::misc::Settings>& settings, const std::vector<mpm::misc::PropertyList>& overrides)
+    : nodes_(false), step_(0), time_(0.) {
+
+    if (settings.empty() || settings.size() > width || overrides.size() != settings.size()) {
+        std::cerr << "ERROR: the lanes take 1 to " << width << " variants (" << settings.size() << " given)" << "\n";
+        abort();
+    }
+    for (unsigned v = 0; v < settings.size(); v++) {
+        const std::string reason = unsupported(settings[v]);
+        if (!reason.empty()) {
+            std::cerr << "ERROR: the lanes do not support " << reason << " (variant " << v << ")" << "\n";
+            abort();
+        }
+        if (settings[v].dt != settings[0].dt) {
+            std::cerr << "ERROR: the variants in the lanes need the same dt (variant " << v << ")" << "\n";
+            abort();
+        }
+    }
+
+    for (unsigned v = 0; v < settings.size(); v++)
+        simulations_.push_back(new mpm::Simulation(input, settings[v], overrides[v]));
+    if (!simulations_[0]->sources()->empty()) {
+        std::cerr << "ERROR: the lanes do not support sources and sinks (feedParticle.dat)" << "\n";
+        abort();
+    }
+    if (simulations_[0]->mesh()->has_friction_constraints()) {
+        std::cerr << "ERROR: the lanes do not support friction constraints (fricCon.dat)" << "\n";
+        abort();
+    }
+    layout_ = input.topology.get();
+    dt_ = settings[0].dt;
+
+    // the variant of each lane
+    std::vector<mpm::MpmParticle*> lanes;
+    for (unsigned w = 0; w < width; w++)
+        lanes.push_back(simulations_[std::min(w, (unsigned)simulations_.size() - 1)]->particles());
+
+    numParticles_ = lanes[0]->number_of_particles();
+    const unsigned numMaterials = lanes[0]->number_of_materials();
+    for (unsigned m = 0; m < numMaterials; m++) {
+        unsigned begin, end;
+        lanes[0]->material_range(m, begin, end);
+        materialOffsets_.push_back(begin);
+        MaterialVector materials;
+        for (unsigned w = 0; w < width; w++)
+            materials.push_back(lanes[w]->give_material(m));
+        materials_.push_back(materials);
+    }
+    materialOffsets_.push_back(numParticles_);
+
+    const unsigned n = numParticles_ * width;
+    for (unsigned d = 0; d < dim; d++) {
+        coord_[d].assign(n, 0.);
+        velocity_[d].assign(n, 0.);
+        length_[d].assign(n, 0.);
+        gravity_[d].assign(width, 0.);
+    }
+    for (unsigned k = 0; k < 6; k++)
+        stress_[k].assign(n, 0.);
+    for (unsigned k = 0; k < dof; k++) {
+        strain_[k].assign(n, 0.);
+        BBarStrainRate_[k].assign(n, 0.);
+    }
+    for (unsigned k = 0; k < numNodes; k++)
+        shapeFun_[k].assign(n, 0.);
+    for (unsigned k = 0; k < dim * numNodes; k++)
+        gradShapeFun_[k].assign(n, 0.);
+    pressure_.assign(n, 0.);
+    density_.assign(n, 0.);
+    mass_.assign(n, 0.);
+    volume_.assign(n, 0.);
+    volStrainRate_.assign(n, 0.);
+    centreVolStrainRate_.assign(n, 0.);
+    element_.assign(n, 0);
+    firstSlot_.assign(n, 0);
+
+    for (unsigned w = 0; w < width; w++) {
+        for (unsigned d = 0; d < dim; d++)
+            gravity_[d][w] = lanes[w]->give_gravity()(d);
+        for (unsigned p = 0; p < numParticles_; p++) {
+            const mpm::Particle* particle = lanes[w]->pointer_to_particle(p);
+            const unsigned e = p * width + w;
+            for (unsigned d = 0; d < dim; d++) {
+                coord_[d][e] = particle->give_coordinates()(d);
+                velocity_[d][e] = particle->give_velocity()(d);
+            }
+            for (unsigned k = 0; k < 6; k++)
+                stress_[k][e] = particle->give_stress()(k);
+            for (unsigned k = 0; k < dof; k++)
+                strain_[k][e] = particle->give_strain()(k);
+            pressure_[e] = particle->give_pressure();
+            density_[e] = particle->give_density();
+            mass_[e] = particle->give_mass();
+            volume_[e] = particle->give_volume();
+        }
+    }
+
+    nodes_.layout = layout_;
+    nodes_.resize(layout_->number_of_nodes() * width);
+    nodeBegin_ = 0;
+    nodeEnd_ = 0;
+}
+
+
+mpm::LaneEnsemble::~LaneEnsemble() {
+    for (auto simulation : simulations_)
+        delete simulation;
+}
+
+
+std::string mpm::LaneEnsemble::unsupported(const mpm::misc::Settings& settings) {
+    if (settings.quasiStatic)
+        return "quasiStaticFlag";
+    if (settings.steadyStateTolerance > 0.)
+        return "steadyStateTolerance";
+    if (settings.machNumber > 0.)
+        return "machNumber";
+    if (settings.multiRateLevels > 1)
+        return "multiRateLevels";
+    return "";
+}
+
+
+//! FUNCTION: SOLVE ONE STEP
+//!           The stages of MpmSolver::solve_one_step, each one a pass
+//!           over the particles (or nodes) of all lanes.
+//!
+void mpm::LaneEnsemble::solve_one_step() {
+    nodes_.initialise();
+    this->locate_particles();
+    this->compute_shape_functions();
+    this->map_particles_to_nodes();
+    this->solve_nodes();
+    this->compute_strain_rates();
+    this->update_stress();
+    this->update_particles();
+    step_++;
+    time_ += dt_;
+}
+
+
+void mpm::LaneEnsemble::write_variants() {
+    for (unsigned v = 0; v < simulations_.size(); v++) {
+        mpm::MpmParticle* particles = simulations_[v]->particles();
+        for (unsigned p = 0; p < numParticles_; p++) {
+            const unsigned e = p * width + v;
+            Eigen::Matrix<double, 1, dim> coord, velocity;
+            Eigen::Matrix<double, 1, 6> stress;
+            Eigen::Matrix<double, 1, dof> strain;
+            for (unsigned d = 0; d < dim; d++) {
+                coord(d) = coord_[d][e];
+                velocity(d) = velocity_[d][e];
+            }
+            for (unsigned k = 0; k < 6; k++)
+                stress(k) = stress_[k][e];
+            for (unsigned k = 0; k < dof; k++)
+                strain(k) = strain_[k][e];
+            particles->pointer_to_particle(p)->set_state(coord, velocity, stress, pressure_[e], strain, density_[e]);
+        }
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: LOCATE_PARTICLES
+          The element of each lane as in Mesh::locate_particles_in_mesh. A
+          particle which leaves the mesh in one variant would be removed
+          from that variant only, so the run stops. The nodes are solved
+          over the range of the nodes of the elements of all lanes; the
+          nodes in between without particles have no mass and stay at
+          zero, as in the mesh.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::LaneEnsemble::locate_particles() {
+    const mpm::MeshTopology& topology = *layout_;
+    unsigned minElement = topology.number_of_elements();
+    unsigned maxElement = 0;
+    Eigen::Matrix<int, 1, dim> grid;
+    for (unsigned e = 0; e < numParticles_ * width; e++) {
+        for (unsigned j = 0; j < dim; j++) {
+            grid(j) = std::max(-1., std::min(double(topology.numElements(j)), std::floor((coord_[j][e] - topology.firstNodeCoord(j)) / topology.meshSpacing(j))));
+            if (grid(j) < 0 || grid(j) >= int(topology.numElements(j))) {
+                std::cerr << "ERROR: particle " << e / width << " of variant " << e % width << " left the mesh (not supported in the lanes)" << "\n";
+                abort();
+            }
+        }
+        const unsigned element = grid(0) + topology.numElements(0) * grid(1);
+        element_[e] = element;
+        firstSlot_[e] = topology.first_node(element) * width + e % width;
+        minElement = std::min(minElement, element);
+        maxElement = std::max(maxElement, element);
+    }
+    if (minElement > maxElement)
+        return;
+    unsigned lastOffset = 0;
+    for (unsigned k = 0; k < numNodes; k++)
+        lastOffset = std::max(lastOffset, topology.nodeOffsets[k]);
+    nodeBegin_ = topology.first_node(minElement);
+    nodeEnd_ = topology.first_node(maxElement) + lastOffset + 1;
+}
+
+
+//! FUNCTION: COMPUTE SHAPE FUNCTIONS
+//!           The lanes of the particles are the entries of the ShapeBatch
+//!           of the particles (the same kernel and results).
+//!
+void mpm::LaneEnsemble::compute_shape_functions() {
+    const unsigned n = numParticles_ * width;
+    const unsigned batchWidth = mpm::ShapeBatch::width;
+    mpm::ShapeBatch batch;
+    for (unsigned first = 0; first < n; first += batchWidth) {
+        batch.size = std::min(n - first, batchWidth);
+        for (unsigned i = 0; i < batch.size; i++) {
+            const unsigned element = element_[first + i];
+            for (unsigned k = 0; k < dim; k++) {
+                batch.coord[k * batchWidth + i] = coord_[k][first + i];
+                batch.centre[k * batchWidth + i] = layout_->elementCentre[k][element];
+                batch.length[k * batchWidth + i] = layout_->elementLength[k][element];
+            }
+        }
+        for (unsigned i = batch.size; i < batchWidth; i++) {
+            for (unsigned k = 0; k < dim; k++) {
+                batch.coord[k * batchWidth + i] = 0.;
+                batch.centre[k * batchWidth + i] = 0.;
+                batch.length[k * batchWidth + i] = 1.;
+            }
+        }
+        batch.compute();
+        for (unsigned i = 0; i < batch.size; i++) {
+            for (unsigned k = 0; k < numNodes; k++)
+                shapeFun_[k][first + i] = batch.shapeFun[k * batchWidth + i];
+            for (unsigned k = 0; k < dim * numNodes; k++)
+                gradShapeFun_[k][first + i] = batch.gradShapeFun[k * batchWidth + i];
+            for (unsigned k = 0; k < dim; k++)
+                length_[k][first + i] = batch.length[k * batchWidth + i];
+        }
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: MAP_PARTICLES_TO_NODES
+          Mass, momentum, body force and internal force of
+          Particle::map_mass_to_grid .. assign_internal_force_to_grid in
+          one pass; each nodal field still sums the particles in their
+          order. The lanes of a particle write to different slots, so the
+          loops over the lanes are vectorized. The internal force is the
+          product of the particle as Eigen evaluates it: the volume
+          times each entry of B (the zero entries kept), times the
+          stress.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::LaneEnsemble::map_particles_to_nodes() {
+    double* nodeMass = nodes_.mass.data();
+    double* momentumX = nodes_.momentum[0].data();
+    double* momentumY = nodes_.momentum[1].data();
+    double* extForceX = nodes_.extForce[0].data();
+    double* extForceY = nodes_.extForce[1].data();
+    double* intForceX = nodes_.intForce[0].data();
+    double* intForceY = nodes_.intForce[1].data();
+    const double* gravityX = gravity_[0].data();
+    const double* gravityY = gravity_[1].data();
+
+    for (unsigned p = 0; p < numParticles_; p++) {
+        const unsigned e = p * width;
+        const double* mass = mass_.data() + e;
+        const double* density = density_.data() + e;
+        const double* vx = velocity_[0].data() + e;
+        const double* vy = velocity_[1].data() + e;
+        const double* s0 = stress_[0].data() + e;
+        const double* s1 = stress_[1].data() + e;
+        const double* s3 = stress_[3].data() + e;
+        for (unsigned k = 0; k < numNodes; k++) {
+            unsigned slots[width];
+            this->node_slots(p, k, slots);
+            const double* N = shapeFun_[k].data() + e;
+            const double* dNdx = gradShapeFun_[k].data() + e;
+            const double* dNdy = gradShapeFun_[numNodes + k].data() + e;
+#pragma omp simd
+            for (unsigned w = 0; w < width; w++) {
+                const unsigned slot = slots[w];
+                nodeMass[slot] += mass[w] * N[w];
+                momentumX[slot] += mass[w] * vx[w] * N[w];
+                momentumY[slot] += mass[w] * vy[w] * N[w];
+                extForceX[slot] += N[w] * mass[w] * gravityX[w];
+                extForceY[slot] += N[w] * mass[w] * gravityY[w];
+                const double volume = mass[w] / density[w];
+                intForceX[slot] += -((volume * dNdx[w]) * s0[w] + (volume * 0.) * s1[w] + (volume * dNdy[w]) * s3[w]);
+                intForceY[slot] += -((volume * 0.) * s0[w] + (volume * dNdy[w]) * s1[w] + (volume * dNdx[w]) * s3[w]);
+            }
+        }
+    }
+}
+
+
+//! FUNCTION: SOLVE NODES
+//!           The nodal kernel of the mesh over the slots of the nodes of
+//!           the particles, then the velocity constraints (the same for
+//!           all variants) in every lane.
+//!
+void mpm::LaneEnsemble::solve_nodes() {
+    nodes_.solve_velocity_and_acceleration(dt_, nodeBegin_ * width, nodeEnd_ * width);
+    simulations_[0]->mesh()->apply_constraints_to_lanes(nodes_, width);
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: COMPUTE_STRAIN_RATES
+          The volumetric strain rate (B) and the BBar strain rate of
+          Particle::compute_strain_rate and compute_BBar_strain_rate, with
+          the derivatives at the centre of the element of
+          compute_global_derivatives_shape_functions_at_centre; then the
+          volumetric strain rate is mapped to the nodes and read back at
+          the centre of the element.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::LaneEnsemble::compute_strain_rates() {
+    // dN/dx and dN/dy at the centre of the element times its length
+    const double centreX[numNodes] = {-0.5, 0.5, 0.5, -0.5};
+    const double centreY[numNodes] = {-0.5, -0.5, 0.5, 0.5};
+    const double* nodeVx = nodes_.velocity[0].data();
+    const double* nodeVy = nodes_.velocity[1].data();
+    double* nodeVolStrainRate = nodes_.volStrainRate.data();
+
+    for (unsigned p = 0; p < numParticles_; p++) {
+        const unsigned e = p * width;
+        const double* Lx = length_[0].data() + e;
+        const double* Ly = length_[1].data() + e;
+        double rate0[width] = {}, rate1[width] = {};
+        double BBar0[width] = {}, BBar1[width] = {}, BBar2[width] = {};
+        for (unsigned k = 0; k < numNodes; k++) {
+            unsigned slots[width];
+            this->node_slots(p, k, slots);
+            const double* dNdx = gradShapeFun_[k].data() + e;
+            const double* dNdy = gradShapeFun_[numNodes + k].data() + e;
+#pragma omp simd
+            for (unsigned w = 0; w < width; w++) {
+                const double vx = nodeVx[slots[w]];
+                const double vy = nodeVy[slots[w]];
+                const double dNdxCentre = centreX[k] / Lx[w];
+                const double dNdyCentre = centreY[k] / Ly[w];
+                rate0[w] += dNdx[w] * vx + 0. * vy;
+                rate1[w] += 0. * vx + dNdy[w] * vy;
+                const double BBar00 = (1/3.0) * (dNdxCentre + (2 * dNdx[w]));
+                const double BBar01 = (1/3.0) * (dNdxCentre - dNdx[w]);
+                const double BBar11 = (1/3.0) * (dNdyCentre + (2 * dNdy[w]));
+                BBar0[w] += BBar00 * vx + BBar01 * vy;
+                BBar1[w] += 0. * vx + BBar11 * vy;
+                BBar2[w] += dNdy[w] * vx + dNdx[w] * vy;
+            }
+        }
+        for (unsigned w = 0; w < width; w++) {
+            volStrainRate_[e + w] = rate0[w] + rate1[w];
+            BBarStrainRate_[0][e + w] = BBar0[w];
+            BBarStrainRate_[1][e + w] = BBar1[w];
+            BBarStrainRate_[2][e + w] = BBar2[w];
+        }
+    }
+
+    for (unsigned p = 0; p < numParticles_; p++) {
+        const unsigned e = p * width;
+        const double* volume = volume_.data() + e;
+        const double* rate = volStrainRate_.data() + e;
+        for (unsigned k = 0; k < numNodes; k++) {
+            unsigned slots[width];
+            this->node_slots(p, k, slots);
+            const double* N = shapeFun_[k].data() + e;
+#pragma omp simd
+            for (unsigned w = 0; w < width; w++)
+                nodeVolStrainRate[slots[w]] += volume[w] * rate[w] * N[w];
+        }
+    }
+
+    for (unsigned p = 0; p < numParticles_; p++) {
+        const unsigned e = p * width;
+        double centre[width] = {};
+        for (unsigned k = 0; k < numNodes; k++) {
+            unsigned slots[width];
+            this->node_slots(p, k, slots);
+#pragma omp simd
+            for (unsigned w = 0; w < width; w++)
+                centre[w] += (1. / numNodes) * nodeVolStrainRate[slots[w]];
+        }
+        for (unsigned w = 0; w < width; w++)
+            centreVolStrainRate_[e + w] = centre[w];
+    }
+}
+
+
+void mpm::LaneEnsemble::update_stress() {
+    for (unsigned k = 0; k < dof; k++) {
+        double* strain = strain_[k].data();
+        const double* rate = BBarStrainRate_[k].data();
+#pragma omp simd
+        for (unsigned e = 0; e < numParticles_ * width; e++)
+            strain[e] += rate[e] * dt_;
+    }
+    for (unsigned m = 0; m < materials_.size(); m++)
+        this->compute_stress_of_range(m, materialOffsets_[m] * width, materialOffsets_[m + 1] * width);
+}
+
+
+//! FUNCTION: COMPUTE STRESS OF A RANGE
+//!           As MpmParticle::compute_stress_of_range, with the lanes of the
+//!           particles as the entries of the batch. A batch starts at a
+//!           particle, so entry i is in lane i % width.
+//!
+void mpm::LaneEnsemble::compute_stress_of_range(const unsigned& material, const unsigned& begin, const unsigned& end) {
+    double dStrain[dof * batchSize];
+    double dVolStrain[batchSize];
+    double stress[6 * batchSize];
+    double pressure[batchSize];
+
+    mpm::material::StressBatch batch;
+    batch.stride = batchSize;
+    batch.dt = dt_;
+    batch.dStrain = dStrain;
+    batch.dVolStrain = dVolStrain;
+    batch.stress = stress;
+    batch.pressure = pressure;
+
+    const MaterialVector& lanes = materials_[material];
+    for (unsigned first = begin; first < end; first += batchSize) {
+        batch.size = std::min(end - first, batchSize);
+        for (unsigned i = 0; i < batch.size; i++) {
+            for (unsigned k = 0; k < dof; k++)
+                dStrain[k * batchSize + i] = dt_ * BBarStrainRate_[k][first + i];
+            dVolStrain[i] = dt_ * centreVolStrainRate_[first + i];
+            for (unsigned k = 0; k < 6; k++)
+                stress[k * batchSize + i] = stress_[k][first + i];
+            pressure[i] = pressure_[first + i];
+        }
+        lanes[0]->computeStress(batch, lanes);
+        for (unsigned i = 0; i < batch.size; i++) {
+            for (unsigned k = 0; k < 6; k++)
+                stress_[k][first + i] = stress[k * batchSize + i];
+            pressure_[first + i] = pressure[i];
+        }
+    }
+}
+
+
+//! FUNCTION: UPDATE PARTICLES
+//!           Velocity, position and density of
+//!           Particle::update_velocity_from_grid, update_position_from_grid
+//!           and update_density.
+//!
+void mpm::LaneEnsemble::update_particles() {
+    const double* nodeAx = nodes_.acceleration[0].data();
+    const double* nodeAy = nodes_.acceleration[1].data();
+    const double* nodeVx = nodes_.velocity[0].data();
+    const double* nodeVy = nodes_.velocity[1].data();
+    const double dt = dt_;
+
+    for (unsigned p = 0; p < numParticles_; p++) {
+        const unsigned e = p * width;
+        double ax[width] = {}, ay[width] = {}, vx[width] = {}, vy[width] = {};
+        for (unsigned k = 0; k < numNodes; k++) {
+            unsigned slots[width];
+            this->node_slots(p, k, slots);
+            const double* N = shapeFun_[k].data() + e;
+#pragma omp simd
+            for (unsigned w = 0; w < width; w++) {
+                ax[w] += N[w] * nodeAx[slots[w]];
+                ay[w] += N[w] * nodeAy[slots[w]];
+                vx[w] += N[w] * nodeVx[slots[w]];
+                vy[w] += N[w] * nodeVy[slots[w]];
+            }
+        }
+        double* velocityX = velocity_[0].data() + e;
+        double* velocityY = velocity_[1].data() + e;
+        double* coordX = coord_[0].data() + e;
+        double* coordY = coord_[1].data() + e;
+#pragma omp simd
+        for (unsigned w = 0; w < width; w++) {
+            velocityX[w] = velocityX[w] + dt * (std::fabs(ax[w]) < 1.0E-16 ? 0. : ax[w]);
+            velocityY[w] = velocityY[w] + dt * (std::fabs(ay[w]) < 1.0E-16 ? 0. : ay[w]);
+            coordX[w] = coordX[w] + dt * (std::fabs(vx[w]) < 1.0E-16 ? 0. : vx[w]);
+            coordY[w] = coordY[w] + dt * (std::fabs(vy[w]) < 1.0E-16 ? 0. : vy[w]);
+        }
+    }
+
+    double* density = density_.data();
+    double* volume = volume_.data();
+    const double* mass = mass_.data();
+    const double* rate = centreVolStrainRate_.data();
+#pragma omp simd
+    for (unsigned e = 0; e < numParticles_ * width; e++) {
+        density[e] = density[e] / (1 + (dt * rate[e]));
+        volume[e] = mass[e] / density[e];
+    }
+}
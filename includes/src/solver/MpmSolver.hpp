@@ -0,0 +1,141 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: The explicit time step of the weakly compressible fluid solver
+      (update stress first). Each stage is timed by the phase timer.
+      The solver keeps a copy of the settings of its simulation.
+      With a tile size (tileSize) the mapping to the nodes and the update
+      of the particles run tile by tile (TiledTransfer).
+      With deterministic the sums at the nodes are done in the order of
+      the particles (DeterministicTransfer), so the results do not depend
+      on the number of threads.
+      With taskGraph the stages after locate_particles run as a TaskGraph
+      over chunks of particles and nodes.
+      In the quasi-static mode (QuasiStatic) the nodal accelerations are
+      damped after the nodal solve; the stages then run in sequence.
+      With multiRateLevels (MultiRate) a step is done in substeps, in
+      which only the particles of the levels due are updated.
+
+FILE: MpmSolver.hpp
+**************************************************************************/
+#ifndef MPM_MPMSOLVER_H
+#define MPM_MPMSOLVER_H 
+                                                                         
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <functional>
+
+// mpm miscellaneous header files
+#include "PropertyParse.hpp"
+#include "Timer.hpp"
+
+// mpm main header files
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "ParticleSource.hpp"
+#include "Element.hpp"
+#include "Node.hpp"
+#include "Particle.hpp"
+#include "TiledTransfer.hpp"
+#include "DeterministicTransfer.hpp"
+#include "TaskGraph.hpp"
+#include "QuasiStatic.hpp"
+#include "MultiRate.hpp"
+
+namespace mpm {
+    class MpmSolver;
+}
+
+class mpm::MpmSolver {
+
+protected:
+    typedef mpm::Mesh*          MeshPtr;
+    typedef mpm::MpmParticle*   ParticleSetPtr;
+    typedef mpm::ParticleSource* ParticleSourcePtr;
+    typedef mpm::misc::ScopedTimer Timed;
+
+public:
+    // CONSTRUCTOR
+    MpmSolver(MeshPtr mesh, ParticleSetPtr particles, const mpm::misc::Settings& settings, mpm::misc::PhaseTimer& timer);
+
+    // SET THE SOURCES AND SINKS OF PARTICLES (NOT OWNED)
+    void set_particle_source(ParticleSourcePtr source) {
+        source_ = source;
+    }
+
+    // SET THE DYNAMIC RELAXATION OF THE QUASI-STATIC MODE (NOT OWNED)
+    void set_quasi_static(mpm::QuasiStatic* quasiStatic) {
+        quasiStatic_ = quasiStatic;
+    }
+
+    // SET THE LEVELS OF THE MULTI-RATE STEP (NOT OWNED)
+    void set_multi_rate(mpm::MultiRate* multiRate) {
+        multiRate_ = multiRate;
+    }
+
+    // SOLVE ONE TIME STEP
+    void solve_one_step(const double& dt);
+
+    // INSERT AND REMOVE PARTICLES AT SOURCES AND SINKS
+    void apply_particle_sources(const double& dt);
+
+    // INITIALISE MESH AND PARTICLES
+    void initialise();
+
+    // LOCATE PARTICLES IN THE MESH
+    void locate_particles();
+
+    // COMPUTE SHAPE FUNCTIONS AND B MATRICES
+    void compute_shape_functions();
+
+    // MAP MASS, MOMENTUM AND FORCES TO NODES
+    void map_particles_to_nodes();
+
+    // SOLVE NODAL ACCELERATION AND VELOCITY
+    void solve_nodes(const double& dt);
+
+    // COMPUTE STRAIN RATES FROM NODAL VELOCITIES
+    void compute_strain_rates();
+
+    // UPDATE STRAIN AND STRESS
+    void update_stress(const double& dt);
+
+    // UPDATE PARTICLE VELOCITY, POSITION AND DENSITY
+    void update_particles(const double& dt);
+
+    // SOLVE ONE TIME STEP IN SUBSTEPS OF THE LEVELS OF THE PARTICLES
+    void solve_multi_rate_step(const double& dt);
+
+    // DESCRIBE THE STAGES AFTER locate_particles AS A GRAPH OF TASKS
+    void build_task_graph(const double& dt);
+
+    // GIVE THE TASK GRAPH OF THE LAST STEP
+    const mpm::TaskGraph& task_graph() const {
+        return graph_;
+    }
+
+protected:
+    // call function(begin, end) for the range of particles of each
+    // material of a level
+    template<typename FR>
+    void iterate_over_level(const unsigned& level, FR function);
+
+protected:
+    MeshPtr mesh_;
+    ParticleSetPtr particles_;
+    ParticleSourcePtr source_;
+    mpm::QuasiStatic* quasiStatic_;
+    mpm::MultiRate* multiRate_;
+    mpm::misc::Settings settings_;
+    mpm::misc::PhaseTimer& timer_;
+    mpm::TiledTransfer tiles_;
+    mpm::DeterministicTransfer ordered_;
+    mpm::TaskGraph graph_;
+};
+
+#include "MpmSolver.ipp"
+
+#endif
@@ -0,0 +1,449 @@
+
+mpm::MpmSolver::MpmSolver(MeshPtr mesh, ParticleSetPtr particles, const mpm::misc::Settings& settings, mpm::misc::PhaseTimer& timer)
+    : mesh_(mesh), particles_(particles), source_(NULL), quasiStatic_(NULL), multiRate_(NULL), settings_(settings), timer_(timer),
+      tiles_(mesh, settings.tileSize), ordered_(mesh, settings.deterministic) { }
+
+
+//! FUNCTION: SOLVE ONE STEP
+//!           One explicit step: particles are located, mass, momentum
+//!           and forces are mapped to nodes, nodal kinematics are solved
+//!           and the stress, velocity and position of particles are
+//!           updated. Particles are inserted and removed at sources and
+//!           sinks (if any) before the step. With the task graph the
+//!           stages after locate_particles run as tasks (not in the
+//!           quasi-static mode). With the levels of the multi-rate mode
+//!           the step is done in substeps.
+//!
+void mpm::MpmSolver::solve_one_step(const double& dt) {
+    if (source_)
+        this->apply_particle_sources(dt);
+    if (multiRate_) {
+        this->solve_multi_rate_step(dt);
+        return;
+    }
+    this->initialise();
+    this->locate_particles();
+    if (settings_.taskGraph && !quasiStatic_) {
+      { Timed t(timer_, "build_task_graph");
+        this->build_task_graph(dt); }
+      { Timed t(timer_, "execute_task_graph");
+        graph_.execute(timer_); }
+      return;
+    }
+    this->compute_shape_functions();
+    this->map_particles_to_nodes();
+    this->solve_nodes(dt);
+    this->compute_strain_rates();
+    this->update_stress(dt);
+    this->update_particles(dt);
+}
+
+
+void mpm::MpmSolver::apply_particle_sources(const double& dt) {
+    { Timed t(timer_, "apply_particle_sources");
+      source_->apply(particles_, dt); }
+}
+
+
+void mpm::MpmSolver::initialise() {
+    { Timed t(timer_, "initialise_mesh");
+      mesh_->initialise_mesh(settings_.freeSurface); }
+    { Timed t(timer_, "initialise_particle");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::initialise_particle, std::placeholders::_1)); }
+}
+
+
+void mpm::MpmSolver::locate_particles() {
+    { Timed t(timer_, "locate_particles_in_mesh");
+      mesh_->locate_particles_in_mesh(particles_); }
+    // particles which left the mesh stay as tombstones until enough of
+    // them are collected
+    if (particles_->compaction_due()) {
+      Timed t(timer_, "compact_particles");
+      particles_->compact(); }
+    if (tiles_.enabled()) {
+      Timed t(timer_, "bin_particles_in_tiles");
+      tiles_.bin_particles(particles_); }
+    if (ordered_.enabled()) {
+      Timed t(timer_, "build_node_slots");
+      ordered_.build_node_slots(particles_); }
+}
+
+
+void mpm::MpmSolver::compute_shape_functions() {
+    // removed particles are massless and add nothing to the nodes, so
+    // xi, N and dN/dx are computed in batches over the whole container
+    { Timed t(timer_, "compute_shape_functions_batched");
+      particles_->compute_shape_functions(); }
+    { Timed t(timer_, "compute_global_derivatives_shape_functions_at_centre");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_global_derivatives_shape_functions_at_centre, std::placeholders::_1)); }
+    { Timed t(timer_, "compute_B_matrix");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix, std::placeholders::_1)); }
+    { Timed t(timer_, "compute_BBar_matrix");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_matrix, std::placeholders::_1)); }
+    { Timed t(timer_, "compute_B_matrix_at_centre");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_B_matrix_at_centre, std::placeholders::_1)); }
+}
+
+
+void mpm::MpmSolver::map_particles_to_nodes() {
+    // the fixed order of the sums takes precedence over the tiles
+    if (ordered_.enabled()) {
+      Timed t(timer_, "map_particles_to_node_slots");
+      ordered_.map_particles_to_nodes(particles_);
+      return; }
+    if (tiles_.enabled()) {
+      Timed t(timer_, "map_particles_to_tiles");
+      tiles_.map_particles_to_nodes(particles_);
+      return; }
+    { Timed t(timer_, "map_mass_to_nodes");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::map_mass_to_nodes, std::placeholders::_1)); }
+    { Timed t(timer_, "map_momentum_to_nodes");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::map_momentum_to_nodes, std::placeholders::_1)); }
+    { Timed t(timer_, "assign_body_force_to_nodes");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::assign_body_force_to_nodes, std::placeholders::_1)); }
+    { Timed t(timer_, "assign_internal_force_to_nodes");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::assign_internal_force_to_nodes, std::placeholders::_1)); }
+}
+
+
+void mpm::MpmSolver::solve_nodes(const double& dt) {
+    { Timed t(timer_, "solve_nodal_velocity_and_acceleration");
+      mesh_->solve_nodal_velocity_and_acceleration(dt); }
+    if (quasiStatic_) {
+      Timed t(timer_, "relax_nodes");
+      quasiStatic_->relax_nodes(mesh_, particles_, dt); }
+    { Timed t(timer_, "apply_constraints");
+      mesh_->apply_friction_constraints(dt);
+      mesh_->apply_acceleration_constraints();
+      mesh_->apply_velocity_constraints(); }
+}
+
+
+void mpm::MpmSolver::compute_strain_rates() {
+    { Timed t(timer_, "compute_strain_rate");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_strain_rate, std::placeholders::_1)); }
+    { Timed t(timer_, "compute_centre_strain_rate");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_strain_rate, std::placeholders::_1)); }
+    { Timed t(timer_, "compute_BBar_strain_rate");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_BBar_strain_rate, std::placeholders::_1)); }
+
+    if (ordered_.enabled()) {
+      Timed t(timer_, "map_volume_and_strain_rate_to_node_slots");
+      ordered_.map_volume_and_strain_rate_to_nodes(particles_); }
+    else {
+      { Timed t(timer_, "map_volume_to_nodes");
+        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_volume_to_nodes, std::placeholders::_1)); }
+      { Timed t(timer_, "map_volumetric_strain_rate_to_nodes");
+        particles_->iterate_over_particles(std::bind(&mpm::Particle::map_volumetric_strain_rate_to_nodes, std::placeholders::_1)); }
+    }
+    { Timed t(timer_, "compute_centre_vol_strain_rate_from_nodes");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_centre_vol_strain_rate_from_nodes, std::placeholders::_1)); }
+}
+
+
+void mpm::MpmSolver::update_stress(const double& dt) {
+    { Timed t(timer_, "compute_strain");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::compute_strain, std::placeholders::_1, dt)); }
+    { Timed t(timer_, "compute_stress");
+      particles_->compute_stress(dt); }
+}
+
+
+void mpm::MpmSolver::update_particles(const double& dt) {
+    if (tiles_.enabled()) {
+      Timed t(timer_, "update_particles_from_tiles");
+      tiles_.update_particles(particles_, dt); }
+    else {
+      { Timed t(timer_, "update_velocity");
+        particles_->iterate_over_particles(std::bind(&mpm::Particle::update_velocity, std::placeholders::_1, dt)); }
+      { Timed t(timer_, "update_position");
+        particles_->iterate_over_particles(std::bind(&mpm::Particle::update_position, std::placeholders::_1, dt)); }
+    }
+    { Timed t(timer_, "update_density");
+      particles_->iterate_over_particles(std::bind(&mpm::Particle::update_density, std::placeholders::_1, dt)); }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SOLVE_MULTI_RATE_STEP
+          The levels are assigned at the start of the step, and the step
+          is done in 2^maxLevel substeps of h = dt / 2^maxLevel. In each
+          substep all particles are located (the particles of the levels
+          in the middle of their interval have not moved, but the
+          elements are cleared with the mesh), then:
+            - the levels whose interval starts compute the shape
+              functions of their particles and map them to their fields;
+            - the nodes of all levels, the sum of their fields, are
+              solved with h and the constraints applied, and each level
+              adds the nodal accelerations to its sum;
+            - the levels whose interval ends, finest first, update their
+              particles with the time step of the level, dt / 2^L: the
+              strain rates from the nodal velocity, the volumetric strain
+              rate smoothed with the volumes of all levels, the stress,
+              and the velocity with the mean nodal acceleration of the
+              interval.
+          The stages of a level are those of the single-rate step, over
+          the ranges of the particles of its materials.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmSolver::solve_multi_rate_step(const double& dt) {
+    { Timed t(timer_, "assign_levels");
+      multiRate_->assign_levels(particles_, dt); }
+    const unsigned numSubsteps = multiRate_->number_of_substeps();
+    const unsigned numLevels = multiRate_->number_of_levels();
+    const double h = dt / numSubsteps;
+    mpm::NodeData& nodes = mesh_->node_data_;
+    ParticleSetPtr particles = particles_;
+    using std::placeholders::_1;
+
+    for (unsigned k = 0; k < numSubsteps; k++) {
+        { Timed t(timer_, "initialise_mesh");
+          mesh_->initialise_mesh(settings_.freeSurface); }
+        this->locate_particles();
+
+        for (unsigned l = numLevels; l-- > 0; ) {
+            if (!multiRate_->is_active(l, k))
+                continue;
+          { Timed t(timer_, "compute_shape_functions_of_level");
+            this->iterate_over_level(l, [&](const unsigned& begin, const unsigned& end) {
+                particles->iterate_over_particles(begin, end, std::bind(&mpm::Particle::initialise_particle, _1));
+                particles->iterate_over_shares(begin, end, [&](const unsigned& first, const unsigned& last) {
+                    particles->compute_shape_functions(first, last);
+                });
+                particles->iterate_over_particles(begin, end, [](mpm::Particle* particle) {
+                    particle->compute_global_derivatives_shape_functions_at_centre();
+                    particle->compute_B_matrix();
+                    particle->compute_BBar_matrix();
+                    particle->compute_B_matrix_at_centre();
+                });
+            }); }
+          { Timed t(timer_, "map_level_to_nodes");
+            multiRate_->map_level(particles_, nodes, l); }
+        }
+
+        unsigned nodeBegin, nodeEnd;
+        multiRate_->node_range(nodeBegin, nodeEnd);
+        multiRate_->count_substep(particles_->number_of_particles(), nodeEnd - nodeBegin);
+        { Timed t(timer_, "sum_levels_at_nodes");
+          multiRate_->sum_levels(nodes, h, nodeBegin, nodeEnd); }
+        { Timed t(timer_, "solve_nodal_velocity_and_acceleration");
+          mesh_->solve_nodal_velocity_and_acceleration(h, nodeBegin, nodeEnd); }
+        { Timed t(timer_, "apply_constraints");
+          mesh_->apply_friction_constraints(h);
+          mesh_->apply_acceleration_constraints();
+          mesh_->apply_velocity_constraints(); }
+        { Timed t(timer_, "add_accelerations_of_levels");
+          multiRate_->add_accelerations(nodes); }
+
+        for (unsigned l = numLevels; l-- > 0; ) {
+            if (!multiRate_->is_active(l, k + 1))
+                continue;
+            const double hLevel = dt / (1u << l);
+          { Timed t(timer_, "compute_strain_rate_of_level");
+            this->iterate_over_level(l, [&](const unsigned& first, const unsigned& last) {
+                particles->iterate_over_particles(first, last, [](mpm::Particle* particle) {
+                    particle->compute_strain_rate();
+                    particle->compute_centre_strain_rate();
+                    particle->compute_BBar_strain_rate();
+                });
+            }); }
+          { Timed t(timer_, "map_level_volume_to_nodes");
+            multiRate_->map_level_volume(particles_, l);
+            multiRate_->sum_level_volumes(nodes, nodeBegin, nodeEnd); }
+          { Timed t(timer_, "update_stress_of_level");
+            this->iterate_over_level(l, [&](const unsigned& first, const unsigned& last) {
+                particles->iterate_over_particles(first, last, [hLevel](mpm::Particle* particle) {
+                    particle->compute_centre_vol_strain_rate_from_nodes();
+                    particle->compute_strain(hLevel);
+                });
+                particles->iterate_over_shares(first, last, [&](const unsigned& shareBegin, const unsigned& shareEnd) {
+                    particles->compute_stress(shareBegin, shareEnd, hLevel);
+                });
+            }); }
+          { Timed t(timer_, "update_particles_of_level");
+            multiRate_->set_mean_acceleration(nodes, l);
+            this->iterate_over_level(l, [&](const unsigned& first, const unsigned& last) {
+                particles->iterate_over_particles(first, last, [hLevel](mpm::Particle* particle) {
+                    particle->update_velocity(hLevel);
+                    particle->update_position(hLevel);
+                    particle->update_density(hLevel);
+                });
+            }); }
+        }
+    }
+}
+
+
+template<typename FR>
+void mpm::MpmSolver::iterate_over_level(const unsigned& level, FR function) {
+    for (const auto& m : multiRate_->materials_of_level(level)) {
+        unsigned begin, end;
+        particles_->material_range(m, begin, end);
+        if (begin < end)
+            function(begin, end);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: BUILD_TASK_GRAPH
+          The stages of compute_shape_functions .. update_particles, with
+          the data each one reads:
+            - the particle stages read what earlier stages wrote for the
+              same particles, so they wait for the same chunk only;
+            - the mapping stages write different nodal fields, so they
+              run at the same time (the adds to a node are atomic);
+            - the nodal solve needs all particles mapped, the constraints
+              all nodes solved, and the stages which read the nodes (or
+              the nodal volumetric strain rate) wait for those barriers.
+          A stage which overwrites a particle value that another stage
+          reads waits for that stage as well (e.g. update_density after
+          map_volume_to_nodes). The tiled and deterministic transfers
+          replace the mapping stages as in the sequential step; the
+          volume is mapped together with the mass when it is not done by
+          the deterministic transfer.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MpmSolver::build_task_graph(const double& dt) {
+    // particles and nodes of a chunk; multiples of the batches of the
+    // shape functions and the stress
+    const unsigned particleChunk = 1024;
+    const unsigned nodeChunk = 4096;
+    const unsigned numParticles = particles_->number_of_particles();
+    mpm::MpmParticle* particles = particles_;
+    mpm::Mesh* mesh = mesh_;
+    mpm::TiledTransfer* tiles = &tiles_;
+    mpm::DeterministicTransfer* ordered = &ordered_;
+    mpm::TaskGraph& g = graph_;
+    g.clear();
+
+    // a stage which calls "function" for each particle of a chunk
+    auto particle_task = [&](const char* name, void (mpm::Particle::*function)()) {
+        return g.add_task(name, numParticles, particleChunk, [=](const unsigned& begin, const unsigned& end) {
+            for (unsigned i = begin; i < end; i++)
+                (particles->pointer_to_particle(i)->*function)();
+        });
+    };
+    // the same for a function of the time step
+    auto particle_dt_task = [&](const char* name, void (mpm::Particle::*function)(const double&)) {
+        return g.add_task(name, numParticles, particleChunk, [=](const unsigned& begin, const unsigned& end) {
+            for (unsigned i = begin; i < end; i++)
+                (particles->pointer_to_particle(i)->*function)(dt);
+        });
+    };
+
+    // shape functions and B matrices
+    const unsigned shape = g.add_task("compute_shape_functions_batched", numParticles, particleChunk,
+        [=](const unsigned& begin, const unsigned& end) { particles->compute_shape_functions(begin, end); });
+    const unsigned centre = particle_task("compute_global_derivatives_shape_functions_at_centre", &mpm::Particle::compute_global_derivatives_shape_functions_at_centre);
+    const unsigned bMatrix = particle_task("compute_B_matrix", &mpm::Particle::compute_B_matrix);
+    g.wait_for_chunk(bMatrix, shape);
+    const unsigned bBar = particle_task("compute_BBar_matrix", &mpm::Particle::compute_BBar_matrix);
+    g.wait_for_chunk(bBar, shape);
+    g.wait_for_chunk(bBar, centre);
+    const unsigned bCentre = particle_task("compute_B_matrix_at_centre", &mpm::Particle::compute_B_matrix_at_centre);
+    g.wait_for_chunk(bCentre, centre);
+
+    // mapping to the nodes
+    std::vector<unsigned> mapped;
+    unsigned volume = 0;
+    if (ordered->enabled()) {
+        const unsigned slots = g.add_task("map_particles_to_node_slots", numParticles, particleChunk,
+            [=](const unsigned& begin, const unsigned& end) { ordered->map_particles_to_slots(particles, begin, end); });
+        g.wait_for_chunk(slots, shape);
+        g.wait_for_chunk(slots, bMatrix);
+        const unsigned sums = g.add_task("add_node_slots", ordered->number_of_nodes(), nodeChunk,
+            [=](const unsigned& begin, const unsigned& end) { ordered->add_slots_to_nodes(begin, end); });
+        g.wait_for_all(sums, slots);
+        mapped.push_back(sums);
+    }
+    else if (tiles->enabled()) {
+        tiles->prepare_grids();
+        const unsigned mapTiles = g.add_task("map_particles_to_tiles", tiles->number_of_tiles(), 1,
+            [=](const unsigned& begin, const unsigned& end) { tiles->map_tiles(particles, begin, end); });
+        g.wait_for_all(mapTiles, shape);
+        g.wait_for_all(mapTiles, bMatrix);
+        mapped.push_back(mapTiles);
+    }
+    else {
+        const unsigned mass = particle_task("map_mass_to_nodes", &mpm::Particle::map_mass_to_nodes);
+        const unsigned momentum = particle_task("map_momentum_to_nodes", &mpm::Particle::map_momentum_to_nodes);
+        const unsigned bodyForce = particle_task("assign_body_force_to_nodes", &mpm::Particle::assign_body_force_to_nodes);
+        const unsigned intForce = particle_task("assign_internal_force_to_nodes", &mpm::Particle::assign_internal_force_to_nodes);
+        for (const auto& task : {mass, momentum, bodyForce, intForce}) {
+            g.wait_for_chunk(task, shape);
+            mapped.push_back(task);
+        }
+        g.wait_for_chunk(intForce, bMatrix);
+    }
+    if (!ordered->enabled()) {
+        volume = particle_task("map_volume_to_nodes", &mpm::Particle::map_volume_to_nodes);
+        g.wait_for_chunk(volume, shape);
+    }
+
+    // nodes: the range of ids of the nodes of particles, then constraints
+    const unsigned firstNode = mesh->p_nodes_.empty() ? 0 : mesh->p_nodes_.front()->give_id();
+    const unsigned numNodes = mesh->p_nodes_.empty() ? 0 : mesh->p_nodes_.back()->give_id() + 1 - firstNode;
+    const unsigned solve = g.add_task("solve_nodal_velocity_and_acceleration", numNodes, nodeChunk,
+        [=](const unsigned& begin, const unsigned& end) { mesh->node_data_.solve_velocity_and_acceleration(dt, firstNode + begin, firstNode + end); });
+    for (const auto& task : mapped)
+        g.wait_for_all(solve, task);
+    const unsigned constraints = g.add_task("apply_constraints", [=]() {
+        mesh->apply_friction_constraints(dt);
+        mesh->apply_acceleration_constraints();
+        mesh->apply_velocity_constraints();
+    });
+    g.wait_for_all(constraints, solve);
+
+    // strain rates
+    const unsigned strainRate = particle_task("compute_strain_rate", &mpm::Particle::compute_strain_rate);
+    g.wait_for_all(strainRate, constraints);
+    g.wait_for_chunk(strainRate, bMatrix);
+    const unsigned centreRate = particle_task("compute_centre_strain_rate", &mpm::Particle::compute_centre_strain_rate);
+    g.wait_for_all(centreRate, constraints);
+    g.wait_for_chunk(centreRate, bCentre);
+    const unsigned bBarRate = particle_task("compute_BBar_strain_rate", &mpm::Particle::compute_BBar_strain_rate);
+    g.wait_for_all(bBarRate, constraints);
+    g.wait_for_chunk(bBarRate, bBar);
+    unsigned nodalRate;
+    if (ordered->enabled()) {
+        const unsigned slots = g.add_task("map_volume_and_strain_rate_to_node_slots", numParticles, particleChunk,
+            [=](const unsigned& begin, const unsigned& end) { ordered->map_volume_and_strain_rate_to_slots(particles, begin, end); });
+        g.wait_for_chunk(slots, strainRate);
+        nodalRate = g.add_task("add_volume_and_strain_rate_node_slots", ordered->number_of_nodes(), nodeChunk,
+            [=](const unsigned& begin, const unsigned& end) { ordered->add_volume_and_strain_rate_slots_to_nodes(begin, end); });
+        g.wait_for_all(nodalRate, slots);
+        volume = slots;
+    }
+    else {
+        nodalRate = particle_task("map_volumetric_strain_rate_to_nodes", &mpm::Particle::map_volumetric_strain_rate_to_nodes);
+        g.wait_for_chunk(nodalRate, strainRate);
+    }
+    const unsigned centreVolRate = particle_task("compute_centre_vol_strain_rate_from_nodes", &mpm::Particle::compute_centre_vol_strain_rate_from_nodes);
+    g.wait_for_all(centreVolRate, nodalRate);
+
+    // strain and stress
+    const unsigned strain = particle_dt_task("compute_strain", &mpm::Particle::compute_strain);
+    g.wait_for_chunk(strain, bBarRate);
+    const unsigned stress = g.add_task("compute_stress", numParticles, particleChunk,
+        [=](const unsigned& begin, const unsigned& end) { particles->compute_stress(begin, end, dt); });
+    g.wait_for_chunk(stress, bBarRate);
+    g.wait_for_chunk(stress, centreVolRate);
+
+    // update of the particles
+    unsigned velocity, position;
+    if (tiles->enabled()) {
+        velocity = g.add_task("update_particles_from_tiles", tiles->number_of_tiles(), 1,
+            [=](const unsigned& begin, const unsigned& end) { tiles->update_tiles(particles, begin, end, dt); });
+        g.wait_for_all(velocity, constraints);
+        position = velocity;
+    }
+    else {
+        velocity = particle_dt_task("update_velocity", &mpm::Particle::update_velocity);
+        g.wait_for_all(velocity, constraints);
+        position = particle_dt_task("update_position", &mpm::Particle::update_position);
+        g.wait_for_all(position, constraints);
+    }
+    const unsigned density = particle_dt_task("update_density", &mpm::Particle::update_density);
+    g.wait_for_chunk(density, centreVolRate);
+    g.wait_for_chunk(density, volume);
+}
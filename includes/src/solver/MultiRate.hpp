@@ -0,0 +1,216 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Multi-rate time integration (multiRateLevels). A stiff material
+      (e.g. an ILE block, or a fluid of high viscosity) needs a time
+      step much smaller than the others. Instead of the smallest time
+      step for all particles, the materials are grouped in levels: the
+      particles of level L advance by dt / 2^L, so a step of dt is done
+      in 2^maxLevel substeps, and the interval of level L spans
+      2^(maxLevel - L) substeps. At the start of each step a material takes the
+      lowest level whose time step is below courantNumber times its
+      stable time step, the smaller of the acoustic limit s / (c + U)
+      and the viscous limit rho s^2 / (2 mu) (s the particle spacing, c
+      the wave speed of the material, U the peak speed of its particles
+      and mu its largest apparent viscosity, e.g. viscosity + m *
+      yieldStress for ModifiedBingham at rest).
+      The levels meet at the nodes, which are solved in every substep.
+      A level maps its mass, momentum and forces to nodal fields of its
+      own at the start of its interval and sums the nodal accelerations
+      of the substeps; its momentum at a node is then p_L + m_L sum a h,
+      h the substep, i.e. it takes its share of the total force at the
+      node in each substep. The nodes of a substep are the sum over the
+      levels. At the end of its interval the particles of a level are
+      updated with the nodal velocity and with the mean of the nodal
+      accelerations over the interval, so a coarse level next to a stiff
+      one gets the mean of the stiff forces, not their value at one
+      instant, and the momentum is conserved. The volume and the
+      volumetric strain rate, which smooth the pressure, are kept by
+      level in the same way, from the last update of each level.
+      With one level (all materials stable at dt) the step is the same
+      as without multiRateLevels (the same bits with one thread; with
+      more, the nodal sums may be added in another order).
+      The work is counted in passes over a particle or a node against
+      the single-rate step, where all particles advance by the smallest
+      time step: the particle updates (one particle advanced by one time
+      step of its level), and the passes done in every substep for all
+      levels, locating all particles and solving the nodes of all levels.
+      Only the particle updates are saved; the other passes are counted
+      in both, at the same cost as an update, so the saving reported is
+      below that of the particle updates alone.
+
+FILE: MultiRate.hpp
+**************************************************************************/
+#ifndef MPM_MULTIRATE_H
+#define MPM_MULTIRATE_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// mpm miscellaneous header files
+#include "PropertyParse.hpp"
+
+// mpm main header files
+#include "MpmParticle.hpp"
+#include "NodeData.hpp"
+#include "Particle.hpp"
+#include "MaterialBase.hpp"
+
+namespace mpm {
+    class MultiRate;
+}
+
+class mpm::MultiRate {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+
+    typedef mpm::material::MaterialBase* MaterialBasePtr;
+
+    // the materials of a level, its nodal fields at the start of its
+    // interval (the acceleration the sum over the substeps since) and
+    // the range of ids of its nodes
+    struct Level {
+        Level() : nodes(true), nodeBegin(0), nodeEnd(0), numParticles(0) { }
+        std::vector<unsigned> materials;
+        mpm::NodeData nodes;
+        unsigned nodeBegin;
+        unsigned nodeEnd;
+        unsigned numParticles;
+    };
+
+public:
+    // constructor; with multiRateLevels below 2 the mode is disabled
+    MultiRate(const mpm::misc::Settings& settings);
+
+    // give status of the mode
+    bool enabled() const {
+        return enabled_;
+    }
+
+    // group the materials in levels for a step of dt
+    void assign_levels(mpm::MpmParticle* particles, const double& dt);
+
+    // give number of levels and of substeps of the step
+    unsigned number_of_levels() const {
+        return maxLevel_ + 1;
+    }
+    unsigned number_of_substeps() const {
+        return 1u << maxLevel_;
+    }
+
+    // give whether an interval of a level starts at a substep (and the
+    // last one ends before it)
+    bool is_active(const unsigned& level, const unsigned& substep) const {
+        return substep % (1u << (maxLevel_ - level)) == 0;
+    }
+
+    // give the materials of a level
+    const std::vector<unsigned>& materials_of_level(const unsigned& level) const {
+        return levels_[level].materials;
+    }
+
+    // give the range [begin, end) of ids of the nodes of a level
+    void node_range(const unsigned& level, unsigned& begin, unsigned& end) const {
+        begin = levels_[level].nodeBegin;
+        end = levels_[level].nodeEnd;
+    }
+
+    // give the range [begin, end) of ids of the nodes of all levels
+    void node_range(unsigned& begin, unsigned& end) const;
+
+    // map mass, momentum and forces of the particles of a level to its
+    // nodal fields at the start of its interval
+    void map_level(mpm::MpmParticle* particles, const mpm::NodeData& nodes, const unsigned& level);
+
+    // map volume and volumetric strain rate of the particles of a level
+    // (after map_level) to its nodal fields
+    void map_level_volume(mpm::MpmParticle* particles, const unsigned& level);
+
+    // set mass, momentum and forces of the nodes [begin, end) to the sum
+    // over the levels, with substeps of dt
+    void sum_levels(mpm::NodeData& nodes, const double& dt, const unsigned& begin, const unsigned& end) const;
+
+    // add the nodal accelerations of a substep to the sums of the levels
+    void add_accelerations(const mpm::NodeData& nodes);
+
+    // set the acceleration of the nodes of a level to its mean over the
+    // interval of the level
+    void set_mean_acceleration(mpm::NodeData& nodes, const unsigned& level) const;
+
+    // set volume and volumetric strain rate of the nodes [begin, end) to
+    // the sum over the levels
+    void sum_level_volumes(mpm::NodeData& nodes, const unsigned& begin, const unsigned& end) const;
+
+    // give number of particles of a level in the last step
+    unsigned number_of_particles(const unsigned& level) const {
+        return levels_[level].numParticles;
+    }
+
+    // give particle updates of the run and of single-rate steps with the
+    // time step of the finest level
+    double particle_updates() const {
+        return particleUpdates_;
+    }
+    double single_rate_updates() const {
+        return singleRateUpdates_;
+    }
+
+    // count the passes of a substep over all levels: the particles
+    // located and the nodes solved
+    void count_substep(const unsigned& numParticles, const unsigned& numNodes) {
+        particleLocations_ += numParticles;
+        nodeSolves_ += numNodes;
+    }
+
+    // give particles located and nodes solved in the substeps of the run
+    double particle_locations() const {
+        return particleLocations_;
+    }
+    double node_solves() const {
+        return nodeSolves_;
+    }
+
+    // give the fraction of the work saved: particle updates, particle
+    // locations and node solves, against single-rate steps which locate
+    // and solve as many
+    double work_saved() const {
+        const double substepPasses = particleLocations_ + nodeSolves_;
+        const double singleRate = singleRateUpdates_ + substepPasses;
+        return (singleRate > 0.) ? 1. - (particleUpdates_ + substepPasses) / singleRate : 0.;
+    }
+
+    // give the largest number of levels used in a step
+    unsigned max_levels_used() const {
+        return maxLevelsUsed_;
+    }
+
+protected:
+    bool enabled_;
+    unsigned numLevels_;
+    double courantNumber_;
+    unsigned maxLevel_;
+    std::vector<Level> levels_;
+
+    double particleUpdates_;
+    double singleRateUpdates_;
+    double particleLocations_;
+    double nodeSolves_;
+    unsigned maxLevelsUsed_;
+    bool warned_;
+};
+
+#include "MultiRate.ipp"
+
+#endif
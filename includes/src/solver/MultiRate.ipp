@@ -0,0 +1,243 @@
+
+mpm::MultiRate::MultiRate(const mpm::misc::Settings& settings)
+    : enabled_(settings.multiRateLevels > 1), numLevels_(std::max(1u, settings.multiRateLevels)),
+      courantNumber_(settings.courantNumber), maxLevel_(0), levels_(numLevels_),
+      particleUpdates_(0.), singleRateUpdates_(0.), particleLocations_(0.), nodeSolves_(0.), maxLevelsUsed_(1), warned_(false) {
+    if (!enabled_)
+        return;
+    if (numLevels_ > 16) {
+        std::cerr << "ERROR: multiRateLevels is at most 16" << "\n";
+        abort();
+    }
+    if (settings.quasiStatic || settings.tileSize || settings.deterministic || settings.taskGraph) {
+        std::cerr << "ERROR: multiRateLevels can not be used with quasiStaticFlag, tileSize, deterministicFlag or taskGraphFlag" << "\n";
+        abort();
+    }
+    if (courantNumber_ <= 0.) {
+        std::cerr << "ERROR: multiRateLevels needs courantNumber > 0" << "\n";
+        abort();
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: ASSIGN_LEVELS
+          The level of a material is the lowest L with dt / 2^L below
+          courantNumber times its stable time step, up to
+          multiRateLevels - 1 (with a warning when that is not enough).
+          Materials without particles are left out. The particle
+          updates of the step are counted here.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MultiRate::assign_levels(mpm::MpmParticle* particles, const double& dt) {
+    const double spacing = particles->give_spacing().minCoeff();
+    for (auto& level : levels_) {
+        level.materials.clear();
+        level.numParticles = 0;
+    }
+    maxLevel_ = 0;
+    unsigned numParticles = 0;
+
+    const unsigned numMaterials = particles->number_of_materials();
+    for (unsigned m = 0; m < numMaterials; m++) {
+        unsigned begin, end;
+        particles->material_range(m, begin, end);
+        if (begin == end)
+            continue;
+        double peakSquared = 0.;
+        for (unsigned i = begin; i < end; i++)
+            peakSquared = std::max(peakSquared, particles->pointer_to_particle(i)->give_velocity().squaredNorm());
+
+        MaterialBasePtr material = particles->give_material(m);
+        const double density = material->giveDensity();
+        const double waveSpeed = std::sqrt(material->giveWaveModulus() / density);
+        double stable = spacing / (waveSpeed + std::sqrt(peakSquared));
+        const double viscosity = material->giveMaxViscosity();
+        if (viscosity > 0.)
+            stable = std::min(stable, density * spacing * spacing / (2. * viscosity));
+
+        const double ratio = dt / (courantNumber_ * stable);
+        unsigned level = 0;
+        while (level + 1 < numLevels_ && ratio > double(1u << level))
+            level++;
+        if (ratio > double(1u << level) && !warned_) {
+            std::cerr << "WARNING: dt / " << (1u << level) << " is above the stable time step of material " << m << " (multiRateLevels " << numLevels_ << ")" << "\n";
+            warned_ = true;
+        }
+        levels_[level].materials.push_back(m);
+        levels_[level].numParticles += end - begin;
+        maxLevel_ = std::max(maxLevel_, level);
+        numParticles += end - begin;
+    }
+
+    for (unsigned l = 0; l <= maxLevel_; l++)
+        particleUpdates_ += double(levels_[l].numParticles) * (1u << l);
+    singleRateUpdates_ += double(numParticles) * (1u << maxLevel_);
+    maxLevelsUsed_ = std::max(maxLevelsUsed_, maxLevel_ + 1);
+}
+
+
+void mpm::MultiRate::node_range(unsigned& begin, unsigned& end) const {
+    begin = end = 0;
+    for (unsigned l = 0; l <= maxLevel_; l++) {
+        const Level& data = levels_[l];
+        if (data.materials.empty() || data.nodeBegin >= data.nodeEnd)
+            continue;
+        begin = (begin < end) ? std::min(begin, data.nodeBegin) : data.nodeBegin;
+        end = std::max(end, data.nodeEnd);
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: MAP_LEVEL
+          The fields of the level are cleared over the nodes of its last
+          interval, the range of its nodes is found from the elements of
+          its particles, and the particles are mapped to the fields of
+          the level with the node ids of the mesh. The sum of the
+          accelerations starts at zero.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MultiRate::map_level(mpm::MpmParticle* particles, const mpm::NodeData& nodes, const unsigned& level) {
+    Level& data = levels_[level];
+    mpm::NodeData& grid = data.nodes;
+    if (grid.size() != nodes.size()) {
+        grid.resize(nodes.size());
+        data.nodeBegin = data.nodeEnd = 0;
+    }
+    for (unsigned i = data.nodeBegin; i < data.nodeEnd; i++) {
+        grid.mass[i] = 0.;
+        for (unsigned d = 0; d < dim; d++) {
+            grid.momentum[d][i] = 0.;
+            grid.extForce[d][i] = 0.;
+            grid.intForce[d][i] = 0.;
+            grid.acceleration[d][i] = 0.;
+        }
+    }
+
+    const unsigned lastOffset = *std::max_element(nodes.layout->nodeOffsets.begin(), nodes.layout->nodeOffsets.end());
+    unsigned nodeBegin = nodes.size();
+    unsigned nodeEnd = 0;
+    for (const auto& m : data.materials) {
+        unsigned begin, end;
+        particles->material_range(m, begin, end);
+        for (unsigned i = begin; i < end; i++) {
+            const unsigned first = nodes.first_node(particles->pointer_to_particle(i)->give_element());
+            nodeBegin = std::min(nodeBegin, first);
+            nodeEnd = std::max(nodeEnd, first + lastOffset + 1);
+        }
+        particles->iterate_over_particles(begin, end, [&grid](mpm::Particle* particle) {
+            const mpm::Particle::NodeIds ids = particle->give_node_ids();
+            particle->map_mass_to_grid(grid, ids);
+            particle->map_momentum_to_grid(grid, ids);
+            particle->assign_body_force_to_grid(grid, ids);
+            particle->assign_internal_force_to_grid(grid, ids);
+        });
+    }
+    data.nodeBegin = std::min(nodeBegin, nodeEnd);
+    data.nodeEnd = nodeEnd;
+}
+
+
+void mpm::MultiRate::map_level_volume(mpm::MpmParticle* particles, const unsigned& level) {
+    Level& data = levels_[level];
+    mpm::NodeData& grid = data.nodes;
+    std::fill(grid.volume.begin() + data.nodeBegin, grid.volume.begin() + data.nodeEnd, 0.);
+    std::fill(grid.volStrainRate.begin() + data.nodeBegin, grid.volStrainRate.begin() + data.nodeEnd, 0.);
+    for (const auto& m : data.materials) {
+        unsigned begin, end;
+        particles->material_range(m, begin, end);
+        particles->iterate_over_particles(begin, end, [&grid](mpm::Particle* particle) {
+            const mpm::Particle::NodeIds ids = particle->give_node_ids();
+            particle->map_volume_to_grid(grid, ids);
+            particle->map_volumetric_strain_rate_to_grid(grid, ids);
+        });
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SUM_LEVELS
+          m = sum m_L, f = sum f_L and p = sum (p_L + m_L sum a dt), the
+          last sum over the substeps of the interval of level L so far
+          (none at its start). The sums start from zero, so with one
+          level the nodes get the values of the level.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::MultiRate::sum_levels(mpm::NodeData& nodes, const double& dt, const unsigned& begin, const unsigned& end) const {
+    std::fill(nodes.mass.begin() + begin, nodes.mass.begin() + end, 0.);
+    for (unsigned d = 0; d < dim; d++) {
+        std::fill(nodes.momentum[d].begin() + begin, nodes.momentum[d].begin() + end, 0.);
+        std::fill(nodes.extForce[d].begin() + begin, nodes.extForce[d].begin() + end, 0.);
+        std::fill(nodes.intForce[d].begin() + begin, nodes.intForce[d].begin() + end, 0.);
+    }
+    for (unsigned l = 0; l <= maxLevel_; l++) {
+        const Level& data = levels_[l];
+        if (data.materials.empty())
+            continue;
+        const unsigned first = std::max(begin, data.nodeBegin);
+        const unsigned last = std::min(end, data.nodeEnd);
+        const double* m = data.nodes.mass.data();
+#pragma omp parallel for schedule(static)
+        for (unsigned i = first; i < last; i++)
+            nodes.mass[i] += m[i];
+        for (unsigned d = 0; d < dim; d++) {
+            const double* p = data.nodes.momentum[d].data();
+            const double* fExt = data.nodes.extForce[d].data();
+            const double* fInt = data.nodes.intForce[d].data();
+            const double* a = data.nodes.acceleration[d].data();
+#pragma omp parallel for schedule(static)
+            for (unsigned i = first; i < last; i++) {
+                nodes.momentum[d][i] += p[i] + m[i] * a[i] * dt;
+                nodes.extForce[d][i] += fExt[i];
+                nodes.intForce[d][i] += fInt[i];
+            }
+        }
+    }
+}
+
+
+void mpm::MultiRate::add_accelerations(const mpm::NodeData& nodes) {
+    for (unsigned l = 0; l <= maxLevel_; l++) {
+        Level& data = levels_[l];
+        if (data.materials.empty())
+            continue;
+        for (unsigned d = 0; d < dim; d++) {
+            const double* a = nodes.acceleration[d].data();
+            double* sum = data.nodes.acceleration[d].data();
+#pragma omp parallel for schedule(static)
+            for (unsigned i = data.nodeBegin; i < data.nodeEnd; i++)
+                sum[i] += a[i];
+        }
+    }
+}
+
+
+// the interval of level L has 2^(maxLevel - L) substeps; the division by
+// a power of two is exact, so with one substep the acceleration is kept
+void mpm::MultiRate::set_mean_acceleration(mpm::NodeData& nodes, const unsigned& level) const {
+    const Level& data = levels_[level];
+    const double numSubsteps = double(1u << (maxLevel_ - level));
+    for (unsigned d = 0; d < dim; d++) {
+        const double* sum = data.nodes.acceleration[d].data();
+        double* a = nodes.acceleration[d].data();
+#pragma omp parallel for schedule(static)
+        for (unsigned i = data.nodeBegin; i < data.nodeEnd; i++)
+            a[i] = sum[i] / numSubsteps;
+    }
+}
+
+
+void mpm::MultiRate::sum_level_volumes(mpm::NodeData& nodes, const unsigned& begin, const unsigned& end) const {
+    std::fill(nodes.volume.begin() + begin, nodes.volume.begin() + end, 0.);
+    std::fill(nodes.volStrainRate.begin() + begin, nodes.volStrainRate.begin() + end, 0.);
+    for (unsigned l = 0; l <= maxLevel_; l++) {
+        const Level& data = levels_[l];
+        if (data.materials.empty())
+            continue;
+        const unsigned first = std::max(begin, data.nodeBegin);
+        const unsigned last = std::min(end, data.nodeEnd);
+#pragma omp parallel for schedule(static)
+        for (unsigned i = first; i < last; i++) {
+            nodes.volume[i] += data.nodes.volume[i];
+            nodes.volStrainRate[i] += data.nodes.volStrainRate[i];
+        }
+    }
+}
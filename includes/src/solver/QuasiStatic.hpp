@@ -0,0 +1,139 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Dynamic relaxation of a quasi-static problem (e.g. compressionTest,
+      tensionTest). The velocity constraints of numOfSteps * dt are
+      applied in numOfLoadSteps load steps: the first iteration of a load
+      step moves the constrained nodes by the increment of the load step,
+      and the following iterations hold them while the explicit step,
+      with damping, relaxes the particles to equilibrium. The time step is
+      then a pseudo time step of the relaxation.
+      Damping:
+        - local (non-viscous): a force -alpha |f| sign(v) at each nodal
+          degree of freedom, alpha = localDamping;
+        - kinetic: the velocities of the particles are set to zero when
+          the kinetic energy has passed a peak.
+      With massScaling > 1 the inertia of a particle (not its weight) is
+      scaled so that dt is half the time a pressure wave takes to cross
+      an element, up to massScaling times. Only the particles for which
+      dt is too large are scaled.
+      A load step is done when the force residual, |f| over the free
+      degrees of freedom relative to the nodal forces (reactions
+      included), is below residualTolerance, and the kinetic energy of
+      the nodes, which is all artificial in a quasi-static problem, is
+      below kineticEnergyRatio times the strain energy of the particles.
+      The particles start each load step at rest.
+
+FILE: QuasiStatic.hpp
+**************************************************************************/
+#ifndef MPM_QUASISTATIC_H
+#define MPM_QUASISTATIC_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+// mpm miscellaneous header files
+#include "PropertyParse.hpp"
+
+// mpm main header files
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "NodeData.hpp"
+#include "Particle.hpp"
+
+namespace mpm {
+    class QuasiStatic;
+}
+
+class mpm::QuasiStatic {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+
+public:
+    // constructor; without quasiStaticFlag the mode is disabled
+    QuasiStatic(const mpm::misc::Settings& settings);
+
+    // give status of the mode
+    bool enabled() const {
+        return enabled_;
+    }
+
+    // start a load step: the first iteration applies its increment of
+    // the velocity constraints
+    void begin_load_step(mpm::Mesh* mesh, mpm::MpmParticle* particles);
+
+    // scale the inertia and damp the nodal accelerations, after the
+    // nodal solve and before the constraints
+    void relax_nodes(mpm::Mesh* mesh, mpm::MpmParticle* particles, const double& dt);
+
+    // record the state after an iteration and give whether the load
+    // step is done
+    bool update(mpm::Mesh* mesh, mpm::MpmParticle* particles, const double& dt);
+
+    // give whether the last load step is done
+    bool converged() const {
+        return converged_;
+    }
+
+    // give the force residual and the ratio of the kinetic energy to the
+    // strain energy after the last iteration
+    double residual() const {
+        return residual_;
+    }
+    double energy_ratio() const {
+        return (strainEnergy_ > 0.) ? kineticEnergy_ / strainEnergy_ : 0.;
+    }
+
+    // give number of iterations of the load step and number of load steps
+    unsigned number_of_iterations() const {
+        return iterations_;
+    }
+    unsigned number_of_load_steps() const {
+        return loadSteps_;
+    }
+
+    // give the largest scale of the inertia of a particle
+    double mass_scale() const {
+        return maxScale_;
+    }
+
+protected:
+    // give the scale of the inertia of a particle for a stable dt
+    double stable_scale(const mpm::Particle* particle, const mpm::NodeData& nodes, const double& dt) const;
+
+    // map the scaled inertia of the particles to the nodes
+    void map_inertia(const mpm::NodeData& nodes, mpm::MpmParticle* particles, const double& dt);
+
+protected:
+    bool enabled_;
+    bool kineticDamping_;
+    double localDamping_;
+    double residualTolerance_;
+    double massScaling_;
+    double kineticEnergyRatio_;
+    // velocity constraints of a dynamic step applied in the first
+    // iteration of a load step
+    double loadIncrement_;
+    // scaled nodal inertia
+    mpm::NodeData::Field inertia_;
+
+    double kineticEnergy_;
+    double strainEnergy_;
+    double residual_;
+    double maxScale_;
+    unsigned iterations_;
+    unsigned loadSteps_;
+    bool converged_;
+};
+
+#include "QuasiStatic.ipp"
+
+#endif
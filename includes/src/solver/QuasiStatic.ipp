@@ -0,0 +1,167 @@
+
+mpm::QuasiStatic::QuasiStatic(const mpm::misc::Settings& settings)
+    : enabled_(settings.quasiStatic), kineticDamping_(false), localDamping_(0.),
+      residualTolerance_(settings.residualTolerance), massScaling_(std::max(1., settings.massScaling)),
+      kineticEnergyRatio_(settings.kineticEnergyRatio), loadIncrement_(0.),
+      kineticEnergy_(0.), strainEnergy_(0.), residual_(0.), maxScale_(1.),
+      iterations_(0), loadSteps_(0), converged_(false) {
+    if (!enabled_)
+        return;
+    if (settings.dampingType == "kinetic")
+        kineticDamping_ = true;
+    else if (settings.dampingType == "local")
+        localDamping_ = settings.localDamping;
+    else {
+        std::cerr << "ERROR: unknown dampingType " << settings.dampingType << " (local or kinetic)" << "\n";
+        abort();
+    }
+    if (!settings.numOfLoadSteps) {
+        std::cerr << "ERROR: the quasi-static mode needs numOfLoadSteps" << "\n";
+        abort();
+    }
+    loadIncrement_ = double(settings.numOfTotalSteps) / settings.numOfLoadSteps;
+}
+
+
+void mpm::QuasiStatic::begin_load_step(mpm::Mesh* mesh, mpm::MpmParticle* particles) {
+    mesh->set_velocity_constraint_scale(loadIncrement_);
+    // the particles start a load step at rest
+    const unsigned numParticles = particles->number_of_particles();
+    for (unsigned p = 0; p < numParticles; p++)
+        particles->pointer_to_particle(p)->set_velocity(Eigen::Matrix<double, 1, dim>::Zero());
+    kineticEnergy_ = 0.;
+    iterations_ = 0;
+    converged_ = false;
+    loadSteps_++;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: RELAX_NODES
+          The nodal solve gave a = f / m and v = p / m + dt a. The
+          acceleration is recomputed with the scaled inertia in place of
+          the mass and damped against the velocity before the step,
+          p / m, and the velocity is updated again. Nodes without mass
+          keep a = 0.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::QuasiStatic::relax_nodes(mpm::Mesh* mesh, mpm::MpmParticle* particles, const double& dt) {
+    mpm::NodeData& nodes = mesh->node_data_;
+    const bool scaled = massScaling_ > 1.;
+    if (scaled)
+        this->map_inertia(nodes, particles, dt);
+
+    const unsigned numNodes = nodes.size();
+    const double* m = nodes.mass.data();
+    const double* inertia = inertia_.data();
+    for (unsigned d = 0; d < dim; d++) {
+        double* v = nodes.velocity[d].data();
+        double* a = nodes.acceleration[d].data();
+        for (unsigned i = 0; i < numNodes; i++) {
+            if (std::fabs(m[i]) <= 1.E-16)
+                continue;
+            double acc = a[i];
+            const double vel = v[i] - dt * acc;
+            if (scaled)
+                acc *= m[i] / inertia[i];
+            const double sign = (vel > 0.) ? 1. : ((vel < 0.) ? -1. : 0.);
+            acc -= localDamping_ * std::fabs(acc) * sign;
+            a[i] = acc;
+            v[i] = vel + dt * acc;
+        }
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: UPDATE
+          After the first iteration the constrained nodes are held. The
+          residual is taken over the free degrees of freedom (the
+          constraints set the acceleration of the others to zero). The
+          kinetic energy is that of the nodes, with the scaled inertia:
+          the velocities of the particles (FLIP) may keep components
+          which the grid does not see. With kinetic damping the
+          velocities of the particles are set to zero when the kinetic
+          energy drops, i.e. after a peak; the energy is checked before.
+          The first iteration warns when dt is not stable even with the
+          mass scaling, and a relaxation which lost all particles or
+          gives values which are not finite stops the run.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+bool mpm::QuasiStatic::update(mpm::Mesh* mesh, mpm::MpmParticle* particles, const double& dt) {
+    if (!iterations_)
+        mesh->set_velocity_constraint_scale(0.);
+    iterations_++;
+
+    const mpm::NodeData& nodes = mesh->node_data_;
+    const unsigned numNodes = nodes.size();
+    const double* inertia = (massScaling_ > 1.) ? inertia_.data() : nodes.mass.data();
+    double unbalanced = 0.;
+    double reference = 0.;
+    const double previousEnergy = kineticEnergy_;
+    kineticEnergy_ = 0.;
+    for (unsigned d = 0; d < dim; d++) {
+        const double* fExt = nodes.extForce[d].data();
+        const double* fInt = nodes.intForce[d].data();
+        const double* v = nodes.velocity[d].data();
+        const double* a = nodes.acceleration[d].data();
+        for (unsigned i = 0; i < numNodes; i++) {
+            const double force = fExt[i] + fInt[i];
+            if (a[i] != 0.)
+                unbalanced += force * force;
+            reference += fExt[i] * fExt[i] + fInt[i] * fInt[i];
+            kineticEnergy_ += 0.5 * inertia[i] * v[i] * v[i];
+        }
+    }
+    residual_ = (reference > 0.) ? std::sqrt(unbalanced / reference) : 0.;
+
+    strainEnergy_ = 0.;
+    double stableScale = 1.;
+    const unsigned numParticles = particles->number_of_particles();
+    for (unsigned p = 0; p < numParticles; p++) {
+        const mpm::Particle* particle = particles->pointer_to_particle(p);
+        strainEnergy_ += particle->give_strain_energy();
+        if (loadSteps_ == 1 && iterations_ == 1)
+            stableScale = std::max(stableScale, this->stable_scale(particle, nodes, dt));
+    }
+    if (stableScale > massScaling_)
+        std::cerr << "WARNING: dt is above the stable time step; a mass scale of " << stableScale << " is needed (massScaling " << massScaling_ << ")" << "\n";
+    if (!numParticles || !std::isfinite(reference + kineticEnergy_ + strainEnergy_)) {
+        std::cerr << "ERROR: the relaxation diverged in load step " << loadSteps_ << " (dt too large?)" << "\n";
+        abort();
+    }
+
+    converged_ = iterations_ > 1 && residual_ < residualTolerance_ && kineticEnergy_ <= kineticEnergyRatio_ * std::max(0., strainEnergy_);
+
+    if (kineticDamping_ && kineticEnergy_ < previousEnergy) {
+        for (unsigned p = 0; p < numParticles; p++)
+            particles->pointer_to_particle(p)->set_velocity(Eigen::Matrix<double, 1, dim>::Zero());
+        kineticEnergy_ = 0.;
+    }
+    return converged_;
+}
+
+
+double mpm::QuasiStatic::stable_scale(const mpm::Particle* particle, const mpm::NodeData& nodes, const double& dt) const {
+    const unsigned element = particle->give_element();
+    double length = nodes.layout->elementLength[0][element];
+    for (unsigned d = 1; d < dim; d++)
+        length = std::min(length, nodes.layout->elementLength[d][element]);
+    const double ratio = dt * particle->give_wave_speed() / (0.5 * length);
+    return std::max(1., ratio * ratio);
+}
+
+
+void mpm::QuasiStatic::map_inertia(const mpm::NodeData& nodes, mpm::MpmParticle* particles, const double& dt) {
+    inertia_.assign(nodes.size(), 0.);
+    double* inertia = inertia_.data();
+    const unsigned numParticles = particles->number_of_particles();
+    for (unsigned p = 0; p < numParticles; p++) {
+        const mpm::Particle* particle = particles->pointer_to_particle(p);
+        const double scale = std::min(massScaling_, this->stable_scale(particle, nodes, dt));
+        maxScale_ = std::max(maxScale_, scale);
+        const double scaledMass = scale * particle->give_mass();
+        const Eigen::Matrix<double, 1, numNodes> shape = particle->give_shape_functions();
+        const unsigned first = nodes.first_node(particle->give_element());
+        for (unsigned k = 0; k < numNodes; k++)
+            inertia[first + nodes.layout->nodeOffsets[k]] += scaledMass * shape(k);
+    }
+}
@@ -0,0 +1,201 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: A simulation owns all its configuration and state: its settings
+      (a copy of input.dat), mesh, particles, materials, sources, phase
+      timer and solver. Nothing is shared through globals, so several
+      simulations can run in one process, e.g. the cases of an ensemble
+      on different threads.
+      The input files of a case are read once into a CaseInput, which
+      is not changed afterwards: the simulations of an ensemble share it
+      and each builds its own particles from it, without reading the
+      files again. The topology of the mesh (coordinates, elements and
+      layout of the grid) is built once in the CaseInput and shared by
+      the meshes of all simulations; each mesh keeps only the state of
+      a step (nodal fields, nodes and elements of the particles,
+      constraints).
+      With steadyStateTolerance the state is checked by a SteadyState
+      monitor every steadyStateWindow steps; the application stops the
+      run when it is steady.
+      With quasiStaticFlag the case is solved in load steps by dynamic
+      relaxation (QuasiStatic): solve_load_step iterates until the load
+      step is in equilibrium.
+      With machNumber the bulk modulus of the weakly compressible fluids
+      and the time step follow the peak speed of the particles
+      (ArtificialCompressibility); the time step then changes during the
+      run.
+      With multiRateLevels the particles of the stiff materials are
+      advanced in substeps of the time step (MultiRate).
+      A simulation may change the settings of the case (e.g. its time
+      step) and the parameters of the materials ("overrides", applied
+      to every material).
+
+FILE: Simulation.hpp
+**************************************************************************/
+#ifndef MPM_SIMULATION_H
+#define MPM_SIMULATION_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <memory>
+
+// mpm miscellaneous header files
+#include "PropertyParse.hpp"
+#include "Timer.hpp"
+
+// mpm main header files
+#include "FileHandle.hpp"
+#include "MeshTopology.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "ParticleSource.hpp"
+#include "MaterialBase.hpp"
+#include "ReadMaterial.hpp"
+#include "MpmSolver.hpp"
+#include "SteadyState.hpp"
+#include "QuasiStatic.hpp"
+#include "ArtificialCompressibility.hpp"
+#include "MultiRate.hpp"
+
+namespace mpm {
+    struct CaseInput;
+    class Simulation;
+}
+
+
+//! The input files of a case, read to the end from the streams of a
+//! FileHandle, and its parameters of input.dat. The topology of the mesh
+//! is built from meshData.dat, node.dat and element.dat.
+struct mpm::CaseInput {
+    CaseInput(mpm::FileHandle& files);
+
+    mpm::misc::Settings settings;
+    std::shared_ptr<const mpm::MeshTopology> topology;
+    std::string velConstraints;
+    std::string fricConstraints;
+    std::string particles;
+    // empty without initStress.dat
+    std::string initStress;
+    std::string materials;
+    // empty without feedParticle.dat (no sources and sinks)
+    std::string feedParticles;
+};
+
+
+class mpm::Simulation {
+
+protected:
+    typedef mpm::Mesh*           MeshPtr;
+    typedef mpm::MpmParticle*    ParticleSetPtr;
+    typedef mpm::ParticleSource* ParticleSourcePtr;
+    typedef std::vector<mpm::material::MaterialBase*> MaterialVector;
+
+public:
+    // CONSTRUCTOR: a simulation of the case with its own settings and the
+    // parameters of the materials replaced by "overrides"
+    Simulation(const mpm::CaseInput& input, const mpm::misc::Settings& settings, const mpm::misc::PropertyList& overrides);
+
+    // CONSTRUCTOR: a simulation of the case as given in its files
+    Simulation(const mpm::CaseInput& input);
+
+    // DESTRUCTOR
+    ~Simulation();
+
+    // SOLVE ONE TIME STEP
+    void solve_one_step();
+
+    // SOLVE numOfSteps TIME STEPS
+    void advance(const unsigned& numOfSteps);
+
+    // SOLVE ONE LOAD STEP OF THE QUASI-STATIC MODE; GIVE WHETHER IT
+    // CONVERGED IN maxRelaxationSteps ITERATIONS
+    bool solve_load_step();
+
+    // GIVE THE DYNAMIC RELAXATION OF THE QUASI-STATIC MODE
+    const mpm::QuasiStatic& quasi_static() const {
+        return quasiStatic_;
+    }
+
+    // GIVE WHETHER THE STATE AFTER THE LAST STEP IS STEADY (ALWAYS FALSE
+    // WITHOUT steadyStateTolerance)
+    bool steady() const {
+        return steady_.converged();
+    }
+
+    // GIVE THE STEADY STATE MONITOR
+    const mpm::SteadyState& steady_state() const {
+        return steady_;
+    }
+
+    // GIVE THE ARTIFICIAL COMPRESSIBILITY OF THE FLUIDS
+    const mpm::ArtificialCompressibility& artificial_compressibility() const {
+        return compressibility_;
+    }
+
+    // GIVE THE LEVELS OF THE MULTI-RATE MODE
+    const mpm::MultiRate& multi_rate() const {
+        return multiRate_;
+    }
+
+    // GIVE NUMBER OF STEPS SOLVED
+    unsigned step() const {
+        return step_;
+    }
+
+    // GIVE TIME SOLVED
+    double time() const {
+        return time_;
+    }
+
+    // GIVE SETTINGS
+    const mpm::misc::Settings& settings() const {
+        return settings_;
+    }
+
+    // GIVE MESH, PARTICLES, SOURCES, TIMER AND SOLVER
+    MeshPtr mesh() {
+        return mesh_;
+    }
+    ParticleSetPtr particles() {
+        return particles_;
+    }
+    ParticleSourcePtr sources() {
+        return sources_;
+    }
+    mpm::misc::PhaseTimer& timer() {
+        return timer_;
+    }
+    mpm::MpmSolver& solver() {
+        return *solver_;
+    }
+
+private:
+    // not copied: a simulation owns its mesh and particles
+    Simulation(const Simulation&);
+    Simulation& operator=(const Simulation&);
+
+protected:
+    mpm::misc::Settings settings_;
+    mpm::misc::PhaseTimer timer_;
+    MeshPtr mesh_;
+    ParticleSetPtr particles_;
+    MaterialVector materials_;
+    ParticleSourcePtr sources_;
+    mpm::MpmSolver* solver_;
+    mpm::SteadyState steady_;
+    mpm::QuasiStatic quasiStatic_;
+    mpm::ArtificialCompressibility compressibility_;
+    mpm::MultiRate multiRate_;
+    unsigned step_;
+    double time_;
+};
+
+#include "Simulation.ipp"
+
+#endif
@@ -0,0 +1,133 @@
+
+mpm::CaseInput::CaseInput(mpm::FileHandle& files) : settings(files.settings) {
+    topology = std::make_shared<const mpm::MeshTopology>(files.meshDataStream, files.nodeStream, files.elementStream);
+
+    std::ostringstream velIn, fricIn, particlesIn, stressIn, materialsIn, feedIn;
+    velIn << files.velConstraintStream.rdbuf();
+    fricIn << files.fricConstraintStream.rdbuf();
+    particlesIn << files.particleStream.rdbuf();
+    if (files.iStressStream.is_open())
+        stressIn << files.iStressStream.rdbuf();
+    materialsIn << files.materialStream.rdbuf();
+    if (files.feedParticleStream.is_open())
+        feedIn << files.feedParticleStream.rdbuf();
+
+    velConstraints = velIn.str();
+    fricConstraints = fricIn.str();
+    particles = particlesIn.str();
+    initStress = stressIn.str();
+    materials = materialsIn.str();
+    feedParticles = feedIn.str();
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: CONSTRUCTOR
+          The particles, materials and sources are built from the input
+          of the case as incompressibleMPM reads them from the files; the
+          mesh is built on the topology of the case. The phase timer follows phaseTimerFlag and
+          chromeTraceFlag of the settings.
+          The initial stress is read from initStress.dat, or generated
+          (initialStress) once the densities of the materials are known.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+mpm::Simulation::Simulation(const mpm::CaseInput& input, const mpm::misc::Settings& settings, const mpm::misc::PropertyList& overrides)
+    : settings_(settings), steady_(settings.steadyStateTolerance, settings.steadyStateWindow), quasiStatic_(settings),
+      compressibility_(settings), multiRate_(settings), step_(0), time_(0.) {
+
+    timer_.enable(settings_.phaseTimer, settings_.chromeTrace);
+
+    std::istringstream velIn(input.velConstraints), fricIn(input.fricConstraints);
+    mesh_ = new mpm::Mesh(input.topology);
+    mesh_->read_general_constraints(velIn);
+    mesh_->read_friction_constraints(fricIn);
+
+    std::istringstream particlesIn(input.particles), stressIn(input.initStress), materialsIn(input.materials);
+    particles_ = new mpm::MpmParticle(settings_.gravity);
+    particles_->read_particles(particlesIn, stressIn);
+    mpm::material::ReadMaterial mat(materialsIn, overrides);
+    materials_ = mat.givePtrsToMaterials();
+    particles_->assign_material_to_particles(materials_);
+
+    // the generated initial stress replaces that of initStress.dat
+    if (settings_.initialStress == "hydrostatic" || settings_.initialStress == "geostatic") {
+        mpm::misc::ScopedTimer t(timer_, "initial_stress");
+        particles_->generate_initial_stress(settings_.initialStress == "geostatic", settings_.K0);
+    }
+    else if (settings_.initialStress != "file") {
+        std::cerr << "ERROR: unknown initialStress " << settings_.initialStress << " (file, hydrostatic or geostatic)" << "\n";
+        abort();
+    }
+
+    // the bulk modulus of the fluids and the time step from the Mach number
+    if (compressibility_.enabled())
+        settings_.dt = compressibility_.initialise(particles_, materials_);
+
+    sources_ = new mpm::ParticleSource();
+    if (!input.feedParticles.empty()) {
+        std::istringstream feedIn(input.feedParticles);
+        sources_->read_sources_and_sinks(feedIn);
+    }
+
+    solver_ = new mpm::MpmSolver(mesh_, particles_, settings_, timer_);
+    if (!sources_->empty())
+        solver_->set_particle_source(sources_);
+    if (quasiStatic_.enabled())
+        solver_->set_quasi_static(&quasiStatic_);
+    if (multiRate_.enabled())
+        solver_->set_multi_rate(&multiRate_);
+}
+
+
+mpm::Simulation::Simulation(const mpm::CaseInput& input)
+    : Simulation(input, input.settings, mpm::misc::PropertyList()) { }
+
+
+mpm::Simulation::~Simulation() {
+    delete solver_;
+    delete sources_;
+    delete mesh_;
+    delete particles_;
+    for (auto material : materials_)
+        delete material;
+}
+
+
+void mpm::Simulation::solve_one_step() {
+    solver_->solve_one_step(settings_.dt);
+    step_++;
+    time_ += settings_.dt;
+    if (steady_.enabled()) {
+        mpm::misc::ScopedTimer t(timer_, "steady_state_monitor");
+        steady_.update(mesh_, particles_);
+    }
+    if (compressibility_.enabled()) {
+        mpm::misc::ScopedTimer t(timer_, "artificial_compressibility");
+        settings_.dt = compressibility_.update(particles_, materials_);
+    }
+}
+
+
+void mpm::Simulation::advance(const unsigned& numOfSteps) {
+    for (unsigned i = 0; i < numOfSteps; i++)
+        this->solve_one_step();
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: SOLVE_LOAD_STEP
+          The first iteration applies the increment of the velocity
+          constraints, the next ones relax the particles with them held,
+          until the load step is in equilibrium or maxRelaxationSteps
+          iterations are done.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+bool mpm::Simulation::solve_load_step() {
+    quasiStatic_.begin_load_step(mesh_, particles_);
+    bool done = false;
+    while (!done) {
+        this->solve_one_step();
+        mpm::misc::ScopedTimer t(timer_, "quasi_static_monitor");
+        done = quasiStatic_.update(mesh_, particles_, settings_.dt) ||
+               quasiStatic_.number_of_iterations() >= settings_.maxRelaxationSteps;
+    }
+    return quasiStatic_.converged();
+}
@@ -0,0 +1,93 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Convergence monitor of a steady problem (e.g. lidDrivenCavity).
+      Every "window" steps two relative changes across the window are
+      computed:
+        - of the nodal velocity, |v(n) - v(n-window)| / |v(n)| over all
+          nodes (the velocities solved in step n, after the constraints),
+          and
+        - of the kinetic energy of the particles, sum 0.5 m |v|^2,
+          |E(n) - E(n-window)| / E(n).
+      The state is steady when both are below the tolerance. A single
+      step changes the velocity by O(dt), which is small long before the
+      flow is steady; across the window the change is that of the
+      window time, window * dt, so choose the window to span a time in
+      which a developing flow still changes (e.g. a fraction of the
+      viscous time L^2 / nu).
+
+FILE: SteadyState.hpp
+**************************************************************************/
+#ifndef MPM_STEADYSTATE_H
+#define MPM_STEADYSTATE_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+// mpm main header files
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "NodeData.hpp"
+
+namespace mpm {
+    class SteadyState;
+}
+
+class mpm::SteadyState {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+
+public:
+    // constructor; a tolerance of 0 disables the monitor
+    SteadyState(const double& tolerance, const unsigned& window);
+
+    // give status of the monitor
+    bool enabled() const {
+        return tolerance_ > 0.;
+    }
+
+    // record the state after a step and give whether it is steady
+    bool update(const mpm::Mesh* mesh, mpm::MpmParticle* particles);
+
+    // give whether the last step was steady
+    bool converged() const {
+        return converged_;
+    }
+
+    // give the relative changes of the nodal velocity and of the
+    // kinetic energy across the last window (infinite before the first)
+    double velocity_change() const {
+        return velocityChange_;
+    }
+    double energy_change() const {
+        return energyChange_;
+    }
+
+    // give number of steps recorded
+    unsigned number_of_steps() const {
+        return numSteps_;
+    }
+
+protected:
+    double tolerance_;
+    unsigned window_;
+    // nodal velocity and kinetic energy at the start of the window
+    std::array<mpm::NodeData::Field, dim> velocity_;
+    double energy_;
+    double velocityChange_;
+    double energyChange_;
+    unsigned numSteps_;
+    bool converged_;
+};
+
+#include "SteadyState.ipp"
+
+#endif
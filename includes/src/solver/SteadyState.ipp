@@ -0,0 +1,59 @@
+
+mpm::SteadyState::SteadyState(const double& tolerance, const unsigned& window)
+    : tolerance_(tolerance), window_(std::max(1u, window)), energy_(0.), velocityChange_(HUGE_VAL), energyChange_(HUGE_VAL), numSteps_(0), converged_(false) { }
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: UPDATE
+          The nodal fields are indexed by node id and the mesh does not
+          change, so the velocity of a node is compared with its copy at
+          the start of the window. Nodes without particles have zero
+          velocity. The first step only records the state; the state is
+          then checked (and recorded again) every "window" steps. A
+          velocity or an energy which stays zero has no change.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+bool mpm::SteadyState::update(const mpm::Mesh* mesh, mpm::MpmParticle* particles) {
+    numSteps_++;
+    const bool first = numSteps_ == 1;
+    if (!first && (numSteps_ - 1) % window_ != 0)
+        return converged_;
+
+    const mpm::NodeData& nodes = mesh->node_data_;
+    const unsigned numNodes = nodes.size();
+
+    double difference = 0.;
+    double norm = 0.;
+    for (unsigned i = 0; i < dim; i++) {
+        if (first)
+            velocity_[i].assign(numNodes, 0.);
+        const double* velocity = nodes.velocity[i].data();
+        double* previous = velocity_[i].data();
+        for (unsigned n = 0; n < numNodes; n++) {
+            const double change = velocity[n] - previous[n];
+            difference += change * change;
+            norm += velocity[n] * velocity[n];
+            previous[n] = velocity[n];
+        }
+    }
+
+    double energy = 0.;
+    const unsigned numParticles = particles->number_of_particles();
+    for (unsigned p = 0; p < numParticles; p++) {
+        const mpm::Particle* particle = particles->pointer_to_particle(p);
+        energy += 0.5 * particle->give_mass() * particle->give_velocity().squaredNorm();
+    }
+    const double energyDifference = std::fabs(energy - energy_);
+    energy_ = energy;
+    if (first)
+        return converged_ = false;
+
+    velocityChange_ = 0.;
+    if (difference > 0.)
+        velocityChange_ = (norm > 0.) ? std::sqrt(difference / norm) : HUGE_VAL;
+    energyChange_ = 0.;
+    if (energyDifference > 0.)
+        energyChange_ = (energy > 0.) ? energyDifference / energy : HUGE_VAL;
+
+    converged_ = velocityChange_ < tolerance_ && energyChange_ < tolerance_;
+    return converged_;
+}
@@ -0,0 +1,155 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: A step of the solver as a graph of tasks. A task is a stage over a
+      range of items (particles, nodes or tiles) [0, size), cut in chunks
+      of chunkSize items. A task waits for another task in one of two
+      ways:
+        - all chunks of the other task (a barrier, e.g. the nodes need
+          the contributions of all particles), or
+        - the same chunk of the other task (a stage which reads only the
+          particles its predecessor wrote, e.g. the B matrix of a
+          particle after its shape functions).
+      Tasks are added in an order which respects the dependencies (a task
+      waits only for tasks added before it). A chunk is ready when all
+      chunks it waits for are done. Each thread keeps a queue of ready
+      chunks: it takes the chunk added last to its own queue (the
+      successors of the chunk it just finished, whose particles are in
+      cache) and, when the queue is empty, steals the oldest chunk of
+      the queue of another thread. So independent stages and chunks
+      overlap, and threads wait only where a barrier is needed.
+      With one thread the tasks run in the order they were added, chunk
+      by chunk, which gives the same sums as the stages one after the
+      other.
+
+FILE: TaskGraph.hpp
+**************************************************************************/
+#ifndef MPM_TASKGRAPH_H
+#define MPM_TASKGRAPH_H
+
+// c++ header files
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// mpm miscellaneous header files
+#include "Timer.hpp"
+
+namespace mpm {
+    class TaskGraph;
+}
+
+class mpm::TaskGraph {
+
+public:
+    // kernel of a task, called for the items [begin, end) of a chunk
+    typedef std::function<void(const unsigned& begin, const unsigned& end)> Kernel;
+
+    // constructor
+    TaskGraph();
+
+    // remove all tasks
+    void clear();
+
+    // add a task over the items [0, size) in chunks of chunkSize items
+    // and give its id; "name" is a string literal (used by the timer)
+    unsigned add_task(const char* name, const unsigned& size, const unsigned& chunkSize, Kernel kernel);
+
+    // add a task of one chunk which does not work on a range of items
+    unsigned add_task(const char* name, std::function<void()> function);
+
+    // task waits for all chunks of task "before"
+    void wait_for_all(const unsigned& task, const unsigned& before);
+
+    // each chunk of task waits for the same chunk of task "before" (both
+    // tasks have the same size and chunk size)
+    void wait_for_chunk(const unsigned& task, const unsigned& before);
+
+    // run all tasks with the OpenMP threads; each chunk is timed under
+    // the name of its task
+    void execute(mpm::misc::PhaseTimer& timer);
+
+    // give number of tasks
+    unsigned number_of_tasks() const {
+        return tasks_.size();
+    }
+
+    // write the graph in Graphviz dot format: a box per task (with the
+    // number of chunks), solid edges for barriers and dashed edges for
+    // chunk to chunk dependencies
+    void write_dot(std::ostream& outFile) const;
+
+private:
+    struct Task {
+        const char* name;
+        unsigned size;
+        unsigned chunkSize;
+        unsigned numChunks;
+        // id of the first chunk of the task in the list of all chunks
+        unsigned firstChunk;
+        Kernel kernel;
+        // tasks which wait for all chunks / the same chunk of this task
+        std::vector<unsigned> allSuccessors;
+        std::vector<unsigned> chunkSuccessors;
+        // number of tasks this task waits for (each way)
+        unsigned numAllPredecessors;
+        unsigned numChunkPredecessors;
+    };
+
+    // ready chunks of one thread
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<unsigned> chunks;
+    };
+
+    // run the chunks in the order of the tasks, without a queue
+    void execute_in_order(mpm::misc::PhaseTimer& timer);
+
+    // run chunks until all are done (one OpenMP thread)
+    void work(const unsigned& thread, std::vector<WorkQueue>& queues, mpm::misc::PhaseTimer& timer);
+
+    // run one chunk and queue the chunks it makes ready
+    void run_chunk(const unsigned& chunk, const unsigned& thread, std::vector<WorkQueue>& queues, mpm::misc::PhaseTimer& timer);
+
+    // the chunk is done for one of its predecessors: queue it if it was
+    // the last one
+    void release(const unsigned& chunk, WorkQueue& queue);
+
+    // give the items [begin, end) of a chunk
+    void chunk_range(const unsigned& chunk, unsigned& begin, unsigned& end) const {
+        const Task& task = tasks_[chunkTask_[chunk]];
+        begin = (chunk - task.firstChunk) * task.chunkSize;
+        end = std::min(task.size, begin + task.chunkSize);
+    }
+
+    // take the newest chunk of the own queue, or the oldest of another
+    bool pop(WorkQueue& queue, unsigned& chunk);
+    bool steal(WorkQueue& queue, unsigned& chunk);
+
+protected:
+    std::vector<Task> tasks_;
+    // task of each chunk
+    std::vector<unsigned> chunkTask_;
+    // during execute: predecessors left for each chunk, chunks left for
+    // each task and chunks left in total
+    std::vector<std::atomic<unsigned> > chunkPending_;
+    std::vector<std::atomic<unsigned> > taskPending_;
+    std::atomic<unsigned> remaining_;
+};
+
+#include "TaskGraph.ipp"
+
+#endif
@@ -0,0 +1,205 @@
+
+mpm::TaskGraph::TaskGraph() : remaining_(0) { }
+
+
+void mpm::TaskGraph::clear() {
+    tasks_.clear();
+    chunkTask_.clear();
+}
+
+
+unsigned mpm::TaskGraph::add_task(const char* name, const unsigned& size, const unsigned& chunkSize, Kernel kernel) {
+    if (chunkSize == 0) {
+        std::cerr << "ERROR: task " << name << " has a chunk size of 0" << "\n";
+        abort();
+    }
+    Task task;
+    task.name = name;
+    task.size = size;
+    task.chunkSize = chunkSize;
+    // an empty task has one empty chunk, so its successors are released
+    task.numChunks = std::max(1u, (size + chunkSize - 1) / chunkSize);
+    task.firstChunk = chunkTask_.size();
+    task.kernel = kernel;
+    task.numAllPredecessors = 0;
+    task.numChunkPredecessors = 0;
+    const unsigned id = tasks_.size();
+    tasks_.push_back(task);
+    chunkTask_.insert(chunkTask_.end(), task.numChunks, id);
+    return id;
+}
+
+
+unsigned mpm::TaskGraph::add_task(const char* name, std::function<void()> function) {
+    return this->add_task(name, 1, 1, [function](const unsigned&, const unsigned&) { function(); });
+}
+
+
+void mpm::TaskGraph::wait_for_all(const unsigned& task, const unsigned& before) {
+    if (before >= task) {
+        std::cerr << "ERROR: task " << tasks_.at(task).name << " waits for a later task" << "\n";
+        abort();
+    }
+    tasks_.at(before).allSuccessors.push_back(task);
+    tasks_.at(task).numAllPredecessors++;
+}
+
+
+void mpm::TaskGraph::wait_for_chunk(const unsigned& task, const unsigned& before) {
+    if (before >= task) {
+        std::cerr << "ERROR: task " << tasks_.at(task).name << " waits for a later task" << "\n";
+        abort();
+    }
+    if (tasks_.at(task).size != tasks_.at(before).size || tasks_.at(task).chunkSize != tasks_.at(before).chunkSize) {
+        std::cerr << "ERROR: the chunks of task " << tasks_.at(task).name << " and " << tasks_.at(before).name << " differ" << "\n";
+        abort();
+    }
+    tasks_.at(before).chunkSuccessors.push_back(task);
+    tasks_.at(task).numChunkPredecessors++;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: EXECUTE
+          A chunk waits for one release per chunk dependency of its task
+          and one per barrier (given when the whole predecessor is done).
+          The chunks without predecessors are dealt to the queues of the
+          threads. Chunks are pushed in reverse order, so a thread takes
+          the chunks of a task in increasing order.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::TaskGraph::execute(mpm::misc::PhaseTimer& timer) {
+    unsigned numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+    if (numThreads == 1 || tasks_.empty()) {
+        this->execute_in_order(timer);
+        return;
+    }
+
+    std::vector<std::atomic<unsigned> >(chunkTask_.size()).swap(chunkPending_);
+    std::vector<std::atomic<unsigned> >(tasks_.size()).swap(taskPending_);
+    for (unsigned t = 0; t < tasks_.size(); t++) {
+        const Task& task = tasks_[t];
+        taskPending_[t] = task.numChunks;
+        for (unsigned c = 0; c < task.numChunks; c++)
+            chunkPending_[task.firstChunk + c] = task.numAllPredecessors + task.numChunkPredecessors;
+    }
+    remaining_ = chunkTask_.size();
+
+    std::vector<WorkQueue> queues(numThreads);
+    unsigned next = 0;
+    for (unsigned t = 0; t < tasks_.size(); t++) {
+        const Task& task = tasks_[t];
+        if (task.numAllPredecessors + task.numChunkPredecessors > 0)
+            continue;
+        for (unsigned c = 0; c < task.numChunks; c++)
+            queues[(next++) % numThreads].chunks.push_front(task.firstChunk + c);
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+    this->work(omp_get_thread_num(), queues, timer);
+#endif
+}
+
+
+void mpm::TaskGraph::execute_in_order(mpm::misc::PhaseTimer& timer) {
+    for (const auto& task : tasks_) {
+        mpm::misc::ScopedTimer t(timer, task.name);
+        for (unsigned c = 0; c < task.numChunks; c++) {
+            unsigned begin, end;
+            this->chunk_range(task.firstChunk + c, begin, end);
+            task.kernel(begin, end);
+        }
+    }
+}
+
+
+void mpm::TaskGraph::work(const unsigned& thread, std::vector<WorkQueue>& queues, mpm::misc::PhaseTimer& timer) {
+    const unsigned numThreads = queues.size();
+    unsigned chunk;
+    while (remaining_ > 0) {
+        bool found = this->pop(queues[thread], chunk);
+        for (unsigned i = 1; !found && i < numThreads; i++)
+            found = this->steal(queues[(thread + i) % numThreads], chunk);
+        if (found)
+            this->run_chunk(chunk, thread, queues, timer);
+        else
+            std::this_thread::yield();
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: RUN_CHUNK
+          The chunks made ready go to the queue of the thread which ran
+          the chunk. The count of chunks left is decreased last, so the
+          threads do not stop while a chunk is being queued.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::TaskGraph::run_chunk(const unsigned& chunk, const unsigned& thread, std::vector<WorkQueue>& queues, mpm::misc::PhaseTimer& timer) {
+    const unsigned id = chunkTask_[chunk];
+    const Task& task = tasks_[id];
+    unsigned begin, end;
+    this->chunk_range(chunk, begin, end);
+    { mpm::misc::ScopedTimer t(timer, task.name);
+      task.kernel(begin, end); }
+
+    WorkQueue& queue = queues[thread];
+    const unsigned c = chunk - task.firstChunk;
+    for (const auto& successor : task.chunkSuccessors)
+        this->release(tasks_[successor].firstChunk + c, queue);
+    if (--taskPending_[id] == 0) {
+        for (const auto& successor : task.allSuccessors) {
+            const Task& next = tasks_[successor];
+            for (unsigned k = next.numChunks; k-- > 0; )
+                this->release(next.firstChunk + k, queue);
+        }
+    }
+    remaining_--;
+}
+
+
+void mpm::TaskGraph::release(const unsigned& chunk, WorkQueue& queue) {
+    if (--chunkPending_[chunk] == 0) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.chunks.push_back(chunk);
+    }
+}
+
+
+bool mpm::TaskGraph::pop(WorkQueue& queue, unsigned& chunk) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty())
+        return false;
+    chunk = queue.chunks.back();
+    queue.chunks.pop_back();
+    return true;
+}
+
+
+bool mpm::TaskGraph::steal(WorkQueue& queue, unsigned& chunk) {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.chunks.empty())
+        return false;
+    chunk = queue.chunks.front();
+    queue.chunks.pop_front();
+    return true;
+}
+
+
+void mpm::TaskGraph::write_dot(std::ostream& outFile) const {
+    outFile << "digraph step {" << "\n";
+    outFile << "  node [shape=box];" << "\n";
+    for (unsigned t = 0; t < tasks_.size(); t++) {
+        outFile << "  t" << t << " [label=\"" << tasks_[t].name << "\\n" << tasks_[t].size << " items, ";
+        outFile << tasks_[t].numChunks << " chunks\"];" << "\n";
+    }
+    for (unsigned t = 0; t < tasks_.size(); t++) {
+        for (const auto& successor : tasks_[t].allSuccessors)
+            outFile << "  t" << t << " -> t" << successor << ";" << "\n";
+        for (const auto& successor : tasks_[t].chunkSuccessors)
+            outFile << "  t" << t << " -> t" << successor << " [style=dashed];" << "\n";
+    }
+    outFile << "}" << "\n";
+}
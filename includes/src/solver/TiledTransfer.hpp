@@ -0,0 +1,129 @@
+/*************************************************************************
+                        Material Point Method
+                       Author: Shyamini Kularathna
+                         University of Cambridge
+
+NOTE: Cache blocked transfer between particles and nodes. The elements
+      of the structured grid are grouped in square tiles of
+      tileSize x tileSize elements and the particles are binned by tile
+      (keeping their order inside a tile). The particles of one tile
+      map mass, momentum and forces to a small grid of the tile nodes,
+      which stays in cache, and the tile grid is added to the mesh once.
+      The update of the particles reads the velocity and acceleration
+      of the tile nodes in the same way. Tiles are processed in parallel
+      (one tile grid per thread); only the flush of the nodes on the
+      border of the tiles is atomic.
+
+FILE: TiledTransfer.hpp
+**************************************************************************/
+#ifndef MPM_TILEDTRANSFER_H
+#define MPM_TILEDTRANSFER_H
+
+// c++ header files
+#include <vector>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// mpm header files
+#include "Constants.hpp"
+#include "NodeData.hpp"
+#include "Mesh.hpp"
+#include "MpmParticle.hpp"
+#include "Particle.hpp"
+
+namespace mpm {
+    class TiledTransfer;
+}
+
+class mpm::TiledTransfer {
+
+protected:
+    static const unsigned dim = mpm::constants::DIM;
+    static const unsigned numNodes = mpm::constants::NUMNODES;
+
+    typedef mpm::Particle::NodeIds NodeIds;
+
+public:
+    // constructor; a tile size of 0 disables the tiled transfer
+    TiledTransfer(mpm::Mesh* mesh, const unsigned& tileSize);
+
+    // give status of the tiled transfer
+    bool enabled() const {
+        return tileSize_ > 0;
+    }
+
+    // bin the particles by tile (after the particles are located)
+    void bin_particles(mpm::MpmParticle* particles);
+
+    // map mass, momentum, body force and internal force to the nodes
+    void map_particles_to_nodes(mpm::MpmParticle* particles);
+
+    // update velocity and position of the particles from the nodes
+    void update_particles(mpm::MpmParticle* particles, const double& dt);
+
+    // give number of tiles
+    unsigned number_of_tiles() const {
+        return tilesX_ * tilesY_;
+    }
+
+    // give a tile grid for each thread (before map_tiles / update_tiles)
+    void prepare_grids();
+
+    // map the particles of the tiles [begin, end) to the nodes, with the
+    // tile grid of the calling thread
+    void map_tiles(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end);
+
+    // update the particles of the tiles [begin, end)
+    void update_tiles(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end, const double& dt);
+
+private:
+    // give the first element (x, y) of a tile and its size in elements
+    void tile_extent(const unsigned& tile, unsigned& x0, unsigned& y0, unsigned& nx, unsigned& ny) const;
+
+    // give the ids of the nodes of a particle in the grid of its tile
+    NodeIds tile_node_ids(const mpm::Particle* particle, const unsigned& x0, const unsigned& y0) const;
+
+    // give the id in the mesh of node (ix, iy) of a tile
+    unsigned mesh_node_id(const unsigned& x0, const unsigned& y0, const unsigned& ix, const unsigned& iy) const {
+        return (x0 + ix) + (y0 + iy) * (elementsX_ + 1);
+    }
+
+    // give the id in the tile grid of node (ix, iy)
+    unsigned tile_node_id(const unsigned& ix, const unsigned& iy) const {
+        return ix + iy * (tileSize_ + 1);
+    }
+
+    // map the particles of a tile to "grid" and add it to the mesh
+    void map_tile(mpm::MpmParticle* particles, const unsigned& tile, mpm::NodeData& grid);
+
+    // update the particles of a tile from the nodes copied to "grid"
+    void update_tile(mpm::MpmParticle* particles, const unsigned& tile, mpm::NodeData& grid, const double& dt);
+
+    // give the tile grid of the calling thread
+    mpm::NodeData& thread_grid() {
+#ifdef _OPENMP
+        return grids_[omp_get_thread_num()];
+#else
+        return grids_[0];
+#endif
+    }
+
+protected:
+    mpm::Mesh* mesh_;
+    unsigned tileSize_;
+    // elements of the mesh and tiles in each direction
+    unsigned elementsX_, elementsY_;
+    unsigned tilesX_, tilesY_;
+    // particles of tile t are tileParticles_[tileOffsets_[t] .. tileOffsets_[t+1])
+    std::vector<unsigned> tileOffsets_;
+    std::vector<unsigned> tileParticles_;
+    // grid of the tile nodes of each thread
+    std::vector<mpm::NodeData> grids_;
+};
+
+#include "TiledTransfer.ipp"
+
+#endif
@@ -0,0 +1,190 @@
+
+mpm::TiledTransfer::TiledTransfer(mpm::Mesh* mesh, const unsigned& tileSize) {
+    mesh_ = mesh;
+    tileSize_ = tileSize;
+    elementsX_ = mesh->topology().numElements(0);
+    elementsY_ = mesh->topology().numElements(1);
+    tilesX_ = 0;
+    tilesY_ = 0;
+    if (tileSize_ > 0) {
+        tilesX_ = (elementsX_ + tileSize_ - 1) / tileSize_;
+        tilesY_ = (elementsY_ + tileSize_ - 1) / tileSize_;
+    }
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: BIN_PARTICLES
+          Counting sort of the particle indices by tile. The sort is
+          stable, so the sums at the nodes inside a tile are done in the
+          same order as without tiles.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::TiledTransfer::bin_particles(mpm::MpmParticle* particles) {
+    const unsigned numTiles = tilesX_ * tilesY_;
+    const unsigned numParticles = particles->number_of_particles();
+    std::vector<unsigned> tileOfParticle(numParticles);
+    tileOffsets_.assign(numTiles + 1, 0);
+    for (unsigned i = 0; i < numParticles; i++) {
+        const unsigned element = particles->pointer_to_particle(i)->give_element();
+        const unsigned ex = element % elementsX_;
+        const unsigned ey = element / elementsX_;
+        tileOfParticle[i] = (ex / tileSize_) + (ey / tileSize_) * tilesX_;
+        tileOffsets_[tileOfParticle[i] + 1]++;
+    }
+    for (unsigned t = 0; t < numTiles; t++)
+        tileOffsets_[t + 1] += tileOffsets_[t];
+
+    tileParticles_.resize(numParticles);
+    std::vector<unsigned> next(tileOffsets_.begin(), tileOffsets_.end() - 1);
+    for (unsigned i = 0; i < numParticles; i++)
+        tileParticles_[next[tileOfParticle[i]]++] = i;
+}
+
+
+void mpm::TiledTransfer::map_particles_to_nodes(mpm::MpmParticle* particles) {
+    this->prepare_grids();
+    const unsigned numTiles = tilesX_ * tilesY_;
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(dynamic)
+        for (unsigned t = 0; t < numTiles; t++)
+            this->map_tile(particles, t, grids_[omp_get_thread_num()]);
+        return;
+    }
+#endif
+    for (unsigned t = 0; t < numTiles; t++)
+        this->map_tile(particles, t, grids_[0]);
+}
+
+
+void mpm::TiledTransfer::update_particles(mpm::MpmParticle* particles, const double& dt) {
+    this->prepare_grids();
+    const unsigned numTiles = tilesX_ * tilesY_;
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1) {
+#pragma omp parallel for schedule(dynamic)
+        for (unsigned t = 0; t < numTiles; t++)
+            this->update_tile(particles, t, grids_[omp_get_thread_num()], dt);
+        return;
+    }
+#endif
+    for (unsigned t = 0; t < numTiles; t++)
+        this->update_tile(particles, t, grids_[0], dt);
+}
+
+
+void mpm::TiledTransfer::map_tiles(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end) {
+    mpm::NodeData& grid = this->thread_grid();
+    for (unsigned t = begin; t < end; t++)
+        this->map_tile(particles, t, grid);
+}
+
+
+void mpm::TiledTransfer::update_tiles(mpm::MpmParticle* particles, const unsigned& begin, const unsigned& end, const double& dt) {
+    mpm::NodeData& grid = this->thread_grid();
+    for (unsigned t = begin; t < end; t++)
+        this->update_tile(particles, t, grid, dt);
+}
+
+
+void mpm::TiledTransfer::tile_extent(const unsigned& tile, unsigned& x0, unsigned& y0, unsigned& nx, unsigned& ny) const {
+    x0 = (tile % tilesX_) * tileSize_;
+    y0 = (tile / tilesX_) * tileSize_;
+    nx = std::min(tileSize_, elementsX_ - x0);
+    ny = std::min(tileSize_, elementsY_ - y0);
+}
+
+
+mpm::TiledTransfer::NodeIds mpm::TiledTransfer::tile_node_ids(const mpm::Particle* particle, const unsigned& x0, const unsigned& y0) const {
+    const unsigned element = particle->give_element();
+    const unsigned first = this->tile_node_id(element % elementsX_ - x0, element / elementsX_ - y0);
+    const unsigned row = tileSize_ + 1;
+    NodeIds nodes = {{first, first + 1, first + row + 1, first + row}};
+    return nodes;
+}
+
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+FUNCTION: MAP_TILE
+          All fields of the tile nodes are added to the mesh, also where
+          the mass is zero (the internal force of a particle is not zero
+          at a node of zero shape function gradient). A node on the border
+          of two tiles gets the sum of each tile, so its value differs by
+          round-off from the value without tiles.
+~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+void mpm::TiledTransfer::map_tile(mpm::MpmParticle* particles, const unsigned& tile, mpm::NodeData& grid) {
+    const unsigned begin = tileOffsets_[tile];
+    const unsigned end = tileOffsets_[tile + 1];
+    if (begin == end)
+        return;
+    unsigned x0, y0, nx, ny;
+    this->tile_extent(tile, x0, y0, nx, ny);
+
+    grid.initialise();
+    for (unsigned i = begin; i < end; i++) {
+        mpm::Particle* particle = particles->pointer_to_particle(tileParticles_[i]);
+        const NodeIds nodes = this->tile_node_ids(particle, x0, y0);
+        particle->map_mass_to_grid(grid, nodes);
+        particle->map_momentum_to_grid(grid, nodes);
+        particle->assign_body_force_to_grid(grid, nodes);
+        particle->assign_internal_force_to_grid(grid, nodes);
+    }
+
+    mpm::NodeData& meshData = mesh_->node_data_;
+    for (unsigned iy = 0; iy <= ny; iy++) {
+        for (unsigned ix = 0; ix <= nx; ix++) {
+            const unsigned local = this->tile_node_id(ix, iy);
+            const unsigned node = this->mesh_node_id(x0, y0, ix, iy);
+            meshData.add(meshData.mass[node], grid.mass[local]);
+            for (unsigned d = 0; d < dim; d++) {
+                meshData.add(meshData.momentum[d][node], grid.momentum[d][local]);
+                meshData.add(meshData.extForce[d][node], grid.extForce[d][local]);
+                meshData.add(meshData.intForce[d][node], grid.intForce[d][local]);
+            }
+        }
+    }
+}
+
+
+void mpm::TiledTransfer::update_tile(mpm::MpmParticle* particles, const unsigned& tile, mpm::NodeData& grid, const double& dt) {
+    const unsigned begin = tileOffsets_[tile];
+    const unsigned end = tileOffsets_[tile + 1];
+    if (begin == end)
+        return;
+    unsigned x0, y0, nx, ny;
+    this->tile_extent(tile, x0, y0, nx, ny);
+
+    const mpm::NodeData& meshData = mesh_->node_data_;
+    for (unsigned iy = 0; iy <= ny; iy++) {
+        for (unsigned ix = 0; ix <= nx; ix++) {
+            const unsigned local = this->tile_node_id(ix, iy);
+            const unsigned node = this->mesh_node_id(x0, y0, ix, iy);
+            for (unsigned d = 0; d < dim; d++) {
+                grid.velocity[d][local] = meshData.velocity[d][node];
+                grid.acceleration[d][local] = meshData.acceleration[d][node];
+            }
+        }
+    }
+
+    for (unsigned i = begin; i < end; i++) {
+        mpm::Particle* particle = particles->pointer_to_particle(tileParticles_[i]);
+        const NodeIds nodes = this->tile_node_ids(particle, x0, y0);
+        particle->update_velocity_from_grid(grid, nodes, dt);
+        particle->update_position_from_grid(grid, nodes, dt);
+    }
+}
+
+
+void mpm::TiledTransfer::prepare_grids() {
+    unsigned numThreads = 1;
+#ifdef _OPENMP
+    numThreads = omp_get_max_threads();
+#endif
+    const unsigned numTileNodes = (tileSize_ + 1) * (tileSize_ + 1);
+    if (grids_.size() < numThreads)
+        grids_.resize(numThreads, mpm::NodeData(false));
+    for (auto& grid : grids_) {
+        if (grid.size() != numTileNodes)
+            grid.resize(numTileNodes);
+    }
+}